@@ -0,0 +1,239 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "binary_reader.h"
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+bool BinaryReader::useMmap = false;
+
+BinaryReader::BinaryReader()
+{
+	buffer = NULL;
+	mapping = NULL;
+	mappingLength = 0;
+	inMemory = false;
+	data = NULL;
+	bufferStart = 0;
+	bufferFill = 0;
+	bufferPos = 0;
+	totalLength = 0;
+	error = errorNotOpen;
+}
+
+BinaryReader::~BinaryReader()
+{
+	close();
+}
+
+void BinaryReader::setUseMmap(bool m)
+{
+	useMmap = m;
+}
+
+bool BinaryReader::open(const char* filename)
+{
+	close();
+	error = errorNone;
+	// find the length, if there is one
+	struct stat st;
+	bool regular = strcmp(filename,"-") && !stat(filename,&st) && S_ISREG(st.st_mode);
+	totalLength = regular ? st.st_size : std::numeric_limits<dsf2flac_uint64>::max();
+	// try to map the whole file
+	if (useMmap && regular && st.st_size > 0) {
+		int fd = ::open(filename,O_RDONLY);
+		if (fd >= 0) {
+			void* m = mmap(NULL,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+			::close(fd);
+			if (m != MAP_FAILED) {
+				madvise(m,st.st_size,MADV_SEQUENTIAL);
+				mapping = m;
+				mappingLength = st.st_size;
+				inMemory = true;
+				data = static_cast<const dsf2flac_uint8*>(m);
+				bufferFill = mappingLength;
+				return false;
+			}
+		}
+	}
+	// otherwise read it through the buffer
+	stream.open(filename,fstreamPlus::in | fstreamPlus::binary);
+	if (!stream.is_open()) {
+		error = errorNotOpen;
+		return true;
+	}
+	buffer = new dsf2flac_uint8[putbackLength + bufferLength];
+	data = buffer;
+	return false;
+}
+
+bool BinaryReader::openMemory(const char* d, dsf2flac_uint64 length)
+{
+	close();
+	error = errorNone;
+	inMemory = true;
+	data = reinterpret_cast<const dsf2flac_uint8*>(d);
+	bufferFill = length;
+	totalLength = length;
+	return false;
+}
+
+void BinaryReader::close()
+{
+	if (mapping)
+		munmap(mapping,mappingLength);
+	mapping = NULL;
+	mappingLength = 0;
+	stream.close();
+	delete[] buffer;
+	buffer = NULL;
+	inMemory = false;
+	data = NULL;
+	bufferStart = 0;
+	bufferFill = 0;
+	bufferPos = 0;
+	totalLength = 0;
+	error = errorNotOpen;
+}
+
+bool BinaryReader::seekg(dsf2flac_uint64 pos)
+{
+	if (error != errorNone)
+		return true;
+	// anywhere in the buffer (which is the whole file when it is in memory)
+	if (pos >= bufferStart && pos <= bufferStart + bufferFill) {
+		bufferPos = pos - bufferStart;
+		return false;
+	}
+	if (inMemory) {
+		error = errorSeek;
+		return true;
+	}
+	// otherwise the stream has to move
+	std::streambuf* sb = stream.getBuffer();
+	if (sb->pubseekpos(pos,std::ios_base::in) == std::streampos(std::streamoff(-1))) {
+		error = errorSeek;
+		return true;
+	}
+	bufferStart = pos;
+	bufferFill = 0;
+	bufferPos = 0;
+	return false;
+}
+
+bool BinaryReader::seekg(dsf2flac_int64 off, std::ios_base::seekdir way)
+{
+	if (way == std::ios_base::cur)
+		return seekg((dsf2flac_uint64)(tellg() + off));
+	if (way == std::ios_base::end) {
+		if (totalLength == std::numeric_limits<dsf2flac_uint64>::max()) {
+			error = errorSeek;
+			return true;
+		}
+		return seekg((dsf2flac_uint64)(totalLength + off));
+	}
+	return seekg((dsf2flac_uint64)off);
+}
+
+bool BinaryReader::fill()
+{
+	// keep the tail of what we have, readers often seek back to the start of the chunk header they just read
+	dsf2flac_uint64 keep = bufferFill < putbackLength ? bufferFill : putbackLength;
+	memmove(buffer,&buffer[bufferFill-keep],keep);
+	bufferStart += bufferFill - keep;
+	bufferPos -= bufferFill - keep;
+	bufferFill = keep;
+	std::streamsize n = stream.getBuffer()->sgetn(reinterpret_cast<char*>(&buffer[keep]),bufferLength);
+	if (n <= 0)
+		return false;
+	bufferFill += n;
+	return true;
+}
+
+void BinaryReader::setShortReadError()
+{
+	// running out before the known end of the file means the file couldn't be read
+	if (totalLength != std::numeric_limits<dsf2flac_uint64>::max() && tellg() < totalLength)
+		error = errorRead;
+	else
+		error = errorEndOfData;
+}
+
+bool BinaryReader::readSlow(dsf2flac_uint8* b, dsf2flac_uint64 n)
+{
+	if (error != errorNone)
+		return true;
+	while (n > 0) {
+		// take what is in the buffer
+		dsf2flac_uint64 avail = bufferFill - bufferPos;
+		if (avail > n)
+			avail = n;
+		memcpy(b,&data[bufferPos],avail);
+		bufferPos += avail;
+		b += avail;
+		n -= avail;
+		if (n == 0)
+			break;
+		if (inMemory) {
+			error = errorEndOfData;
+			return true;
+		}
+		// big reads go straight from the stream into b
+		if (n >= bufferLength) {
+			dsf2flac_uint64 pos = tellg();
+			std::streamsize got = stream.getBuffer()->sgetn(reinterpret_cast<char*>(b),n);
+			if (got < 0)
+				got = 0;
+			bufferStart = pos + got;
+			bufferFill = 0;
+			bufferPos = 0;
+			if ((dsf2flac_uint64)got < n) {
+				setShortReadError();
+				return true;
+			}
+			return false;
+		}
+		if (!fill()) {
+			setShortReadError();
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,171 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * binary_reader.h
+  *
+  * Header file for the class BinaryReader.
+  *
+  * A buffered, bounds checked reader for the binary fields of dsf and dsdiff files.
+  *
+  */
+
+#ifndef BINARYREADER_H
+#define BINARYREADER_H
+
+#include <cstring>
+#include <ios>
+#include "dsf2flac_types.h"
+#include "fstream_plus.h"
+
+/**
+ * The BinaryReader reads the headers, chunks and sample data of a file through one large buffer.
+ *
+ * The data comes from one of three places:
+ * - a file (or stdin), read through an fstreamPlus (so read ahead still applies) in blocks of bufferLength bytes.
+ * - a memory mapping of the whole file, if setUseMmap(true) was called before open().
+ * - memory given to openMemory().
+ * In the last two cases the "buffer" is the whole file, so no data is copied until it is read and
+ * seeks are free.
+ *
+ * Most fields are a few bytes, so reads are a bounds check and a memcpy from the buffer; the
+ * big endian fields of dsdiff are swapped with bswap. As with fstreamPlus all of the read and seek
+ * methods return true on error. The reason is kept in getError() until clear() is called, and
+ * nothing can be read while it is set.
+ */
+class BinaryReader
+{
+public:
+	/// The reason the last read or seek failed.
+	enum Error {
+		errorNone = 0,
+		errorNotOpen, // nothing has been opened
+		errorEndOfData, // a read went past the end of the data
+		errorSeek, // the position could not be reached
+		errorRead // the file could not be read
+	};
+public:
+	BinaryReader();
+	virtual ~BinaryReader();
+
+	/// Opens a file, the filename "-" reads stdin. Returns true on error.
+	bool open(const char* filename);
+	/// Reads length bytes of memory owned by the caller, the memory must outlive the reader. Returns true on error.
+	bool openMemory(const char* data, dsf2flac_uint64 length);
+	void close();
+	bool is_open() { return inMemory || stream.is_open(); };
+	/// Returns false for streams that can't seek backwards freely (stdin).
+	bool isSeekable() { return inMemory || stream.isSeekable(); };
+	/// Files opened after this call are memory mapped rather than read (if the mapping works).
+	static void setUseMmap(bool useMmap);
+
+	/** Seeking, returns true on error **/
+	bool seekg(dsf2flac_uint64 pos);
+	bool seekg(dsf2flac_int64 off, std::ios_base::seekdir way);
+	dsf2flac_uint64 tellg() { return bufferStart + bufferPos; };
+
+	/** Errors **/
+	Error getError() { return error; };
+	/// True once a read has gone past the end of the data.
+	bool eof() { return error == errorEndOfData; };
+	/// Clears the error so that reading can continue.
+	void clear() { error = errorNone; };
+	/// Returns false if the data is known to end before n more bytes. Use before allocating space for a field.
+	bool canRead(dsf2flac_uint64 n) { dsf2flac_uint64 pos = tellg(); return pos <= totalLength && n <= totalLength - pos; };
+
+	/** Read methods - native byte order **/
+	// All return true on error. All read "n" numbers (not n chars/bytes!)
+	bool read_int8 		(dsf2flac_int8*     b,	stream_size n) { return read_bytes(b,n); };
+	bool read_uint8		(dsf2flac_uint8*	b,	stream_size n) { return read_bytes(b,n); };
+	bool read_uint16	(dsf2flac_uint16*	b,	stream_size n) { return read_bytes(b,2*n); };
+	bool read_uint32	(dsf2flac_uint32*	b,	stream_size n) { return read_bytes(b,4*n); };
+	bool read_uint64	(dsf2flac_uint64*	b,	stream_size n) { return read_bytes(b,8*n); };
+
+	/** Read methods - reverse byte order **/
+	// All return true on error. All read "n" numbers (not n chars/bytes!)
+	bool read_int8_rev 	(dsf2flac_int8*     b,stream_size n) { return read_int8 (b,n); };
+	bool read_int32_rev	(dsf2flac_int32*   b,stream_size n) { return read_helper_rev(b,n); };
+	bool read_uint8_rev	(dsf2flac_uint8*	b,stream_size n) { return read_uint8(b,n); };
+	bool read_uint16_rev(dsf2flac_uint16*   b,stream_size n) { return read_helper_rev(b,n); };
+	bool read_uint32_rev(dsf2flac_uint32*   b,stream_size n) { return read_helper_rev(b,n); };
+	bool read_uint64_rev(dsf2flac_uint64*	b,stream_size n) { return read_helper_rev(b,n); };
+
+	/** Byte swapping **/
+	static dsf2flac_uint16 reverseByteOrder(dsf2flac_uint16 b) { return __builtin_bswap16(b); };
+	static dsf2flac_uint32 reverseByteOrder(dsf2flac_uint32 b) { return __builtin_bswap32(b); };
+	static dsf2flac_int32 reverseByteOrder(dsf2flac_int32 b) { return __builtin_bswap32(b); };
+	static dsf2flac_uint64 reverseByteOrder(dsf2flac_uint64 b) { return __builtin_bswap64(b); };
+private:
+	/// Copies n bytes to b, the fast path is inline and everything else is in readSlow.
+	bool read_bytes(void* b, dsf2flac_uint64 n) {
+		if (error == errorNone && n <= bufferFill - bufferPos) {
+			memcpy(b,&data[bufferPos],n);
+			bufferPos += n;
+			return false;
+		}
+		return readSlow(static_cast<dsf2flac_uint8*>(b),n);
+	};
+	bool readSlow(dsf2flac_uint8* b, dsf2flac_uint64 n);
+	/// Sets the error after the stream ran out during a read.
+	void setShortReadError();
+	/// Reads the next block from the stream into the buffer, keeping the tail of the last one for short seeks back.
+	bool fill();
+	template<typename rType> bool read_helper_rev(rType* b, stream_size n) {
+		if (read_bytes(b,sizeof(rType)*n))
+			return true;
+		for (stream_size i=0; i<n; i++)
+			b[i] = reverseByteOrder(b[i]);
+		return false;
+	};
+private:
+	static const dsf2flac_uint32 bufferLength = 64*1024;
+	static const dsf2flac_uint32 putbackLength = 4096;
+	static bool useMmap;
+	fstreamPlus stream; // the source unless the data is in memory
+	dsf2flac_uint8* buffer; // putbackLength + bufferLength bytes for reading the stream
+	void* mapping; // the memory mapped file or NULL
+	dsf2flac_uint64 mappingLength;
+	bool inMemory; // data is the whole file (mapped or given to openMemory)
+	const dsf2flac_uint8* data; // buffer, or the whole file
+	dsf2flac_uint64 bufferStart; // file position of data[0]
+	dsf2flac_uint64 bufferFill; // number of valid bytes at data
+	dsf2flac_uint64 bufferPos; // read position in data
+	dsf2flac_uint64 totalLength; // length of the file if known
+	Error error;
+};
+
+#endif // BINARYREADER_H
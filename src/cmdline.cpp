@@ -36,14 +36,28 @@ const char *gengetopt_args_info_description = "";
 const char *gengetopt_args_info_help[] = {
   "  -h, --help              Print help and exit",
   "  -V, --version           Print version and exit",
-  "  -r, --samplerate=Hz     Output sample rate  (possible values=\"88200\",\n                            \"176400\", \"352800\" default=`88200')",
+  "  -r, --samplerate=Hz     Output sample rate. 11025, 22050 and 44100 need -a or\n                            -c  (possible values=\"11025\", \"22050\",\n                            \"44100\", \"88200\", \"176400\", \"352800\"\n                            default=`88200')",
   "  -b, --bits=bits         Output bitdepth  (possible values=\"16\", \"20\",\n                            \"24\" default=`24')",
   "  -n, --nodither          Don't add dither before quantization  (default=off)",
   "  -1, --onefile           Don't split into tracks  (default=off)",
   "  -s, --scale=dB          Scale adjustment. Raw DSD has a modulation depth of\n                            approximately 0.5 so with no scaling the PCM peak\n                            level is approximately -6dB below 0dBFs\n                            (default=`4')",
-  "  -i, --infile=filepath   Input DSF or DFF file",
-  "  -o, --outfile=filepath  Output FLAC file, if not specified the output file be\n                            the same as the input file with the extension\n                            changed",
+  "  -i, --infile=filepath   Input DSF or DFF file (- for stdin), or a directory\n                            to convert all of the DSF and DFF files in it",
+  "  -o, --outfile=filepath  Output FLAC file (or directory when the input is a\n                            directory), if not specified the output file be the\n                            same as the input file with the extension changed",
   "  -d, --dop               Encode DSD data directly into FLAC file without\n                            conversion to PCM using DoP format (DSD over PCM)\n                            (default=off)",
+  "  -m, --outputs=specs     Convert into several PCM outputs in one pass, reading\n                            (and DST decoding) the input only once. A comma\n                            separated list of rate[:bits[:nodither]] specs,\n                            e.g. 88200:24,176400:24. Replaces -r, while -b and\n                            -n give the bits and dither of the specs which\n                            leave them out",
+  "  -a, --approximate       Fast approximate conversion for previews. Decimates\n                            by counting the bits in each block of DSD samples\n                            instead of using the FIR filters, so the output has\n                            lots of aliased noise. Also allows the 11025, 22050\n                            and 44100 sample rates  (default=off)",
+  "  -c, --cic               Use a CIC filter followed by a short compensating FIR\n                            instead of the lookup table FIR. Much less work per\n                            sample at high decimation ratios (e.g. DSD256\n                            input). Also allows the 22050 and 44100 sample\n                            rates (default=off)",
+  "  -L, --lanes=files       Number of files which are converted together when the\n                            input file is a directory  (default=`8')",
+  "  -R, --readahead=MiB     MiB of the input file to read ahead in a background\n                            thread, 0 to read synchronously  (default=`4')",
+  "  -I, --io-stats          Print read ahead statistics (how often the conversion\n                            waited for the disk) and how often the DST decoder\n                            could reuse its filter tables at the end\n                            (default=off)",
+  "  -M, --memory            Load the whole input file into memory before\n                            converting, so that no file I/O is done during the\n                            conversion  (default=off)",
+  "  -P, --probe             Print the format, length, tracks and tags of the\n                            input file (or of each file in the input directory)\n                            as JSON instead of converting  (default=off)",
+  "  -x, --mmap              Memory map the input files instead of reading them\n                            (read ahead is then left to the operating system)\n                            (default=off)",
+  "  -t, --track=number      Convert only this track (numbered from 1), seeking\n                            straight to it",
+  "  -X, --index-cache       Keep the frame index which is made for seeking in a\n                            DST file without a DSTI chunk in a sidecar file\n                            (<file>.dstidx), so that later runs don't have to\n                            scan the file again  (default=off)",
+  "  -v, --verify            Check each DST frame against the CRC in the DSTC\n                            chunk which follows it (where the file has them),\n                            and fail if any frame doesn't match or can't be\n                            decoded (default=off)",
+  "  -D, --dst               Losslessly compress the DSD data into a DST coded DFF\n                            file (DSD64 with up to 6 channels) instead of\n                            converting it. It is one file holding all of the\n                            tracks and their markers, or only the -t track. DST\n                            frames are all 1/75 second long, so the last one is\n                            padded with silence. The output file is the input\n                            file with the extension changed to .dff if not\n                            specified. Uses -L threads (all of the cores by\n                            default) (default=off)",
+  "  -O, --dsd=format        Copy the DSD data into a DSF or DFF file without\n                            converting it (DST is decoded, see -D for DST\n                            output), split into tracks like the PCM output (see\n                            -1 and -t). The output file is the input file with\n                            the extension changed if not specified  (possible\n                            values=\"dsf\", \"dff\")",
     0
 };
 
@@ -66,8 +80,9 @@ cmdline_parser_internal (int argc, char **argv, struct gengetopt_args_info *args
 static int
 cmdline_parser_required2 (struct gengetopt_args_info *args_info, const char *prog_name, const char *additional_error);
 
-const char *cmdline_parser_samplerate_values[] = {"88200", "176400", "352800", 0}; /*< Possible values for samplerate. */
+const char *cmdline_parser_samplerate_values[] = {"11025", "22050", "44100", "88200", "176400", "352800", 0}; /*< Possible values for samplerate. */
 const char *cmdline_parser_bits_values[] = {"16", "20", "24", 0}; /*< Possible values for bits. */
+const char *cmdline_parser_dsd_values[] = {"dsf", "dff", 0}; /*< Possible values for dsd. */
 
 static char *
 gengetopt_strdup (const char *s);
@@ -85,6 +100,20 @@ void clear_given (struct gengetopt_args_info *args_info)
   args_info->infile_given = 0 ;
   args_info->outfile_given = 0 ;
   args_info->dop_given = 0 ;
+  args_info->outputs_given = 0 ;
+  args_info->approximate_given = 0 ;
+  args_info->cic_given = 0 ;
+  args_info->lanes_given = 0 ;
+  args_info->readahead_given = 0 ;
+  args_info->io_stats_given = 0 ;
+  args_info->memory_given = 0 ;
+  args_info->probe_given = 0 ;
+  args_info->mmap_given = 0 ;
+  args_info->track_given = 0 ;
+  args_info->index_cache_given = 0 ;
+  args_info->verify_given = 0 ;
+  args_info->dst_given = 0 ;
+  args_info->dsd_given = 0 ;
 }
 
 static
@@ -104,6 +133,25 @@ void clear_args (struct gengetopt_args_info *args_info)
   args_info->outfile_arg = NULL;
   args_info->outfile_orig = NULL;
   args_info->dop_flag = 0;
+  args_info->outputs_arg = NULL;
+  args_info->outputs_orig = NULL;
+  args_info->approximate_flag = 0;
+  args_info->cic_flag = 0;
+  args_info->lanes_arg = 8;
+  args_info->lanes_orig = NULL;
+  args_info->readahead_arg = 4;
+  args_info->readahead_orig = NULL;
+  args_info->io_stats_flag = 0;
+  args_info->memory_flag = 0;
+  args_info->probe_flag = 0;
+  args_info->mmap_flag = 0;
+  args_info->track_arg = 0;
+  args_info->track_orig = NULL;
+  args_info->index_cache_flag = 0;
+  args_info->verify_flag = 0;
+  args_info->dst_flag = 0;
+  args_info->dsd_arg = NULL;
+  args_info->dsd_orig = NULL;
   
 }
 
@@ -122,6 +170,20 @@ void init_args_info(struct gengetopt_args_info *args_info)
   args_info->infile_help = gengetopt_args_info_help[7] ;
   args_info->outfile_help = gengetopt_args_info_help[8] ;
   args_info->dop_help = gengetopt_args_info_help[9] ;
+  args_info->outputs_help = gengetopt_args_info_help[10] ;
+  args_info->approximate_help = gengetopt_args_info_help[11] ;
+  args_info->cic_help = gengetopt_args_info_help[12] ;
+  args_info->lanes_help = gengetopt_args_info_help[13] ;
+  args_info->readahead_help = gengetopt_args_info_help[14] ;
+  args_info->io_stats_help = gengetopt_args_info_help[15] ;
+  args_info->memory_help = gengetopt_args_info_help[16] ;
+  args_info->probe_help = gengetopt_args_info_help[17] ;
+  args_info->mmap_help = gengetopt_args_info_help[18] ;
+  args_info->track_help = gengetopt_args_info_help[19] ;
+  args_info->index_cache_help = gengetopt_args_info_help[20] ;
+  args_info->verify_help = gengetopt_args_info_help[21] ;
+  args_info->dst_help = gengetopt_args_info_help[22] ;
+  args_info->dsd_help = gengetopt_args_info_help[23] ;
   
 }
 
@@ -212,6 +274,13 @@ cmdline_parser_release (struct gengetopt_args_info *args_info)
   free_string_field (&(args_info->infile_orig));
   free_string_field (&(args_info->outfile_arg));
   free_string_field (&(args_info->outfile_orig));
+  free_string_field (&(args_info->outputs_arg));
+  free_string_field (&(args_info->outputs_orig));
+  free_string_field (&(args_info->lanes_orig));
+  free_string_field (&(args_info->readahead_orig));
+  free_string_field (&(args_info->track_orig));
+  free_string_field (&(args_info->dsd_arg));
+  free_string_field (&(args_info->dsd_orig));
   
   
 
@@ -303,6 +372,34 @@ cmdline_parser_dump(FILE *outfile, struct gengetopt_args_info *args_info)
     write_into_file(outfile, "outfile", args_info->outfile_orig, 0);
   if (args_info->dop_given)
     write_into_file(outfile, "dop", 0, 0 );
+  if (args_info->outputs_given)
+    write_into_file(outfile, "outputs", args_info->outputs_orig, 0);
+  if (args_info->approximate_given)
+    write_into_file(outfile, "approximate", 0, 0 );
+  if (args_info->cic_given)
+    write_into_file(outfile, "cic", 0, 0 );
+  if (args_info->lanes_given)
+    write_into_file(outfile, "lanes", args_info->lanes_orig, 0);
+  if (args_info->readahead_given)
+    write_into_file(outfile, "readahead", args_info->readahead_orig, 0);
+  if (args_info->io_stats_given)
+    write_into_file(outfile, "io-stats", 0, 0 );
+  if (args_info->memory_given)
+    write_into_file(outfile, "memory", 0, 0 );
+  if (args_info->probe_given)
+    write_into_file(outfile, "probe", 0, 0 );
+  if (args_info->mmap_given)
+    write_into_file(outfile, "mmap", 0, 0 );
+  if (args_info->track_given)
+    write_into_file(outfile, "track", args_info->track_orig, 0);
+  if (args_info->index_cache_given)
+    write_into_file(outfile, "index-cache", 0, 0 );
+  if (args_info->verify_given)
+    write_into_file(outfile, "verify", 0, 0 );
+  if (args_info->dst_given)
+    write_into_file(outfile, "dst", 0, 0 );
+  if (args_info->dsd_given)
+    write_into_file(outfile, "dsd", args_info->dsd_orig, cmdline_parser_dsd_values);
   
 
   i = EXIT_SUCCESS;
@@ -610,10 +707,24 @@ cmdline_parser_internal (
         { "infile",	1, NULL, 'i' },
         { "outfile",	1, NULL, 'o' },
         { "dop",	0, NULL, 'd' },
+        { "outputs",	1, NULL, 'm' },
+        { "approximate",	0, NULL, 'a' },
+        { "cic",	0, NULL, 'c' },
+        { "lanes",	1, NULL, 'L' },
+        { "readahead",	1, NULL, 'R' },
+        { "io-stats",	0, NULL, 'I' },
+        { "memory",	0, NULL, 'M' },
+        { "probe",	0, NULL, 'P' },
+        { "mmap",	0, NULL, 'x' },
+        { "track",	1, NULL, 't' },
+        { "index-cache",	0, NULL, 'X' },
+        { "verify",	0, NULL, 'v' },
+        { "dst",	0, NULL, 'D' },
+        { "dsd",	1, NULL, 'O' },
         { 0,  0, 0, 0 }
       };
 
-      c = getopt_long (argc, argv, "hVr:b:n1s:i:o:d", long_options, &option_index);
+      c = getopt_long (argc, argv, "hVr:b:n1s:i:o:dm:acL:R:IMPxt:XvDO:", long_options, &option_index);
 
       if (c == -1) break;	/* Exit from `while (1)' loop.  */
 
@@ -629,7 +740,7 @@ cmdline_parser_internal (
           cmdline_parser_free (&local_args_info);
           exit (EXIT_SUCCESS);
 
-        case 'r':	/* Output sample rate.  */
+        case 'r':	/* Output sample rate. 11025, 22050 and 44100 need -a or -c.  */
         
         
           if (update_arg( (void *)&(args_info->samplerate_arg), 
@@ -685,7 +796,7 @@ cmdline_parser_internal (
             goto failure;
         
           break;
-        case 'i':	/* Input DSF or DFF file.  */
+        case 'i':	/* Input DSF or DFF file, or a directory to convert all of the DSF and DFF files in it.  */
         
         
           if (update_arg( (void *)&(args_info->infile_arg), 
@@ -697,7 +808,7 @@ cmdline_parser_internal (
             goto failure;
         
           break;
-        case 'o':	/* Output FLAC file, if not specified the output file be the same as the input file with the extension changed.  */
+        case 'o':	/* Output FLAC file (or directory when the input is a directory), if not specified the output file be the same as the input file with the extension changed.  */
         
         
           if (update_arg( (void *)&(args_info->outfile_arg), 
@@ -719,6 +830,156 @@ cmdline_parser_internal (
             goto failure;
         
           break;
+        case 'm':	/* Convert into several PCM outputs in one pass, reading (and DST decoding) the input only once. A comma separated list of rate[:bits[:nodither]] specs, e.g. 88200:24,176400:24. Replaces -r, while -b and -n give the bits and dither of the specs which leave them out.  */
+        
+        
+          if (update_arg( (void *)&(args_info->outputs_arg), 
+               &(args_info->outputs_orig), &(args_info->outputs_given),
+              &(local_args_info.outputs_given), optarg, 0, 0, ARG_STRING,
+              check_ambiguity, override, 0, 0,
+              "outputs", 'm',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'a':	/* Fast approximate conversion for previews. Decimates by counting the bits in each block of DSD samples instead of using the FIR filters, so the output has lots of aliased noise. Also allows the 11025, 22050 and 44100 sample rates.  */
+        
+        
+          if (update_arg((void *)&(args_info->approximate_flag), 0, &(args_info->approximate_given),
+              &(local_args_info.approximate_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "approximate", 'a',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'c':	/* Use a CIC filter followed by a short compensating FIR instead of the lookup table FIR. Much less work per sample at high decimation ratios (e.g. DSD256 input). Also allows the 22050 and 44100 sample rates.  */
+        
+        
+          if (update_arg((void *)&(args_info->cic_flag), 0, &(args_info->cic_given),
+              &(local_args_info.cic_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "cic", 'c',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'L':	/* Number of files which are converted together when the input file is a directory.  */
+        
+        
+          if (update_arg( (void *)&(args_info->lanes_arg), 
+               &(args_info->lanes_orig), &(args_info->lanes_given),
+              &(local_args_info.lanes_given), optarg, 0, "8", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "lanes", 'L',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'R':	/* MiB of the input file to read ahead in a background thread, 0 to read synchronously.  */
+        
+        
+          if (update_arg( (void *)&(args_info->readahead_arg), 
+               &(args_info->readahead_orig), &(args_info->readahead_given),
+              &(local_args_info.readahead_given), optarg, 0, "4", ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "readahead", 'R',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'I':	/* Print read ahead statistics (how often the conversion waited for the disk) and how often the DST decoder could reuse its filter tables at the end.  */
+        
+        
+          if (update_arg((void *)&(args_info->io_stats_flag), 0, &(args_info->io_stats_given),
+              &(local_args_info.io_stats_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "io-stats", 'I',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'M':	/* Load the whole input file into memory before converting, so that no file I/O is done during the conversion.  */
+        
+        
+          if (update_arg((void *)&(args_info->memory_flag), 0, &(args_info->memory_given),
+              &(local_args_info.memory_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "memory", 'M',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'P':	/* Print the format, length, tracks and tags of the input file (or of each file in the input directory) as JSON instead of converting.  */
+        
+        
+          if (update_arg((void *)&(args_info->probe_flag), 0, &(args_info->probe_given),
+              &(local_args_info.probe_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "probe", 'P',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'x':	/* Memory map the input files instead of reading them (read ahead is then left to the operating system).  */
+        
+        
+          if (update_arg((void *)&(args_info->mmap_flag), 0, &(args_info->mmap_given),
+              &(local_args_info.mmap_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "mmap", 'x',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 't':	/* Convert only this track (numbered from 1), seeking straight to it.  */
+        
+        
+          if (update_arg( (void *)&(args_info->track_arg), 
+               &(args_info->track_orig), &(args_info->track_given),
+              &(local_args_info.track_given), optarg, 0, 0, ARG_INT,
+              check_ambiguity, override, 0, 0,
+              "track", 't',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'X':	/* Keep the frame index which is made for seeking in a DST file without a DSTI chunk in a sidecar file (<file>.dstidx), so that later runs don't have to scan the file again.  */
+        
+        
+          if (update_arg((void *)&(args_info->index_cache_flag), 0, &(args_info->index_cache_given),
+              &(local_args_info.index_cache_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "index-cache", 'X',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'v':	/* Check each DST frame against the CRC in the DSTC chunk which follows it (where the file has them), and fail if any frame doesn't match or can't be decoded.  */
+        
+        
+          if (update_arg((void *)&(args_info->verify_flag), 0, &(args_info->verify_given),
+              &(local_args_info.verify_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "verify", 'v',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'D':	/* Losslessly compress the DSD data into a DST coded DFF file (DSD64 with up to 6 channels) instead of converting it. It is one file holding all of the tracks and their markers, or only the -t track. DST frames are all 1/75 second long, so the last one is padded with silence. The output file is the input file with the extension changed to .dff if not specified. Uses -L threads (all of the cores by default).  */
+        
+        
+          if (update_arg((void *)&(args_info->dst_flag), 0, &(args_info->dst_given),
+              &(local_args_info.dst_given), optarg, 0, 0, ARG_FLAG,
+              check_ambiguity, override, 1, 0, "dst", 'D',
+              additional_error))
+            goto failure;
+        
+          break;
+        case 'O':	/* Copy the DSD data into a DSF or DFF file without converting it (DST is decoded, see -D for DST output), split into tracks like the PCM output (see -1 and -t). The output file is the input file with the extension changed if not specified.  */
+        
+        
+          if (update_arg( (void *)&(args_info->dsd_arg), 
+               &(args_info->dsd_orig), &(args_info->dsd_given),
+              &(local_args_info.dsd_given), optarg, cmdline_parser_dsd_values, 0, ARG_STRING,
+              check_ambiguity, override, 0, 0,
+              "dsd", 'O',
+              additional_error))
+            goto failure;
+        
+          break;
 
         case 0:	/* Long option with no short option */
         case '?':	/* Invalid option.  */
@@ -39,9 +39,9 @@ struct gengetopt_args_info
 {
   const char *help_help; /**< @brief Print help and exit help description.  */
   const char *version_help; /**< @brief Print version and exit help description.  */
-  int samplerate_arg;	/**< @brief Output sample rate (default='88200').  */
-  char * samplerate_orig;	/**< @brief Output sample rate original value given at command line.  */
-  const char *samplerate_help; /**< @brief Output sample rate help description.  */
+  int samplerate_arg;	/**< @brief Output sample rate. 11025, 22050 and 44100 need -a or -c (default='88200').  */
+  char * samplerate_orig;	/**< @brief Output sample rate. 11025, 22050 and 44100 need -a or -c original value given at command line.  */
+  const char *samplerate_help; /**< @brief Output sample rate. 11025, 22050 and 44100 need -a or -c help description.  */
   int bits_arg;	/**< @brief Output bitdepth (default='24').  */
   char * bits_orig;	/**< @brief Output bitdepth original value given at command line.  */
   const char *bits_help; /**< @brief Output bitdepth help description.  */
@@ -52,14 +52,47 @@ struct gengetopt_args_info
   float scale_arg;	/**< @brief Scale adjustment. Raw DSD has a modulation depth of approximately 0.5 so with no scaling the PCM peak level is approximately -6dB below 0dBFs (default='4').  */
   char * scale_orig;	/**< @brief Scale adjustment. Raw DSD has a modulation depth of approximately 0.5 so with no scaling the PCM peak level is approximately -6dB below 0dBFs original value given at command line.  */
   const char *scale_help; /**< @brief Scale adjustment. Raw DSD has a modulation depth of approximately 0.5 so with no scaling the PCM peak level is approximately -6dB below 0dBFs help description.  */
-  char * infile_arg;	/**< @brief Input DSF or DFF file.  */
-  char * infile_orig;	/**< @brief Input DSF or DFF file original value given at command line.  */
-  const char *infile_help; /**< @brief Input DSF or DFF file help description.  */
-  char * outfile_arg;	/**< @brief Output FLAC file, if not specified the output file be the same as the input file with the extension changed.  */
-  char * outfile_orig;	/**< @brief Output FLAC file, if not specified the output file be the same as the input file with the extension changed original value given at command line.  */
-  const char *outfile_help; /**< @brief Output FLAC file, if not specified the output file be the same as the input file with the extension changed help description.  */
+  char * infile_arg;	/**< @brief Input DSF or DFF file (- for stdin), or a directory to convert all of the DSF and DFF files in it.  */
+  char * infile_orig;	/**< @brief Input DSF or DFF file (- for stdin), or a directory to convert all of the DSF and DFF files in it original value given at command line.  */
+  const char *infile_help; /**< @brief Input DSF or DFF file (- for stdin), or a directory to convert all of the DSF and DFF files in it help description.  */
+  char * outfile_arg;	/**< @brief Output FLAC file (or directory when the input is a directory), if not specified the output file be the same as the input file with the extension changed.  */
+  char * outfile_orig;	/**< @brief Output FLAC file (or directory when the input is a directory), if not specified the output file be the same as the input file with the extension changed original value given at command line.  */
+  const char *outfile_help; /**< @brief Output FLAC file (or directory when the input is a directory), if not specified the output file be the same as the input file with the extension changed help description.  */
   int dop_flag;	/**< @brief Encode DSD data directly into FLAC file without conversion to PCM using DoP format (DSD over PCM) (default=off).  */
   const char *dop_help; /**< @brief Encode DSD data directly into FLAC file without conversion to PCM using DoP format (DSD over PCM) help description.  */
+  char * outputs_arg;	/**< @brief Convert into several PCM outputs in one pass, reading (and DST decoding) the input only once. A comma separated list of rate[:bits[:nodither]] specs, e.g. 88200:24,176400:24. Replaces -r, while -b and -n give the bits and dither of the specs which leave them out.  */
+  char * outputs_orig;	/**< @brief Convert into several PCM outputs in one pass, reading (and DST decoding) the input only once. A comma separated list of rate[:bits[:nodither]] specs, e.g. 88200:24,176400:24. Replaces -r, while -b and -n give the bits and dither of the specs which leave them out original value given at command line.  */
+  const char *outputs_help; /**< @brief Convert into several PCM outputs in one pass, reading (and DST decoding) the input only once. A comma separated list of rate[:bits[:nodither]] specs, e.g. 88200:24,176400:24. Replaces -r, while -b and -n give the bits and dither of the specs which leave them out help description.  */
+  int approximate_flag;	/**< @brief Fast approximate conversion for previews. Decimates by counting the bits in each block of DSD samples instead of using the FIR filters, so the output has lots of aliased noise. Also allows the 11025, 22050 and 44100 sample rates (default=off).  */
+  const char *approximate_help; /**< @brief Fast approximate conversion for previews. Decimates by counting the bits in each block of DSD samples instead of using the FIR filters, so the output has lots of aliased noise. Also allows the 11025, 22050 and 44100 sample rates help description.  */
+  int cic_flag;	/**< @brief Use a CIC filter followed by a short compensating FIR instead of the lookup table FIR. Much less work per sample at high decimation ratios (e.g. DSD256 input). Also allows the 22050 and 44100 sample rates (default=off).  */
+  const char *cic_help; /**< @brief Use a CIC filter followed by a short compensating FIR instead of the lookup table FIR. Much less work per sample at high decimation ratios (e.g. DSD256 input). Also allows the 22050 and 44100 sample rates help description.  */
+  int lanes_arg;	/**< @brief Number of files which are converted together when the input file is a directory (default='8').  */
+  char * lanes_orig;	/**< @brief Number of files which are converted together when the input file is a directory original value given at command line.  */
+  const char *lanes_help; /**< @brief Number of files which are converted together when the input file is a directory help description.  */
+  int readahead_arg;	/**< @brief MiB of the input file to read ahead in a background thread, 0 to read synchronously (default='4').  */
+  char * readahead_orig;	/**< @brief MiB of the input file to read ahead in a background thread, 0 to read synchronously original value given at command line.  */
+  const char *readahead_help; /**< @brief MiB of the input file to read ahead in a background thread, 0 to read synchronously help description.  */
+  int io_stats_flag;	/**< @brief Print read ahead statistics (how often the conversion waited for the disk) and how often the DST decoder could reuse its filter tables at the end (default=off).  */
+  const char *io_stats_help; /**< @brief Print read ahead statistics (how often the conversion waited for the disk) and how often the DST decoder could reuse its filter tables at the end help description.  */
+  int memory_flag;	/**< @brief Load the whole input file into memory before converting, so that no file I/O is done during the conversion (default=off).  */
+  const char *memory_help; /**< @brief Load the whole input file into memory before converting, so that no file I/O is done during the conversion help description.  */
+  int probe_flag;	/**< @brief Print the format, length, tracks and tags of the input file (or of each file in the input directory) as JSON instead of converting (default=off).  */
+  const char *probe_help; /**< @brief Print the format, length, tracks and tags of the input file (or of each file in the input directory) as JSON instead of converting help description.  */
+  int mmap_flag;	/**< @brief Memory map the input files instead of reading them (read ahead is then left to the operating system) (default=off).  */
+  const char *mmap_help; /**< @brief Memory map the input files instead of reading them (read ahead is then left to the operating system) help description.  */
+  int track_arg;	/**< @brief Convert only this track (numbered from 1), seeking straight to it.  */
+  char * track_orig;	/**< @brief Convert only this track (numbered from 1), seeking straight to it original value given at command line.  */
+  const char *track_help; /**< @brief Convert only this track (numbered from 1), seeking straight to it help description.  */
+  int index_cache_flag;	/**< @brief Keep the frame index which is made for seeking in a DST file without a DSTI chunk in a sidecar file (<file>.dstidx), so that later runs don't have to scan the file again (default=off).  */
+  const char *index_cache_help; /**< @brief Keep the frame index which is made for seeking in a DST file without a DSTI chunk in a sidecar file (<file>.dstidx), so that later runs don't have to scan the file again help description.  */
+  int verify_flag;	/**< @brief Check each DST frame against the CRC in the DSTC chunk which follows it (where the file has them), and fail if any frame doesn't match or can't be decoded (default=off).  */
+  const char *verify_help; /**< @brief Check each DST frame against the CRC in the DSTC chunk which follows it (where the file has them), and fail if any frame doesn't match or can't be decoded help description.  */
+  int dst_flag;	/**< @brief Losslessly compress the DSD data into a DST coded DFF file (DSD64 with up to 6 channels) instead of converting it. It is one file holding all of the tracks and their markers, or only the -t track. DST frames are all 1/75 second long, so the last one is padded with silence. The output file is the input file with the extension changed to .dff if not specified. Uses -L threads (all of the cores by default) (default=off).  */
+  const char *dst_help; /**< @brief Losslessly compress the DSD data into a DST coded DFF file (DSD64 with up to 6 channels) instead of converting it. It is one file holding all of the tracks and their markers, or only the -t track. DST frames are all 1/75 second long, so the last one is padded with silence. The output file is the input file with the extension changed to .dff if not specified. Uses -L threads (all of the cores by default) help description.  */
+  char * dsd_arg;	/**< @brief Copy the DSD data into a DSF or DFF file without converting it (DST is decoded, see -D for DST output). The output file is the input file with the extension changed if not specified.  */
+  char * dsd_orig;	/**< @brief Copy the DSD data into a DSF or DFF file without converting it (DST is decoded, see -D for DST output). The output file is the input file with the extension changed if not specified original value given at command line.  */
+  const char *dsd_help; /**< @brief Copy the DSD data into a DSF or DFF file without converting it (DST is decoded, see -D for DST output). The output file is the input file with the extension changed if not specified help description.  */
   
   unsigned int help_given ;	/**< @brief Whether help was given.  */
   unsigned int version_given ;	/**< @brief Whether version was given.  */
@@ -71,6 +104,20 @@ struct gengetopt_args_info
   unsigned int infile_given ;	/**< @brief Whether infile was given.  */
   unsigned int outfile_given ;	/**< @brief Whether outfile was given.  */
   unsigned int dop_given ;	/**< @brief Whether dop was given.  */
+  unsigned int outputs_given ;	/**< @brief Whether outputs was given.  */
+  unsigned int approximate_given ;	/**< @brief Whether approximate was given.  */
+  unsigned int cic_given ;	/**< @brief Whether cic was given.  */
+  unsigned int lanes_given ;	/**< @brief Whether lanes was given.  */
+  unsigned int readahead_given ;	/**< @brief Whether readahead was given.  */
+  unsigned int io_stats_given ;	/**< @brief Whether io-stats was given.  */
+  unsigned int memory_given ;	/**< @brief Whether memory was given.  */
+  unsigned int probe_given ;	/**< @brief Whether probe was given.  */
+  unsigned int mmap_given ;	/**< @brief Whether mmap was given.  */
+  unsigned int track_given ;	/**< @brief Whether track was given.  */
+  unsigned int index_cache_given ;	/**< @brief Whether index-cache was given.  */
+  unsigned int verify_given ;	/**< @brief Whether verify was given.  */
+  unsigned int dst_given ;	/**< @brief Whether dst was given.  */
+  unsigned int dsd_given ;	/**< @brief Whether dsd was given.  */
 
 } ;
 
@@ -197,6 +244,7 @@ int cmdline_parser_required (struct gengetopt_args_info *args_info,
 
 extern const char *cmdline_parser_samplerate_values[];  /**< @brief Possible values for samplerate. */
 extern const char *cmdline_parser_bits_values[];  /**< @brief Possible values for bits. */
+extern const char *cmdline_parser_dsd_values[];  /**< @brief Possible values for dsd. */
 
 
 #ifdef __cplusplus
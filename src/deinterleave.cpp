@@ -0,0 +1,153 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "deinterleave.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DEINTERLEAVE_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#endif
+
+/// Plain version, also finishes off the frames left over by the vector versions.
+static void deinterleave_scalar(const dsf2flac_uint8* in, dsf2flac_uint8* out, dsf2flac_uint32 nChannels, dsf2flac_uint32 nFrames, dsf2flac_uint32 first)
+{
+	for (dsf2flac_uint32 c=0; c<nChannels; c++) {
+		dsf2flac_uint8* o = &out[c*nFrames];
+		for (dsf2flac_uint32 i=first; i<nFrames; i++)
+			o[i] = in[i*nChannels+c];
+	}
+}
+
+#ifdef DEINTERLEAVE_X86
+
+/// Stereo: the even bytes are the left channel and the odd bytes the right, so mask/shift and pack (SSE2).
+static dsf2flac_uint32 deinterleave_2_sse2(const dsf2flac_uint8* in, dsf2flac_uint8* out, dsf2flac_uint32 nFrames)
+{
+	const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+	dsf2flac_uint32 i = 0;
+	for (; i+16<=nFrames; i+=16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)&in[2*i]);
+		__m128i b = _mm_loadu_si128((const __m128i*)&in[2*i+16]);
+		__m128i l = _mm_packus_epi16(_mm_and_si128(a,lowBytes),_mm_and_si128(b,lowBytes));
+		__m128i r = _mm_packus_epi16(_mm_srli_epi16(a,8),_mm_srli_epi16(b,8));
+		_mm_storeu_si128((__m128i*)&out[i],l);
+		_mm_storeu_si128((__m128i*)&out[nFrames+i],r);
+	}
+	return i;
+}
+
+static const dsf2flac_uint32 maxShuffleChannels = 8;
+
+/**
+ * pshufb masks for 16 frames of n channels (n*16 bytes, so n registers).
+ * masks[n][c][k] picks the bytes of channel c that are in input register k, the rest are zeroed (0x80).
+ */
+struct ShuffleMasks {
+	dsf2flac_uint8 masks[maxShuffleChannels+1][maxShuffleChannels][maxShuffleChannels][16];
+	ShuffleMasks() {
+		for (dsf2flac_uint32 n=0; n<=maxShuffleChannels; n++)
+			for (dsf2flac_uint32 c=0; c<maxShuffleChannels; c++)
+				for (dsf2flac_uint32 k=0; k<maxShuffleChannels; k++)
+					for (dsf2flac_uint32 j=0; j<16; j++) {
+						dsf2flac_uint32 s = j*n + c; // byte of frame j, channel c
+						masks[n][c][k][j] = (c<n && s/16==k) ? s%16 : 0x80;
+					}
+	}
+};
+
+static const ShuffleMasks& shuffle_masks()
+{
+	static const ShuffleMasks masks;
+	return masks;
+}
+
+/**
+ * Three to eight channels: each output register is the OR of one shuffle per input register (SSSE3).
+ * The channel count is a template parameter so the loops unroll and the masks stay in registers.
+ */
+template <dsf2flac_uint32 nChannels>
+__attribute__((target("ssse3")))
+static dsf2flac_uint32 deinterleave_ssse3(const dsf2flac_uint8* in, dsf2flac_uint8* out, dsf2flac_uint32 nFrames)
+{
+	const ShuffleMasks& shuffleMasks = shuffle_masks();
+	__m128i m[nChannels][nChannels];
+	for (dsf2flac_uint32 c=0; c<nChannels; c++)
+		for (dsf2flac_uint32 k=0; k<nChannels; k++)
+			m[c][k] = _mm_loadu_si128((const __m128i*)shuffleMasks.masks[nChannels][c][k]);
+	__m128i v[nChannels];
+	dsf2flac_uint32 i = 0;
+	for (; i+16<=nFrames; i+=16) {
+		for (dsf2flac_uint32 k=0; k<nChannels; k++)
+			v[k] = _mm_loadu_si128((const __m128i*)&in[i*nChannels+16*k]);
+		for (dsf2flac_uint32 c=0; c<nChannels; c++) {
+			__m128i o = _mm_shuffle_epi8(v[0],m[c][0]);
+			for (dsf2flac_uint32 k=1; k<nChannels; k++)
+				o = _mm_or_si128(o,_mm_shuffle_epi8(v[k],m[c][k]));
+			_mm_storeu_si128((__m128i*)&out[c*nFrames+i],o);
+		}
+	}
+	return i;
+}
+
+#endif // DEINTERLEAVE_X86
+
+void deinterleave_bytes(const dsf2flac_uint8* in, dsf2flac_uint8* out, dsf2flac_uint32 nChannels, dsf2flac_uint32 nFrames)
+{
+	if (nChannels == 1) {
+		memcpy(out,in,nFrames);
+		return;
+	}
+	dsf2flac_uint32 done = 0;
+#ifdef DEINTERLEAVE_X86
+	static const bool haveSsse3 = __builtin_cpu_supports("ssse3");
+	if (nChannels == 2)
+		done = deinterleave_2_sse2(in,out,nFrames);
+	else if (haveSsse3) {
+		switch (nChannels) {
+			case 3: done = deinterleave_ssse3<3>(in,out,nFrames); break;
+			case 4: done = deinterleave_ssse3<4>(in,out,nFrames); break;
+			case 5: done = deinterleave_ssse3<5>(in,out,nFrames); break;
+			case 6: done = deinterleave_ssse3<6>(in,out,nFrames); break;
+			case 7: done = deinterleave_ssse3<7>(in,out,nFrames); break;
+			case 8: done = deinterleave_ssse3<8>(in,out,nFrames); break;
+		}
+	}
+#endif
+	deinterleave_scalar(in,out,nChannels,nFrames,done);
+}
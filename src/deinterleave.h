@@ -0,0 +1,62 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * deinterleave.h
+  *
+  * Header file for the byte de-interleaving helper.
+  *
+  * DSDIFF files (and the DST decoder) store the DSD data with the channels interleaved byte by byte.
+  * deinterleave_bytes splits such a block into one contiguous array per channel.
+  *
+  */
+
+#ifndef DEINTERLEAVE_H
+#define DEINTERLEAVE_H
+
+#include "dsf2flac_types.h"
+
+/**
+ * Splits nFrames frames of nChannels interleaved bytes into planar form: the bytes of channel c
+ * end up in out[c*nFrames] to out[c*nFrames+nFrames-1]. in and out must not overlap.
+ *
+ * Stereo uses SSE2. Three to eight channels use SSSE3 byte shuffles when the CPU supports them.
+ * Everything else falls back to a plain loop.
+ */
+void deinterleave_bytes(const dsf2flac_uint8* in, dsf2flac_uint8* out, dsf2flac_uint32 nChannels, dsf2flac_uint32 nFrames);
+
+#endif // DEINTERLEAVE_H
@@ -105,7 +105,7 @@ void DopPacker::pack_buffer(dsf2flac_int32 *buffer, dsf2flac_uint32 bufferLen) {
 		exit(EXIT_FAILURE);
 	}
 	// get the sample buffer
-	boost::circular_buffer<dsf2flac_uint8>* buff = reader->getBuffer();
+	DsdHistoryBuffer* buff = reader->getBuffer();
 	for (int i=0; i<d.quot ; i++) {
 
 		dsf2flac_int32 packed_sample;
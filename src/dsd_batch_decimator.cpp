@@ -0,0 +1,229 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "dsd_batch_decimator.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCH_DECIMATOR_X86
+#include <immintrin.h>
+#endif
+
+#ifdef BATCH_DECIMATOR_X86
+
+/// One AVX2 gather of the four table entries picked by the four bytes at bytes.
+__attribute__((target("avx2")))
+static inline __m256d gather_4_avx2(const dsf2flac_float64* row, const dsf2flac_uint8* bytes)
+{
+	dsf2flac_int32 b;
+	memcpy(&b,bytes,4);
+	// the masked form (all lanes on, zero source) so that there is no undefined source register
+	const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+	return _mm256_mask_i32gather_pd(_mm256_setzero_pd(),row,_mm_cvtepu8_epi32(_mm_cvtsi32_si128(b)),all,8);
+}
+
+/**
+ * Lanes in blocks of eight (then four) with AVX2: the table bytes of each lane pick its entries with
+ * gathers, and each lane is summed in the same order as the plain loop (so gives exactly the same result).
+ * Returns the number of lanes done, the rest are left to the plain loop.
+ */
+__attribute__((target("avx2")))
+static dsf2flac_uint32 filter_lanes_avx2(const dsf2flac_float64* const* table, dsf2flac_uint32 nTable,
+		const dsf2flac_uint8* laneBytes, dsf2flac_uint32 nLanes, dsf2flac_float64* laneSums)
+{
+	dsf2flac_uint32 l = 0;
+	for (; l+8<=nLanes; l+=8) {
+		__m256d lo = _mm256_setzero_pd();
+		__m256d hi = _mm256_setzero_pd();
+		const dsf2flac_uint8* bytes = &laneBytes[l];
+		for (dsf2flac_uint32 t=0; t<nTable; t++, bytes+=nLanes) {
+			lo = _mm256_add_pd(lo,gather_4_avx2(table[t],bytes));
+			hi = _mm256_add_pd(hi,gather_4_avx2(table[t],bytes+4));
+		}
+		_mm256_storeu_pd(&laneSums[l],lo);
+		_mm256_storeu_pd(&laneSums[l+4],hi);
+	}
+	if (l+4<=nLanes) {
+		__m256d sum = _mm256_setzero_pd();
+		const dsf2flac_uint8* bytes = &laneBytes[l];
+		for (dsf2flac_uint32 t=0; t<nTable; t++, bytes+=nLanes)
+			sum = _mm256_add_pd(sum,gather_4_avx2(table[t],bytes));
+		_mm256_storeu_pd(&laneSums[l],sum);
+		l += 4;
+	}
+	return l;
+}
+
+/// calc_type can be changed to single precision, which has no vector version here.
+static inline dsf2flac_uint32 filter_lanes_avx2(const dsf2flac_float32* const*, dsf2flac_uint32,
+		const dsf2flac_uint8*, dsf2flac_uint32, dsf2flac_float32*)
+{
+	return 0;
+}
+
+#endif // BATCH_DECIMATOR_X86
+
+DsdBatchDecimator::DsdBatchDecimator(DsdSampleReader *firstReader, dsf2flac_uint32 outputSampleRate)
+{
+	filter = new DsdDecimator(firstReader,outputSampleRate);
+	samplingFreq = firstReader->getSamplingFreq();
+	msbIsPlayedFirst = firstReader->msbIsPlayedFirst();
+	laneBytes = NULL;
+	laneSums = NULL;
+	nLanes = 0;
+	laneCapacity = 0;
+}
+
+DsdBatchDecimator::~DsdBatchDecimator()
+{
+	delete filter;
+	delete[] laneBytes;
+	delete[] laneSums;
+}
+
+bool DsdBatchDecimator::isValid()
+{
+	return filter->isValid();
+}
+
+std::string DsdBatchDecimator::getErrorMsg()
+{
+	return filter->getErrorMsg();
+}
+
+bool DsdBatchDecimator::addReader(DsdSampleReader *reader)
+{
+	if (!isValid())
+		return false;
+	if (reader->getSamplingFreq() != samplingFreq)
+		return false;
+	if (reader->msbIsPlayedFirst() != msbIsPlayedFirst)
+		return false;
+	// set the buffer to the length of the table if not long enough
+	if (filter->nLookupTable > reader->getBufferLength())
+		reader->setBufferLength(filter->nLookupTable);
+	return true;
+}
+
+dsf2flac_float64 DsdBatchDecimator::getPosition(DsdSampleReader *reader)
+{
+	return (dsf2flac_float64) (reader->getPosition()-filter->tzero)/filter->ratio;
+}
+
+dsf2flac_float64 DsdBatchDecimator::getLastValidSample(DsdSampleReader *reader)
+{
+	return (dsf2flac_float64)getLength(reader) - (dsf2flac_float64)filter->tzero / filter->ratio;
+}
+
+template<> void DsdBatchDecimator::getSamples(DsdSampleReader **readers, dsf2flac_uint32 nReaders, dsf2flac_int16 *buffer, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	getSamplesInternal(readers,nReaders,buffer,scale,tpdfDitherPeakAmplitude,clipAmplitude,true);
+}
+template<> void DsdBatchDecimator::getSamples(DsdSampleReader **readers, dsf2flac_uint32 nReaders, dsf2flac_int32 *buffer, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	getSamplesInternal(readers,nReaders,buffer,scale,tpdfDitherPeakAmplitude,clipAmplitude,true);
+}
+template<> void DsdBatchDecimator::getSamples(DsdSampleReader **readers, dsf2flac_uint32 nReaders, dsf2flac_int64 *buffer, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	getSamplesInternal(readers,nReaders,buffer,scale,tpdfDitherPeakAmplitude,clipAmplitude,true);
+}
+template<> void DsdBatchDecimator::getSamples(DsdSampleReader **readers, dsf2flac_uint32 nReaders, dsf2flac_float32 *buffer, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	getSamplesInternal(readers,nReaders,buffer,scale,tpdfDitherPeakAmplitude,clipAmplitude,false);
+}
+template<> void DsdBatchDecimator::getSamples(DsdSampleReader **readers, dsf2flac_uint32 nReaders, dsf2flac_float64 *buffer, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	getSamplesInternal(readers,nReaders,buffer,scale,tpdfDitherPeakAmplitude,clipAmplitude,false);
+}
+template <typename sampleType> void DsdBatchDecimator::getSamplesInternal(
+		DsdSampleReader **readers,
+		dsf2flac_uint32 nReaders,
+		sampleType *buffer,
+		dsf2flac_float64 scale,
+		dsf2flac_float64 tpdfDitherPeakAmplitude,
+		dsf2flac_float64 clipAmplitude,
+		bool roundToInt)
+{
+	filterLanes(readers,nReaders);
+	DsdDecimator::quantize(laneSums,buffer,nLanes,scale,tpdfDitherPeakAmplitude,clipAmplitude,roundToInt);
+}
+
+void DsdBatchDecimator::filterLanes(DsdSampleReader **readers, dsf2flac_uint32 nReaders)
+{
+	dsf2flac_uint32 nTable = filter->nLookupTable;
+
+	// make sure there is room for every lane
+	nLanes = 0;
+	for (dsf2flac_uint32 r=0; r<nReaders; r++)
+		nLanes += readers[r]->getNumChannels();
+	if (nLanes > laneCapacity) {
+		delete[] laneBytes;
+		delete[] laneSums;
+		laneCapacity = nLanes;
+		laneBytes = new dsf2flac_uint8[nTable*laneCapacity];
+		laneSums = new calc_type[laneCapacity];
+	}
+
+	// copy the newest nTable bytes of each channel into its lane.
+	dsf2flac_uint32 lane = 0;
+	for (dsf2flac_uint32 r=0; r<nReaders; r++) {
+		DsdHistoryBuffer* buff = readers[r]->getBuffer();
+		for (dsf2flac_uint32 c=0; c<readers[r]->getNumChannels(); c++, lane++) {
+			// the buffer holds the newest byte first.
+			const dsf2flac_uint8 *src = buff[c].data();
+			dsf2flac_uint8 *dst = &laneBytes[lane];
+			for (dsf2flac_uint32 t=0; t<nTable; t++, dst+=nLanes)
+				*dst = src[t];
+		}
+	}
+
+	// run through the lookup table once, adding each entry into every lane.
+	dsf2flac_uint32 done = 0;
+#ifdef BATCH_DECIMATOR_X86
+	static const bool haveAvx2 = __builtin_cpu_supports("avx2");
+	if (haveAvx2)
+		done = filter_lanes_avx2(filter->lookupTable,nTable,laneBytes,nLanes,laneSums);
+#endif
+	for (dsf2flac_uint32 l=done; l<nLanes; l++)
+		laneSums[l] = 0;
+	for (dsf2flac_uint32 t=0; t<nTable; t++) {
+		const calc_type *row = filter->lookupTable[t];
+		const dsf2flac_uint8 *bytes = &laneBytes[t*nLanes];
+		for (dsf2flac_uint32 l=done; l<nLanes; l++)
+			laneSums[l] += row[bytes[l]];
+	}
+}
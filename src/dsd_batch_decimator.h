@@ -0,0 +1,130 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsd_batch_decimator.h
+  *
+  * Header file for the class DsdBatchDecimator.
+  *
+  * The DsdBatchDecimator filters the channels of many readers together, for converting
+  * large numbers of (typically stereo) files as quickly as possible.
+  *
+  */
+
+#ifndef DSDBATCHDECIMATOR_H
+#define DSDBATCHDECIMATOR_H
+
+#include "dsd_decimator.h"
+
+/**
+ *
+ * The DsdBatchDecimator uses the same lookup table FIR as the DsdDecimator but computes one output
+ * sample for every channel of a whole set of readers at once. The channels are laid out side by side
+ * ("lanes") and the filter runs over the lookup table one entry at a time, adding it into every lane.
+ * This keeps just one lookup table in the cache for all of the readers. Where the CPU has AVX2 the lanes
+ * are done eight (or four) at a time, their table bytes picking the entries with gather loads; the lanes
+ * left over, and every lane on other CPUs, use a plain loop.
+ *
+ * All readers in a batch must have the same DSD sample rate and bit order as the first reader.
+ * Readers are stepped by the caller, as with DsdDecimator::getCurrentSamples.
+ */
+class DsdBatchDecimator
+{
+public:
+	/// Class constructor. The filter is set up for the first reader and outputSampleRate, as in DsdDecimator.
+	DsdBatchDecimator(DsdSampleReader *firstReader, dsf2flac_uint32 outputSampleRate);
+	/// Class destructor.
+	virtual ~DsdBatchDecimator();
+
+	/// Return false if the filter could not be set up (unsupported sample rate for example).
+	bool isValid();
+	/// Returns a message explaining why the decimator is invalid.
+	std::string getErrorMsg();
+	/// Return true if reader can join this batch (same DSD sample rate and bit order), and makes its buffer long enough.
+	bool addReader(DsdSampleReader *reader);
+
+	/// Return the output sample rate in Hz.
+	dsf2flac_uint32 getOutputSampleRate() { return filter->getOutputSampleRate(); };
+	/// Return the decimation ratio: DSD sample rate / PCM sample rate.
+	dsf2flac_uint32 getDecimationRatio() { return filter->getDecimationRatio(); };
+	/// Return the data length of reader in PCM samples.
+	dsf2flac_int64 getLength(DsdSampleReader *reader) { return reader->getLength()/getDecimationRatio(); };
+	/// Return the current position of reader in PCM samples.
+	dsf2flac_float64 getPosition(DsdSampleReader *reader);
+	/// Return the position of the first PCM sample that is completely defined.
+	dsf2flac_float64 getFirstValidSample() { return filter->getFirstValidSample(); };
+	/// Return the position of the last PCM sample of reader that is completely defined.
+	dsf2flac_float64 getLastValidSample(DsdSampleReader *reader);
+
+	/**
+	 * Calculate one PCM output sample per channel for each of the nReaders readers at their current positions,
+	 * without stepping them. The samples for each reader are interleaved as in DsdDecimator::getSamples and
+	 * the readers follow one after another in buffer.
+	 *
+	 * The sample types and other arguments are as for DsdDecimator::getSamples.
+	 */
+	template <typename sampleType> void getSamples(
+			DsdSampleReader **readers,
+			dsf2flac_uint32 nReaders,
+			sampleType *buffer,
+			dsf2flac_float64 scale,
+			dsf2flac_float64 tpdfDitherPeakAmplitude = 0,
+			dsf2flac_float64 clipAmplitude = 0);
+private:
+	/// Runs the lookup table FIR over all lanes.
+	void filterLanes(DsdSampleReader **readers, dsf2flac_uint32 nReaders);
+	/// Does the work for the getSamples method.
+	template <typename sampleType> void getSamplesInternal(
+			DsdSampleReader **readers,
+			dsf2flac_uint32 nReaders,
+			sampleType *buffer,
+			dsf2flac_float64 scale,
+			dsf2flac_float64 tpdfDitherPeakAmplitude,
+			dsf2flac_float64 clipAmplitude,
+			bool roundToInt);
+private:
+	DsdDecimator *filter; // decimator for the first reader, which supplies the lookup table
+	// the first reader may be closed before the batch, so keep what addReader needs.
+	dsf2flac_uint32 samplingFreq;
+	bool msbIsPlayedFirst;
+	dsf2flac_uint8 *laneBytes; // the filter history of every lane, one row of nLanes per table entry
+	calc_type *laneSums; // the filter output of every lane
+	dsf2flac_uint32 nLanes;
+	dsf2flac_uint32 laneCapacity;
+};
+
+#endif // DSDBATCHDECIMATOR_H
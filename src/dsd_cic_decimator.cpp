@@ -0,0 +1,217 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "dsd_cic_decimator.h"
+#include <cmath>
+
+static const dsf2flac_uint32 nFirPerRatio = 24; // compensating FIR length is nFirPerRatio*cicFirRatio+1
+static const dsf2flac_float64 firCutoff = 0.30; // as a fraction of the output sample rate
+static const dsf2flac_uint32 firDesignPoints = 2048; // integration points used to design the FIR
+// after 8 samples integrator k has gained stepCoefs[k-j] times the old value of integrator j (binomial coefficients).
+static const dsf2flac_uint64 stepCoefs[] = {1, 8, 36, 120, 330, 792};
+
+/// Length of the compensating FIR.
+static dsf2flac_uint32 firLength()
+{
+	return nFirPerRatio*DsdCicDecimator::cicFirRatio+1;
+}
+
+/// Bytes of history needed to prime the filter from scratch.
+static dsf2flac_uint32 primeLength(DsdSampleReader *r, dsf2flac_uint32 rate)
+{
+	dsf2flac_uint32 cicRatio = r->getSamplingFreq()/rate/DsdCicDecimator::cicFirRatio;
+	return (DsdCicDecimator::cicOrder+firLength())*(cicRatio/8);
+}
+
+/// Filter t=0 position: the group delay of the CIC plus that of the compensating FIR.
+static dsf2flac_uint32 filterDelay(DsdSampleReader *r, dsf2flac_uint32 rate)
+{
+	dsf2flac_uint32 cicRatio = r->getSamplingFreq()/rate/DsdCicDecimator::cicFirRatio;
+	return DsdCicDecimator::cicOrder*(cicRatio-1)/2 + (firLength()-1)/2*cicRatio;
+}
+
+DsdCicDecimator::DsdCicDecimator(DsdSampleReader *r, dsf2flac_uint32 rate) :
+	DsdDecimator(r,rate,primeLength(r,rate),filterDelay(r,rate))
+{
+	fir = NULL;
+	byteTable = NULL;
+	integrators = NULL;
+	combs = NULL;
+	history = NULL;
+
+	if (!valid)
+		return;
+	if (ratio % (8*cicFirRatio) != 0) {
+		valid = false;
+		errorMsg = "Sorry, incompatible sample rate combination";
+		return;
+	}
+
+	cicRatio = ratio/cicFirRatio;
+	bytesPerCicSample = cicRatio/8;
+	nFir = firLength();
+	cicScale = 1.0/pow((calc_type)cicRatio,(int)cicOrder);
+
+	// work out the effect of a byte on the integrators.
+	// each sample does: i[0] += x, i[1] += i[0], i[2] += i[1] ...
+	// the state after 8 samples is a fixed mix of the old state (see stepCoefs) + byteTable[byte].
+	byteTable = new dsf2flac_uint64[256][cicOrder];
+	for (int dsdSeq=0; dsdSeq<256; dsdSeq++) {
+		dsf2flac_uint64 s[cicOrder] = {0};
+		// feed the bits in in the order they are played. As in DsdDecimator::initLookupTable
+		// a true msbIsPlayedFirst() means the msb is the newest sample.
+		for (int bit=0; bit<8; bit++) {
+			dsf2flac_uint64 x;
+			if (reader->msbIsPlayedFirst())
+				x = !!( dsdSeq & (1<<(bit)) );
+			else
+				x = !!( dsdSeq & (1<<(7-bit)) );
+			s[0] += x;
+			for (dsf2flac_uint32 k=1; k<cicOrder; k++)
+				s[k] += s[k-1];
+		}
+		for (dsf2flac_uint32 k=0; k<cicOrder; k++)
+			byteTable[dsdSeq][k] = s[k];
+	}
+
+	initFir();
+
+	integrators = new dsf2flac_uint64[getNumChannels()*cicOrder];
+	combs = new dsf2flac_uint64[getNumChannels()*cicOrder];
+	history = new calc_type[getNumChannels()*2*nFir];
+	resetState();
+}
+
+DsdCicDecimator::~DsdCicDecimator()
+{
+	delete[] fir;
+	delete[] byteTable;
+	delete[] integrators;
+	delete[] combs;
+	delete[] history;
+}
+
+void DsdCicDecimator::initFir()
+{
+	// frequency sampling design: the wanted response is the inverse of the CIC response up to the
+	// cutoff and zero above it. Frequencies are relative to the CIC output rate.
+	fir = new calc_type[nFir];
+	dsf2flac_float64 fc = firCutoff / cicFirRatio;
+	dsf2flac_float64 mid = (nFir-1)/2.0;
+	dsf2flac_float64 sum = 0;
+	for (dsf2flac_uint32 n=0; n<nFir; n++) {
+		dsf2flac_float64 acc = 0;
+		for (dsf2flac_uint32 p=0; p<firDesignPoints; p++) {
+			dsf2flac_float64 f = fc * (p+0.5) / firDesignPoints;
+			dsf2flac_float64 cic = 1.0;
+			if (f > 0)
+				cic = fabs( sin(M_PI*f) / (cicRatio*sin(M_PI*f/cicRatio)) );
+			acc += cos(2*M_PI*f*(n-mid)) / pow(cic,(int)cicOrder);
+		}
+		acc *= 2 * fc / firDesignPoints;
+		// blackman window
+		dsf2flac_float64 w = 0.42 - 0.5*cos(2*M_PI*n/(nFir-1)) + 0.08*cos(4*M_PI*n/(nFir-1));
+		fir[n] = acc * w;
+		sum += fir[n];
+	}
+	// unity gain at DC
+	for (dsf2flac_uint32 n=0; n<nFir; n++)
+		fir[n] /= sum;
+}
+
+void DsdCicDecimator::resetState()
+{
+	for (dsf2flac_uint32 i=0; i<getNumChannels()*cicOrder; i++)
+		integrators[i] = combs[i] = 0;
+	for (dsf2flac_uint32 i=0; i<getNumChannels()*2*nFir; i++)
+		history[i] = 0;
+	historyPos = 0;
+	lastPosition = -1;
+}
+
+void DsdCicDecimator::filterFrame(calc_type *frame)
+{
+	// how many bytes have arrived since the last call? If the reader has jumped then start again.
+	dsf2flac_int64 pos = reader->getPosition();
+	dsf2flac_int64 nBytes;
+	if (lastPosition < 0 || pos < lastPosition || (pos-lastPosition) % cicRatio != 0 || (pos-lastPosition)/8 > nLookupTable) {
+		resetState();
+		nBytes = nLookupTable;
+	} else
+		nBytes = (pos-lastPosition)/8;
+	lastPosition = pos;
+
+	// get the sample buffer
+	DsdHistoryBuffer* buff = reader->getBuffer();
+	dsf2flac_uint32 newHistoryPos = historyPos;
+	for (dsf2flac_uint32 c=0; c<getNumChannels(); c++) {
+		dsf2flac_uint64* integ = &integrators[c*cicOrder];
+		dsf2flac_uint64* comb = &combs[c*cicOrder];
+		calc_type* hist = &history[c*2*nFir];
+		dsf2flac_uint32 hp = historyPos;
+		// feed the new bytes through the CIC, oldest first.
+		for (dsf2flac_int64 i=nBytes-1; i>=0; i--) {
+			const dsf2flac_uint64* b = byteTable[buff[c][i]];
+			for (dsf2flac_int32 k=cicOrder-1; k>=0; k--) {
+				dsf2flac_uint64 s = b[k];
+				for (dsf2flac_int32 j=0; j<=k; j++)
+					s += stepCoefs[k-j]*integ[j];
+				integ[k] = s;
+			}
+			if (i % bytesPerCicSample == 0) {
+				// combs, the wrap around of the integrators cancels out here.
+				dsf2flac_uint64 v = integ[cicOrder-1];
+				for (dsf2flac_uint32 k=0; k<cicOrder; k++) {
+					dsf2flac_uint64 d = v - comb[k];
+					comb[k] = v;
+					v = d;
+				}
+				calc_type x = 2*(calc_type)v*cicScale - 1;
+				hist[hp] = hist[hp+nFir] = x;
+				if (++hp == nFir)
+					hp = 0;
+			}
+		}
+		newHistoryPos = hp;
+		// compensating FIR over the last nFir CIC outputs (it is symmetric so the order does not matter).
+		calc_type sum = 0;
+		for (dsf2flac_uint32 k=0; k<nFir; k++)
+			sum += fir[k]*hist[hp+k];
+		frame[c] = sum;
+	}
+	historyPos = newHistoryPos;
+}
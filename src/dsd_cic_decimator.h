@@ -0,0 +1,101 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsd_cic_decimator.h
+  *
+  * Header file for the class DsdCicDecimator.
+  *
+  * The DsdCicDecimator is an alternative to the lookup table FIR in DsdDecimator which does
+  * much less work per output sample at high decimation ratios.
+  *
+  */
+
+#ifndef DSDCICDECIMATOR_H
+#define DSDCICDECIMATOR_H
+
+#include "dsd_decimator.h"
+
+/**
+ *
+ * The DsdCicDecimator converts DSD to PCM in two stages:
+ *
+ * First a 4th order cascaded integrator comb (CIC) filter decimates to twice the output sample rate.
+ * The integrators are updated a whole byte (8 DSD samples) at a time using a small table, so the
+ * work is a handful of integer operations per byte regardless of the filter length.
+ *
+ * Then a short FIR, designed when the decimator is created, compensates for the droop of the CIC
+ * passband, removes what is left above the output nyquist and decimates by 2.
+ *
+ * The integrator state is kept between calls, so the bytes the reader has stepped over since the
+ * last sample are fed in at each call. If the reader has jumped the filter is primed again from
+ * the reader buffer, so the output is always fully defined (just like DsdDecimator).
+ *
+ * Any output sample rate which divides the DSD rate by a multiple of 16 is supported.
+ */
+class DsdCicDecimator : public DsdDecimator
+{
+public:
+	static const dsf2flac_uint32 cicOrder = 4; //!< Number of integrator/comb stages (at most 6).
+	static const dsf2flac_uint32 cicFirRatio = 2; //!< Decimation ratio of the compensating FIR stage.
+	/// Class constructor, see DsdDecimator.
+	DsdCicDecimator(DsdSampleReader *reader, dsf2flac_uint32 outputSampleRate);
+	/// Class destructor, frees the filter state.
+	virtual ~DsdCicDecimator();
+protected:
+	/// Feeds the new bytes through the CIC and returns the compensating FIR output for each channel.
+	void filterFrame(calc_type *frame);
+private:
+	/// Designs the compensating FIR.
+	void initFir();
+	/// Clears the filter state ready to prime it from the reader buffer.
+	void resetState();
+private:
+	dsf2flac_uint32 cicRatio; // decimation ratio of the CIC stage in DSD samples
+	dsf2flac_uint32 bytesPerCicSample; // cicRatio/8
+	dsf2flac_uint32 nFir; // length of the compensating FIR
+	calc_type* fir;
+	dsf2flac_uint64 (*byteTable)[cicOrder]; // integrator state after each possible byte, from zero
+	calc_type cicScale; // 1/gain of the CIC stage
+	dsf2flac_uint64* integrators; // cicOrder per channel
+	dsf2flac_uint64* combs; // cicOrder per channel
+	calc_type* history; // 2*nFir per channel, CIC output with each sample stored twice to avoid wrapping
+	dsf2flac_uint32 historyPos;
+	dsf2flac_int64 lastPosition; // reader position at the last call, -1 if the filter needs priming
+};
+
+#endif // DSDCICDECIMATOR_H
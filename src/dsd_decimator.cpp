@@ -39,14 +39,15 @@
 #include <cmath>
 #include "filters.cpp"
 
-static bool lookupTableAllocated = false;
-
 DsdDecimator::DsdDecimator(DsdSampleReader *r, dsf2flac_uint32 rate)
 {
 	reader = r;
+	nChannels = r->getNumChannels();
 	outputSampleRate = rate;
 	valid = true;;
 	errorMsg = "";
+	lookupTableAllocated = false;
+	frameBuffer = new calc_type[reader->getNumChannels()];
 	
 	// ratio of out to in sampling rates
 	ratio = r->getSamplingFreq() / outputSampleRate;
@@ -71,8 +72,37 @@ DsdDecimator::DsdDecimator(DsdSampleReader *r, dsf2flac_uint32 rate)
 		reader->setBufferLength(nLookupTable);
 }
 
+DsdDecimator::DsdDecimator(DsdSampleReader *r, dsf2flac_uint32 rate, dsf2flac_uint32 historyLength, dsf2flac_uint32 tz)
+{
+	reader = r;
+	nChannels = r->getNumChannels();
+	outputSampleRate = rate;
+	valid = true;
+	errorMsg = "";
+	lookupTableAllocated = false;
+	frameBuffer = new calc_type[reader->getNumChannels()];
+	nLookupTable = historyLength;
+	tzero = tz;
+
+	// ratio of out to in sampling rates
+	ratio = r->getSamplingFreq() / outputSampleRate;
+	// how many bytes to skip after each out sample calc.
+	nStep = ratio/8;
+
+	if (ratio < 8 || ratio % 8 != 0 || r->getSamplingFreq() % outputSampleRate != 0)
+	{
+		valid = false;
+		errorMsg = "Sorry, incompatible sample rate combination";
+		return;
+	}
+	// set the buffer to the length of the filter if not long enough
+	if (nLookupTable > reader->getBufferLength())
+		reader->setBufferLength(nLookupTable);
+}
+
 DsdDecimator::~DsdDecimator()
 {
+	delete[] frameBuffer;
 	if (lookupTableAllocated) {
 		for (dsf2flac_uint32 n=0; n<nLookupTable; n++)
 		{
@@ -170,6 +200,26 @@ template<> void DsdDecimator::getSamples(dsf2flac_float64 *buffer, dsf2flac_uint
 {
 	getSamplesInternal(buffer,bufferLen,scale,tpdfDitherPeakAmplitude,clipAmplitude,false);
 }
+template<> void DsdDecimator::getCurrentSamples(dsf2flac_int16 *frame, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	calcFrame(frame,scale,tpdfDitherPeakAmplitude,clipAmplitude,true);
+}
+template<> void DsdDecimator::getCurrentSamples(dsf2flac_int32 *frame, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	calcFrame(frame,scale,tpdfDitherPeakAmplitude,clipAmplitude,true);
+}
+template<> void DsdDecimator::getCurrentSamples(dsf2flac_int64 *frame, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	calcFrame(frame,scale,tpdfDitherPeakAmplitude,clipAmplitude,true);
+}
+template<> void DsdDecimator::getCurrentSamples(dsf2flac_float32 *frame, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	calcFrame(frame,scale,tpdfDitherPeakAmplitude,clipAmplitude,false);
+}
+template<> void DsdDecimator::getCurrentSamples(dsf2flac_float64 *frame, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	calcFrame(frame,scale,tpdfDitherPeakAmplitude,clipAmplitude,false);
+}
 template <typename sampleType> void DsdDecimator::getSamplesInternal(
 		sampleType *buffer,
 		dsf2flac_uint32 bufferLen,
@@ -184,39 +234,36 @@ template <typename sampleType> void DsdDecimator::getSamplesInternal(
 		fputs("Buffer length is not a multiple of getNumChannels()",stderr);
 		exit(EXIT_FAILURE);
 	}
-	// flag if we need to clip
-	bool clip = clipAmplitude > 0;
-	// get the sample buffer
-	boost::circular_buffer<dsf2flac_uint8>* buff = reader->getBuffer();
 	for (int i=0; i<d.quot ; i++) {
 		// filter each chan in turn
-		for (dsf2flac_uint32 c=0; c<getNumChannels(); c++) {
-			calc_type sum = 0.0;
-			for (dsf2flac_uint32 t=0; t<nLookupTable; t++) {
-				dsf2flac_uint32 byte = (dsf2flac_uint32) buff[c][t] & 0xFF;
-				sum += lookupTable[t][byte];
-			}
-			sum = sum*scale;
-			// dither before rounding/truncating
-			if (tpdfDitherPeakAmplitude > 0) {
-				// TPDF dither
-				calc_type rand1 = ((calc_type) rand()) / ((calc_type) RAND_MAX); // rand value between 0 and 1
-				calc_type rand2 = ((calc_type) rand()) / ((calc_type) RAND_MAX); // rand value between 0 and 1
-				sum = sum + (rand1-rand2)*tpdfDitherPeakAmplitude;
-			}
-			if (clip) {
-				if (sum > clipAmplitude)
-					sum = clipAmplitude;
-				else if (sum < -clipAmplitude)
-					sum = -clipAmplitude;
-			}
-			if (roundToInt)
-				buffer[i*getNumChannels()+c] = static_cast<sampleType>(round(sum));
-			else
-				buffer[i*getNumChannels()+c] = static_cast<sampleType>(sum);
-		}
+		calcFrame(&buffer[i*getNumChannels()],scale,tpdfDitherPeakAmplitude,clipAmplitude,roundToInt);
 		// step the buffer
 		for (dsf2flac_uint32 m=0; m<nStep; m++)
 			reader->step();
 	}
 }
+template <typename sampleType> void DsdDecimator::calcFrame(
+		sampleType *frame,
+		dsf2flac_float64 scale,
+		dsf2flac_float64 tpdfDitherPeakAmplitude,
+		dsf2flac_float64 clipAmplitude,
+		bool roundToInt)
+{
+	// run the filter over each chan
+	filterFrame(frameBuffer);
+	quantize(frameBuffer,frame,getNumChannels(),scale,tpdfDitherPeakAmplitude,clipAmplitude,roundToInt);
+}
+void DsdDecimator::filterFrame(calc_type *frame)
+{
+	// get the sample buffer
+	DsdHistoryBuffer* buff = reader->getBuffer();
+	// filter each chan in turn
+	for (dsf2flac_uint32 c=0; c<getNumChannels(); c++) {
+		// the history is one contiguous span, newest byte first.
+		const dsf2flac_uint8* bytes = buff[c].data();
+		calc_type sum = 0.0;
+		for (dsf2flac_uint32 t=0; t<nLookupTable; t++)
+			sum += lookupTable[t][bytes[t]];
+		frame[c] = sum;
+	}
+}
@@ -51,6 +51,8 @@
 #ifndef DSDDECIMATOR_H
 #define DSDDECIMATOR_H
 
+#include <cmath>
+#include <cstdlib>
 #include "dsd_sample_reader.h"
 
 /**
@@ -82,10 +84,12 @@ public:
 	dsf2flac_uint32 getOutputSampleRate();
 	/// Return the decimation ratio: DSD sample rate / PCM sample rate.
 	dsf2flac_uint32 getDecimationRatio() {return ratio;};
+	/// Return the filter delay in DSD samples: the reader position at which the filter is centred on the first DSD sample.
+	dsf2flac_uint32 getFilterDelay() {return tzero;};
 	/// Return the data length in PCM samples.
 	dsf2flac_int64 getLength();
 	/// Return the number of channels if audio data.
-	dsf2flac_uint32 getNumChannels() { return reader->getNumChannels(); };
+	dsf2flac_uint32 getNumChannels() { return nChannels; };
 	/// Return the current position in PCM samples.
 	dsf2flac_float64 getPosition();
 	/// Return the current position in seconds.
@@ -125,6 +129,39 @@ public:
 			dsf2flac_float64 scale,
 			dsf2flac_float64 tpdfDitherPeakAmplitude = 0,
 			dsf2flac_float64 clipAmplitude = 0);
+	/**
+	 * Calculate one PCM output sample per channel at the current reader position, without stepping the reader.
+	 * frame must be at least getNumChannels() long. The scale, dither and clip arguments are as for getSamples.
+	 *
+	 * This allows several decimators to share a single reader: the caller steps the reader itself and asks each
+	 * decimator for a sample once every getDecimationRatio()/8 steps.
+	 */
+	template <typename sampleType> void getCurrentSamples(
+			sampleType *frame,
+			dsf2flac_float64 scale,
+			dsf2flac_float64 tpdfDitherPeakAmplitude = 0,
+			dsf2flac_float64 clipAmplitude = 0);
+	/**
+	 * Scales, dithers, clips and (if roundToInt) rounds n raw filter outputs into PCM samples.
+	 * The arguments are as for getSamples.
+	 */
+	template <typename sampleType> static void quantize(
+			const calc_type *raw,
+			sampleType *out,
+			dsf2flac_uint32 n,
+			dsf2flac_float64 scale,
+			dsf2flac_float64 tpdfDitherPeakAmplitude,
+			dsf2flac_float64 clipAmplitude,
+			bool roundToInt);
+protected:
+	/**
+	 * Constructor for decimators which provide their own filter by overriding filterFrame.
+	 * historyLength is the number of bytes per channel the filter looks at and tzero is its t=0 position in DSD samples.
+	 * Any output sample rate which divides the DSD sample rate by a multiple of 8 is accepted.
+	 */
+	DsdDecimator(DsdSampleReader *reader, dsf2flac_uint32 outputSampleRate, dsf2flac_uint32 historyLength, dsf2flac_uint32 tzero);
+	/// Filters the current contents of the reader buffers into one raw (unscaled) value per channel.
+	virtual void filterFrame(calc_type *frame);
 private:	// private methods
 	/// Initializes the filter lookup table.
 	void initLookupTable(const dsf2flac_int32 nCoefs,const dsf2flac_float64* coefs,const dsf2flac_int32 tzero);
@@ -136,16 +173,61 @@ private:	// private methods
 			dsf2flac_float64 tpdfDitherPeakAmplitude,
 			dsf2flac_float64 clipAmplitude,
 			bool roundToInt);
-private:
+	/// Filters the current contents of the reader buffers into one sample per channel.
+	template <typename sampleType> void calcFrame(
+			sampleType *frame,
+			dsf2flac_float64 scale,
+			dsf2flac_float64 tpdfDitherPeakAmplitude,
+			dsf2flac_float64 clipAmplitude,
+			bool roundToInt);
+protected:
 	DsdSampleReader *reader;
+	dsf2flac_uint32 nChannels; // cached so the filter loops make no virtual calls
 	dsf2flac_uint32 outputSampleRate;
-	dsf2flac_uint32 nLookupTable;
+	dsf2flac_uint32 nLookupTable; // bytes of history used by the filter
 	dsf2flac_uint32 tzero; // filter t=0 position
-	calc_type** lookupTable;
 	dsf2flac_uint32 ratio; // inFs/outFs
 	dsf2flac_uint32 nStep;
 	bool valid;
 	std::string errorMsg;
+private:
+	friend class DsdBatchDecimator; // shares the lookup table between many readers
+	calc_type** lookupTable;
+	bool lookupTableAllocated;
+	calc_type* frameBuffer; // raw filter output for one frame
 };
 
+template <typename sampleType> inline void DsdDecimator::quantize(
+		const calc_type *raw,
+		sampleType *out,
+		dsf2flac_uint32 n,
+		dsf2flac_float64 scale,
+		dsf2flac_float64 tpdfDitherPeakAmplitude,
+		dsf2flac_float64 clipAmplitude,
+		bool roundToInt)
+{
+	// flag if we need to clip
+	bool clip = clipAmplitude > 0;
+	for (dsf2flac_uint32 c=0; c<n; c++) {
+		calc_type sum = raw[c]*scale;
+		// dither before rounding/truncating
+		if (tpdfDitherPeakAmplitude > 0) {
+			// TPDF dither
+			calc_type rand1 = ((calc_type) rand()) / ((calc_type) RAND_MAX); // rand value between 0 and 1
+			calc_type rand2 = ((calc_type) rand()) / ((calc_type) RAND_MAX); // rand value between 0 and 1
+			sum = sum + (rand1-rand2)*tpdfDitherPeakAmplitude;
+		}
+		if (clip) {
+			if (sum > clipAmplitude)
+				sum = clipAmplitude;
+			else if (sum < -clipAmplitude)
+				sum = -clipAmplitude;
+		}
+		if (roundToInt)
+			out[c] = static_cast<sampleType>(round(sum));
+		else
+			out[c] = static_cast<sampleType>(sum);
+	}
+}
+
 #endif // DSDDECIMATOR_H
@@ -0,0 +1,112 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsd_history_buffer.h
+  *
+  * Header file for the class DsdHistoryBuffer.
+  *
+  * The DsdHistoryBuffer holds the most recent bytes read from a DsdSampleReader. It behaves like the
+  * boost::circular_buffer it replaces (push_front, operator[]) but the contents are always one
+  * contiguous block of memory, so filters can run straight over them.
+  *
+  */
+
+#ifndef DSDHISTORYBUFFER_H
+#define DSDHISTORYBUFFER_H
+
+#include <cstring>
+#include "dsf2flac_types.h"
+
+/**
+ * A fixed length history of bytes, newest first: buff[0] is the byte added by the most recent push_front.
+ *
+ * The bytes live in an array twice the capacity. push_front writes downwards through the array and when
+ * it reaches the bottom the newest capacity()-1 bytes are moved back up to the top. So data() is always a
+ * contiguous span of capacity() bytes, at the cost of one memmove every capacity() pushes.
+ */
+class DsdHistoryBuffer
+{
+public:
+	DsdHistoryBuffer() { mem = NULL; len = 0; memLen = 0; front = 0; };
+	~DsdHistoryBuffer() { delete[] mem; };
+
+	/// Sets the number of bytes held, the contents are zeroed. With a capacity of 0 every byte pushed is dropped.
+	void set_capacity(dsf2flac_uint32 capacity) {
+		delete[] mem;
+		len = capacity;
+		memLen = capacity ? 2*capacity : 1; // a zero capacity buffer still needs somewhere for push_front to write
+		mem = new dsf2flac_uint8[memLen]();
+		front = memLen - len;
+	};
+	/// Sets every byte held to b.
+	void fill(dsf2flac_uint8 b) {
+		memset(mem,b,memLen);
+		front = memLen - len;
+	};
+	/// Returns the number of bytes held.
+	dsf2flac_uint32 capacity() const { return len; };
+	/// The buffer is always full, so this is the same as capacity().
+	dsf2flac_uint32 size() const { return len; };
+	/// Adds a byte to the front, the oldest byte drops off the end.
+	void push_front(dsf2flac_uint8 b) {
+		if (front == 0)
+			compact();
+		mem[--front] = b;
+	};
+	/// Returns the i-th newest byte.
+	dsf2flac_uint8 operator[](dsf2flac_uint32 i) const { return mem[front+i]; };
+	/// Returns the history as one span of capacity() bytes, newest first.
+	const dsf2flac_uint8* data() const { return &mem[front]; };
+private:
+	/// Moves the newest capacity()-1 bytes to the top of the array, making room below them.
+	void compact() {
+		if (len > 1)
+			memmove(&mem[memLen-len+1],mem,len-1);
+		front = len ? memLen-len+1 : memLen;
+	};
+	// not copyable
+	DsdHistoryBuffer(const DsdHistoryBuffer&);
+	DsdHistoryBuffer& operator=(const DsdHistoryBuffer&);
+private:
+	dsf2flac_uint8* mem;
+	dsf2flac_uint32 len; // bytes of history
+	dsf2flac_uint32 memLen; // size of mem
+	dsf2flac_uint32 front; // index of the newest byte in mem
+};
+
+#endif // DSDHISTORYBUFFER_H
@@ -0,0 +1,98 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "dsd_popcount_decimator.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POPCOUNT_X86
+#endif
+
+/**
+ * Count the set bits in len bytes starting at p, eight bytes at a time where possible.
+ * Unless the build targets a CPU with popcnt, the builtins become calls into libgcc.
+ * Always inlined so that countBitsPopcnt gets its own copy.
+ */
+static inline __attribute__((always_inline)) dsf2flac_uint32 countBits(const dsf2flac_uint8 *p, size_t len)
+{
+	dsf2flac_uint32 n = 0;
+	for (; len >= 8; len -= 8, p += 8) {
+		dsf2flac_uint64 w;
+		memcpy(&w,p,8);
+		n += __builtin_popcountll(w);
+	}
+	for (; len > 0; len--, p++)
+		n += __builtin_popcount(*p);
+	return n;
+}
+
+#ifdef POPCOUNT_X86
+/// countBits built for the popcnt instruction.
+__attribute__((target("popcnt")))
+static dsf2flac_uint32 countBitsPopcnt(const dsf2flac_uint8 *p, size_t len)
+{
+	return countBits(p,len);
+}
+#endif
+
+DsdPopcountDecimator::DsdPopcountDecimator(DsdSampleReader *r, dsf2flac_uint32 rate) :
+	DsdDecimator(r,rate,(r->getSamplingFreq()/rate)/8,(r->getSamplingFreq()/rate)/2)
+{
+}
+
+DsdPopcountDecimator::~DsdPopcountDecimator()
+{
+}
+
+void DsdPopcountDecimator::filterFrame(calc_type *frame)
+{
+#ifdef POPCOUNT_X86
+	static const bool havePopcnt = __builtin_cpu_supports("popcnt");
+#endif
+	// get the sample buffer
+	DsdHistoryBuffer* buff = reader->getBuffer();
+	for (dsf2flac_uint32 c=0; c<getNumChannels(); c++) {
+		// the newest nStep bytes are at the front of the buffer.
+#ifdef POPCOUNT_X86
+		dsf2flac_uint32 ones = havePopcnt ? countBitsPopcnt(buff[c].data(),nStep) : countBits(buff[c].data(),nStep);
+#else
+		dsf2flac_uint32 ones = countBits(buff[c].data(),nStep);
+#endif
+		// map the count of ones onto the range -1..1
+		frame[c] = (calc_type)(2*(dsf2flac_int32)ones - (dsf2flac_int32)ratio) / ratio;
+	}
+}
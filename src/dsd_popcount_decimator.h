@@ -0,0 +1,74 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsd_popcount_decimator.h
+  *
+  * Header file for the class DsdPopcountDecimator.
+  *
+  * The DsdPopcountDecimator is a very fast but approximate alternative to the DsdDecimator.
+  * Intended for previews, waveform rendering and the like where quality is secondary.
+  *
+  */
+
+#ifndef DSDPOPCOUNTDECIMATOR_H
+#define DSDPOPCOUNTDECIMATOR_H
+
+#include "dsd_decimator.h"
+
+/**
+ *
+ * The DsdPopcountDecimator converts DSD to PCM by simply counting the set bits in each block of
+ * getDecimationRatio() DSD samples (a boxcar or first order CIC filter). The counting is done a word
+ * at a time with the popcount builtin, which is a single instruction on most modern CPUs.
+ *
+ * There is no proper anti-alias filtering so the output contains plenty of aliased high frequency noise,
+ * but any output sample rate which divides the DSD rate by a multiple of 8 can be used (e.g. 44.1k or 11.025k).
+ */
+class DsdPopcountDecimator : public DsdDecimator
+{
+public:
+	/// Class constructor, see DsdDecimator.
+	DsdPopcountDecimator(DsdSampleReader *reader, dsf2flac_uint32 outputSampleRate);
+	/// Class destructor.
+	virtual ~DsdPopcountDecimator();
+protected:
+	/// Counts the bits in the last getDecimationRatio() DSD samples of each channel.
+	void filterFrame(calc_type *frame);
+};
+
+#endif // DSDPOPCOUNTDECIMATOR_H
@@ -41,6 +41,7 @@ DsdSampleReader::DsdSampleReader()
 {
 	bufferLength = defaultBufferLength;
 	isBufferAllocated = false;
+	posMarker = -1;
 }
 
 DsdSampleReader::~DsdSampleReader()
@@ -50,7 +51,7 @@ DsdSampleReader::~DsdSampleReader()
 	isBufferAllocated = false;
 }
 
-boost::circular_buffer<dsf2flac_uint8>* DsdSampleReader::getBuffer()
+DsdHistoryBuffer* DsdSampleReader::getBuffer()
 {
 	return circularBuffers;
 }
@@ -70,12 +71,22 @@ bool DsdSampleReader::setBufferLength(dsf2flac_uint32 b)
 	if (!isBufferAllocated)
 		allocateBuffer();
 	for (dsf2flac_uint32 i = 0; i<getNumChannels(); i++)
-		circularBuffers[i].set_capacity(getBufferLength());
+		if (circularBuffers[i].capacity() != getBufferLength())
+			circularBuffers[i].set_capacity(getBufferLength());
 	clearBuffer(); // should be called by rewind... but just incase.
 	rewind();
 	return true;
 }
 
+void DsdSampleReader::seek(dsf2flac_int64 pos)
+{
+	dsf2flac_int64 target = pos < 0 ? -1 : pos/samplesPerChar;
+	if (target < posMarker)
+		rewind();
+	while (posMarker < target)
+		step();
+}
+
 dsf2flac_float64 DsdSampleReader::getPositionInSeconds()
 {
 	return getPosition() / (dsf2flac_float64) getSamplingFreq();
@@ -106,11 +117,9 @@ void DsdSampleReader::allocateBuffer()
 	if (isBufferAllocated)
 		return;
 		
-	circularBuffers = new boost::circular_buffer<dsf2flac_uint8> [getNumChannels()];
-	for (dsf2flac_uint32 i = 0; i<getNumChannels(); i++) {
-		boost::circular_buffer<dsf2flac_uint8> cb(getBufferLength());
-		circularBuffers[i] = cb;
-	}
+	circularBuffers = new DsdHistoryBuffer[getNumChannels()];
+	for (dsf2flac_uint32 i = 0; i<getNumChannels(); i++)
+		circularBuffers[i].set_capacity(getBufferLength());
 	isBufferAllocated = true;
 	clearBuffer();
 	return;
@@ -123,9 +132,7 @@ void DsdSampleReader::clearBuffer()
 		return;
 	}
 	
-	dsf2flac_uint8 c = getIdleSample();
 	for (dsf2flac_uint32 i = 0; i<getNumChannels(); i++)
-		for (dsf2flac_uint32 j=0; j<getBufferLength(); j++)
-			circularBuffers[i].push_front(c);
+		circularBuffers[i].fill(getIdleSample());
 }
 
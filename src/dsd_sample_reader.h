@@ -40,7 +40,7 @@
 
 #include <stdio.h>
 #include <id3/tag.h>
-#include <boost/circular_buffer.hpp>
+#include "dsd_history_buffer.h"
 #include "dsf2flac_types.h"
 
 static const dsf2flac_uint32 defaultBufferLength = 5000; //!< The default length of the circular buffers.
@@ -95,15 +95,20 @@ public:
 	/// Set the reader position back to the start of the DSD data.
 	/// Note that child classes implementing this method must call clearBuffer();
 	virtual void rewind() = 0;
+	/** Move the reader to pos (in DSD samples, rounded down to a whole uint8).
+	 *  Afterwards the reader and the circular buffers are just as if it had been stepped there from the start.
+	 *  This implementation steps (rewinding first if pos is behind), readers which can jump override it.
+	 */
+	virtual void seek(dsf2flac_int64 pos);
 
 	/**
-	 * Returns an array of circular buffers, one for each track.
-	 * Each circular buffer contains getBufferLength() uint8 numbers.
+	 * Returns an array of history buffers, one for each channel.
+	 * Each buffer contains getBufferLength() uint8 numbers, contiguous in memory (see DsdHistoryBuffer::data()).
 	 * The DSD samples are packed into these uint8 numbers.
 	 * The next uint8 set of 8 DSD samples is added into position 0 when step() is called.
 	 * By default the buffer is filled with getIdleSample().
 	 */
-	boost::circular_buffer<dsf2flac_uint8>* getBuffer();
+	DsdHistoryBuffer* getBuffer();
 	/// Returns the length of the buffers (the number of uint8 numbers, NOT the number of DSD samples).
 	dsf2flac_uint32 getBufferLength();
 	/// Sets the length of the buffers (the number of uint8 numbers, NOT the number of DSD samples).
@@ -131,7 +136,7 @@ protected:
 	void clearBuffer();
 protected:
 	// protected properties
-	boost::circular_buffer<dsf2flac_uint8>* circularBuffers;
+	DsdHistoryBuffer* circularBuffers;
 	// position marker
 	dsf2flac_int64 posMarker; // implementors need to increment this on step()
 	dsf2flac_uint32 samplesPerChar; // should be set by implementors
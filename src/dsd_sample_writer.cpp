@@ -0,0 +1,77 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "dsd_sample_writer.h"
+#include "file_copy.h"
+
+DsdSampleWriter::DsdSampleWriter()
+{
+	valid = false;
+	copiedBytes = 0;
+}
+
+DsdSampleWriter::~DsdSampleWriter()
+{
+}
+
+bool DsdSampleWriter::isValid()
+{
+	return valid;
+}
+
+std::string DsdSampleWriter::getErrorMsg()
+{
+	return errorMsg;
+}
+
+void DsdSampleWriter::setID3Tag(const ID3_Tag& tag)
+{
+	id3Data.clear();
+	if (tag.NumFrames() == 0)
+		return;
+	id3Data.resize(tag.Size());
+	id3Data.resize(tag.Render(id3Data.data(),ID3TT_ID3V2));
+}
+
+bool DsdSampleWriter::copyToFile(FILE* file, int fd, dsf2flac_uint64 offset, dsf2flac_uint64 len)
+{
+	// the data goes in underneath the FILE, which is then moved on to the new end
+	if (fflush(file) || !copy_file_data(fd,offset,fileno(file),len) || fseeko(file,0,SEEK_END))
+		return false;
+	copiedBytes += len;
+	return true;
+}
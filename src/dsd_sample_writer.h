@@ -0,0 +1,100 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#ifndef DSDSAMPLEWRITER_H
+#define DSDSAMPLEWRITER_H
+
+#include <id3/tag.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "dsf2flac_types.h"
+
+/**
+ * Abstract class defining anything which writes dsd samples into something, the other end of a DsdSampleReader.
+ *
+ * The samples are written as interleaved uint8s: the next 8 DSD samples of each channel in turn, packed
+ * in the order given by msbIsPlayedFirst() (the same way as in the circular buffers of a reader).
+ * Nothing is complete until close() is called.
+ */
+class DsdSampleWriter
+{
+public:
+
+	/// Constructor
+	DsdSampleWriter();
+	/// Deconstructor
+	virtual ~DsdSampleWriter();
+
+	/// Return false if the writer is invalid (format/file error for example).
+	bool isValid();
+	/// Returns a message explaining why the writer is invalid.
+	std::string getErrorMsg();
+
+	/// Returns the number of channels in the writer.
+	virtual dsf2flac_uint32 getNumChannels() = 0;
+	/// Describes the order that the samples must be packed into the uint8s (see DsdSampleReader::msbIsPlayedFirst()).
+	virtual bool msbIsPlayedFirst() = 0;
+
+	/// Sets the tag which is written with the samples, must be called before close().
+	void setID3Tag(const ID3_Tag& tag);
+
+	/** Adds len uint8s of interleaved samples, len must be a multiple of the number of channels.
+	 *  Returns false if they couldn't be written.
+	 */
+	virtual bool write(const dsf2flac_uint8* data, dsf2flac_uint64 len) = 0;
+	/** Adds len bytes of samples which are already laid out just as the writer would write them, copied
+	 *  straight from the file fd at offset (see file_copy.h). Each writer says which layouts it can take.
+	 *  Returns false if they couldn't be copied.
+	 */
+	virtual bool copy(int fd, dsf2flac_uint64 offset, dsf2flac_uint64 len) = 0;
+	/// Finishes the output, returns false if anything couldn't be written.
+	virtual bool close() = 0;
+
+	/// Returns the number of bytes which were added by copy().
+	dsf2flac_uint64 getCopiedBytes() { return copiedBytes; };
+protected:
+	/// Copies len bytes from fd at offset to the end of file (for copy()), returns false on error.
+	bool copyToFile(FILE* file, int fd, dsf2flac_uint64 offset, dsf2flac_uint64 len);
+	// the tag rendered as ID3v2, empty if there isn't one
+	std::vector<dsf2flac_uint8> id3Data;
+	dsf2flac_uint64 copiedBytes;
+	// to hold feedback on errors
+	bool valid;
+	std::string errorMsg;
+};
+#endif // DSDSAMPLEWRITER_H
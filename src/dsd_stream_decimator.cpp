@@ -0,0 +1,250 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "dsd_stream_decimator.h"
+#include <cstring>
+
+DsdStreamReader::DsdStreamReader(dsf2flac_uint32 numChannels, dsf2flac_uint32 fs, bool msbIsPlayedFirst, dsf2flac_uint32 cap) : DsdSampleReader()
+{
+	chanNum = numChannels;
+	samplingFreq = fs;
+	msbFirst = msbIsPlayedFirst;
+	samplesPerChar = 8;
+	capacity = cap;
+	valid = true;
+	errorMsg = "";
+	if (chanNum < 1 || capacity < 1) {
+		errorMsg = "DsdStreamReader: at least one channel and one byte of capacity are required";
+		valid = false;
+		chanNum = 1;
+		capacity = 1;
+	}
+	pending = new dsf2flac_uint8[chanNum*capacity];
+	rewind(); // calls clearBuffer -> allocateBuffer
+}
+
+DsdStreamReader::~DsdStreamReader()
+{
+	delete[] pending;
+}
+
+dsf2flac_uint32 DsdStreamReader::push(const dsf2flac_uint8* const* channelData, dsf2flac_uint32 nBytes)
+{
+	if (nBytes > getFreeSpace())
+		nBytes = getFreeSpace();
+	// copy in up to two runs, the ring may wrap.
+	dsf2flac_uint32 tail = (pendingHead + pendingCount) % capacity;
+	dsf2flac_uint32 n1 = capacity - tail;
+	if (n1 > nBytes)
+		n1 = nBytes;
+	for (dsf2flac_uint32 c = 0; c<chanNum; c++) {
+		memcpy(&pending[c*capacity + tail], channelData[c], n1);
+		memcpy(&pending[c*capacity], channelData[c] + n1, nBytes - n1);
+	}
+	pendingCount += nBytes;
+	return nBytes;
+}
+
+dsf2flac_uint32 DsdStreamReader::pushInterleaved(const dsf2flac_uint8* data, dsf2flac_uint32 nBytes)
+{
+	if (nBytes > getFreeSpace())
+		nBytes = getFreeSpace();
+	dsf2flac_uint32 tail = (pendingHead + pendingCount) % capacity;
+	for (dsf2flac_uint32 i = 0; i<nBytes; i++) {
+		for (dsf2flac_uint32 c = 0; c<chanNum; c++)
+			pending[c*capacity + tail] = *data++;
+		if (++tail == capacity)
+			tail = 0;
+	}
+	pendingCount += nBytes;
+	return nBytes;
+}
+
+bool DsdStreamReader::step()
+{
+	if (pendingCount) {
+		for (dsf2flac_uint32 c = 0; c<chanNum; c++)
+			circularBuffers[c].push_front(pending[c*capacity + pendingHead]);
+		if (++pendingHead == capacity)
+			pendingHead = 0;
+		pendingCount--;
+	} else {
+		for (dsf2flac_uint32 c = 0; c<chanNum; c++)
+			circularBuffers[c].push_front(getIdleSample());
+	}
+	posMarker++;
+	return true;
+}
+
+void DsdStreamReader::rewind()
+{
+	pendingHead = 0;
+	pendingCount = 0;
+	posMarker = -1; // nothing in the buffers yet
+	clearBuffer();
+}
+
+DsdStreamDecimator::DsdStreamDecimator(
+		dsf2flac_uint32 numChannels,
+		dsf2flac_uint32 samplingFreq,
+		bool msbIsPlayedFirst,
+		dsf2flac_uint32 outputSampleRate,
+		dsf2flac_uint32 capacity)
+{
+	reader = new DsdStreamReader(numChannels,samplingFreq,msbIsPlayedFirst,capacity);
+	decimator = new DsdDecimator(reader,outputSampleRate);
+	nextSample = 0;
+	bytesIn = 0;
+	flushed = false;
+}
+
+DsdStreamDecimator::~DsdStreamDecimator()
+{
+	delete decimator;
+	delete reader;
+}
+
+bool DsdStreamDecimator::isValid()
+{
+	return reader->isValid() && decimator->isValid();
+}
+
+std::string DsdStreamDecimator::getErrorMsg()
+{
+	if (!reader->isValid())
+		return reader->getErrorMsg();
+	return decimator->getErrorMsg();
+}
+
+dsf2flac_uint32 DsdStreamDecimator::push(const dsf2flac_uint8* const* channelData, dsf2flac_uint32 nBytes)
+{
+	if (flushed)
+		return 0;
+	nBytes = reader->push(channelData,nBytes);
+	bytesIn += nBytes;
+	return nBytes;
+}
+
+dsf2flac_uint32 DsdStreamDecimator::pushInterleaved(const dsf2flac_uint8* data, dsf2flac_uint32 nBytes)
+{
+	if (flushed)
+		return 0;
+	nBytes = reader->pushInterleaved(data,nBytes);
+	bytesIn += nBytes;
+	return nBytes;
+}
+
+void DsdStreamDecimator::flush()
+{
+	flushed = true;
+}
+
+void DsdStreamDecimator::reset()
+{
+	reader->rewind();
+	nextSample = 0;
+	bytesIn = 0;
+	flushed = false;
+}
+
+dsf2flac_int64 DsdStreamDecimator::bytePositionOf(dsf2flac_int64 n)
+{
+	return (n*decimator->getDecimationRatio() + decimator->getFilterDelay())/8;
+}
+
+dsf2flac_uint32 DsdStreamDecimator::samplesReady()
+{
+	if (!isValid())
+		return 0;
+	dsf2flac_int64 nStep = decimator->getDecimationRatio()/8;
+	dsf2flac_int64 end;
+	if (flushed)
+		// every sample centred inside the stream, whatever the filter still needs is idle.
+		end = bytesIn / nStep;
+	else {
+		// every sample whose filter position has been pushed.
+		dsf2flac_int64 avail = reader->getLength()/8 - 1 - bytePositionOf(nextSample);
+		if (avail < 0)
+			return 0;
+		end = nextSample + avail / nStep + 1;
+	}
+	if (end <= nextSample)
+		return 0;
+	return (dsf2flac_uint32)(end - nextSample);
+}
+
+template<> dsf2flac_uint32 DsdStreamDecimator::getSamples(dsf2flac_int16 *buffer, dsf2flac_uint32 maxSamples, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	return getSamplesInternal(buffer,maxSamples,scale,tpdfDitherPeakAmplitude,clipAmplitude);
+}
+template<> dsf2flac_uint32 DsdStreamDecimator::getSamples(dsf2flac_int32 *buffer, dsf2flac_uint32 maxSamples, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	return getSamplesInternal(buffer,maxSamples,scale,tpdfDitherPeakAmplitude,clipAmplitude);
+}
+template<> dsf2flac_uint32 DsdStreamDecimator::getSamples(dsf2flac_int64 *buffer, dsf2flac_uint32 maxSamples, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	return getSamplesInternal(buffer,maxSamples,scale,tpdfDitherPeakAmplitude,clipAmplitude);
+}
+template<> dsf2flac_uint32 DsdStreamDecimator::getSamples(dsf2flac_float32 *buffer, dsf2flac_uint32 maxSamples, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	return getSamplesInternal(buffer,maxSamples,scale,tpdfDitherPeakAmplitude,clipAmplitude);
+}
+template<> dsf2flac_uint32 DsdStreamDecimator::getSamples(dsf2flac_float64 *buffer, dsf2flac_uint32 maxSamples, dsf2flac_float64 scale, dsf2flac_float64 tpdfDitherPeakAmplitude,dsf2flac_float64 clipAmplitude)
+{
+	return getSamplesInternal(buffer,maxSamples,scale,tpdfDitherPeakAmplitude,clipAmplitude);
+}
+template <typename sampleType> dsf2flac_uint32 DsdStreamDecimator::getSamplesInternal(
+		sampleType *buffer,
+		dsf2flac_uint32 maxSamples,
+		dsf2flac_float64 scale,
+		dsf2flac_float64 tpdfDitherPeakAmplitude,
+		dsf2flac_float64 clipAmplitude)
+{
+	dsf2flac_uint32 n = samplesReady();
+	if (n > maxSamples)
+		n = maxSamples;
+	dsf2flac_uint32 nChans = getNumChannels();
+	for (dsf2flac_uint32 i = 0; i<n; i++) {
+		// creep the reader up to the centre of the next sample
+		dsf2flac_int64 pos = bytePositionOf(nextSample);
+		while (reader->getPosition()/8 < pos)
+			reader->step();
+		decimator->getCurrentSamples(&buffer[i*nChans],scale,tpdfDitherPeakAmplitude,clipAmplitude);
+		nextSample++;
+	}
+	return n;
+}
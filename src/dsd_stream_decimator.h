@@ -0,0 +1,186 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsd_stream_decimator.h
+  *
+  * Header file for the classes DsdStreamReader and DsdStreamDecimator.
+  *
+  * The DsdStreamDecimator is a push style front end for the DsdDecimator. Instead of pulling
+  * samples from a file it is fed DSD bytes as they arrive (from a network buffer, a pipe, memory...)
+  * and hands back whatever PCM samples are ready.
+  *
+  */
+
+#ifndef DSDSTREAMDECIMATOR_H
+#define DSDSTREAMDECIMATOR_H
+
+#include "dsd_decimator.h"
+
+static const dsf2flac_uint32 defaultStreamCapacity = 16384; //!< The default number of bytes per channel a DsdStreamDecimator can hold.
+
+/**
+ * A DsdSampleReader which is fed with bytes by push() rather than reading them from a file.
+ *
+ * The pushed bytes wait in a fixed size fifo until step() moves them into the circular buffers.
+ * Once the fifo is empty step() supplies the idle sample instead.
+ */
+class DsdStreamReader : public DsdSampleReader
+{
+public:
+	/// Constructor, capacity is the fifo length in bytes per channel.
+	DsdStreamReader(dsf2flac_uint32 numChannels, dsf2flac_uint32 samplingFreq, bool msbIsPlayedFirst, dsf2flac_uint32 capacity);
+	virtual ~DsdStreamReader();
+
+	/// Copies up to nBytes bytes per channel into the fifo, one pointer per channel. Returns the number of bytes per channel taken.
+	dsf2flac_uint32 push(const dsf2flac_uint8* const* channelData, dsf2flac_uint32 nBytes);
+	/// As push but the channels are interleaved byte by byte (as in a DSDIFF file).
+	dsf2flac_uint32 pushInterleaved(const dsf2flac_uint8* data, dsf2flac_uint32 nBytes);
+	/// Returns the number of bytes per channel waiting in the fifo.
+	dsf2flac_uint32 getPending() { return pendingCount; };
+	/// Returns the number of bytes per channel which can be pushed before the fifo is full.
+	dsf2flac_uint32 getFreeSpace() { return capacity - pendingCount; };
+
+	// methods overriding dsdSampleReader
+	dsf2flac_uint32 getSamplingFreq() { return samplingFreq; };
+	dsf2flac_uint32 getNumChannels() { return chanNum; };
+	/// The length is everything read so far plus everything waiting in the fifo.
+	dsf2flac_int64 getLength() { return (posMarker + 1 + pendingCount)*samplesPerChar; };
+	bool step();
+	void rewind();
+	bool msbIsPlayedFirst() { return msbFirst; };
+private:
+	dsf2flac_uint32 chanNum;
+	dsf2flac_uint32 samplingFreq;
+	bool msbFirst;
+	// the fifo, one ring of capacity bytes per channel
+	dsf2flac_uint8* pending;
+	dsf2flac_uint32 capacity;
+	dsf2flac_uint32 pendingHead; // index of the oldest byte in each ring
+	dsf2flac_uint32 pendingCount;
+};
+
+/**
+ * The DsdStreamDecimator converts a stream of pushed DSD bytes into PCM with a DsdDecimator.
+ *
+ * Typical use is a loop of push() (or pushInterleaved()) followed by getSamples() until samplesReady() is zero.
+ * Once the input has ended call flush() and drain the remaining samples.
+ * Nothing is allocated after construction, so push() and getSamples() are safe to call from a realtime thread.
+ *
+ * Output sample n is centred on DSD sample n*getDecimationRatio() of the stream, so the output is not delayed
+ * by the filter and the stream yields floor(DSD samples / getDecimationRatio()) samples in total. The filter
+ * history before the start of the stream is filled with the idle sample.
+ */
+class DsdStreamDecimator
+{
+public:
+	/**
+	 * Class constructor.
+	 * msbIsPlayedFirst describes the bit order of the pushed bytes, see DsdSampleReader::msbIsPlayedFirst()
+	 * (true for DSF data, false for DSDIFF data).
+	 * capacity is the number of bytes per channel that can be pushed before samples must be read out.
+	 */
+	DsdStreamDecimator(
+			dsf2flac_uint32 numChannels,
+			dsf2flac_uint32 samplingFreq,
+			bool msbIsPlayedFirst,
+			dsf2flac_uint32 outputSampleRate,
+			dsf2flac_uint32 capacity = defaultStreamCapacity);
+	/// Class destructor
+	virtual ~DsdStreamDecimator();
+
+	/// Return false if the decimator is invalid (unsupported sample rates for example).
+	bool isValid();
+	/// Returns a message explaining why the decimator is invalid.
+	std::string getErrorMsg();
+
+	/// Return the number of channels.
+	dsf2flac_uint32 getNumChannels() { return reader->getNumChannels(); };
+	/// Return the output sample rate in Hz.
+	dsf2flac_uint32 getOutputSampleRate() { return decimator->getOutputSampleRate(); };
+	/// Return the decimation ratio: DSD sample rate / PCM sample rate.
+	dsf2flac_uint32 getDecimationRatio() { return decimator->getDecimationRatio(); };
+	/// Return the number of PCM samples (per channel) read out so far.
+	dsf2flac_int64 getPosition() { return nextSample; };
+
+	/**
+	 * Feeds nBytes bytes per channel into the decimator, one pointer per channel.
+	 * Returns the number of bytes per channel accepted, which is less than nBytes if the fifo is full.
+	 * Read out some samples and push the rest again.
+	 */
+	dsf2flac_uint32 push(const dsf2flac_uint8* const* channelData, dsf2flac_uint32 nBytes);
+	/// As push but the channels are interleaved byte by byte, data holds nBytes*getNumChannels() bytes.
+	dsf2flac_uint32 pushInterleaved(const dsf2flac_uint8* data, dsf2flac_uint32 nBytes);
+	/// Returns the number of bytes per channel which can be pushed before the fifo is full.
+	dsf2flac_uint32 getFreeSpace() { return reader->getFreeSpace(); };
+	/// Marks the end of the input. The samples at the end of the stream become ready, the filter is fed idle samples past the end.
+	void flush();
+	/// Clears the filter history and position ready for a new stream.
+	void reset();
+
+	/// Returns the number of PCM samples per channel that getSamples can return now.
+	dsf2flac_uint32 samplesReady();
+	/**
+	 * Reads up to maxSamples PCM samples per channel into buffer, channels interleaved.
+	 * buffer must hold maxSamples*getNumChannels() values. Returns the number of samples per channel read.
+	 * The scale, dither and clip arguments are as for DsdDecimator::getSamples and the same sample types are supported.
+	 */
+	template <typename sampleType> dsf2flac_uint32 getSamples(
+			sampleType *buffer,
+			dsf2flac_uint32 maxSamples,
+			dsf2flac_float64 scale,
+			dsf2flac_float64 tpdfDitherPeakAmplitude = 0,
+			dsf2flac_float64 clipAmplitude = 0);
+private:
+	/// Does the actual work for getSamples.
+	template <typename sampleType> dsf2flac_uint32 getSamplesInternal(
+			sampleType *buffer,
+			dsf2flac_uint32 maxSamples,
+			dsf2flac_float64 scale,
+			dsf2flac_float64 tpdfDitherPeakAmplitude,
+			dsf2flac_float64 clipAmplitude);
+	/// Returns the reader position (in bytes) at which the filter is centred on sample n.
+	dsf2flac_int64 bytePositionOf(dsf2flac_int64 n);
+private:
+	DsdStreamReader* reader;
+	DsdDecimator* decimator;
+	dsf2flac_int64 nextSample; // next PCM sample to be read out
+	dsf2flac_int64 bytesIn; // bytes per channel pushed since the start of the stream
+	bool flushed;
+};
+
+#endif // DSDSTREAMDECIMATOR_H
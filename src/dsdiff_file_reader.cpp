@@ -37,20 +37,42 @@
 
 
 #include "dsdiff_file_reader.h"
+#include "deinterleave.h"
+#include "dst_frame_crc.h"
 #include "libdstdec/dst_init.h"
 #include "libdstdec/dst_fram.h"
 #include <iostream>
 #include <cinttypes>
 #include <cstring>
+#include <cstdio>
+#include <sys/stat.h>
 
-static bool chanIdentsAllocated = false;
-static bool sampleBufferAllocated = false;
-static ebunch dstEbunch;
-static bool dstEbunchAllocated = false;
+bool DsdiffFileReader::useIndexCache = false;
+bool DsdiffFileReader::verifyDstCrc = false;
+std::atomic<dsf2flac_uint64> DsdiffFileReader::dstTablesMade(0);
+std::atomic<dsf2flac_uint64> DsdiffFileReader::dstTablesReused(0);
 
-DsdiffFileReader::DsdiffFileReader(char* filePath) : DsdSampleReader()
+// the sidecar index cache starts with this, then the file size and modification time it was made for
+static const char dstIndexCacheMagic[8] = { 'd','s','f','2','D','S','T','I' };
+
+DsdiffFileReader::DsdiffFileReader(char* filePath, bool headersOnly) : DsdSampleReader()
+{
+	setDefaults();
+	// first let's open the file
+	this->filePath = filePath;
+	file.open(filePath);
+	init(headersOnly);
+}
+
+DsdiffFileReader::DsdiffFileReader(const char* data, dsf2flac_uint64 length) : DsdSampleReader()
+{
+	setDefaults();
+	file.openMemory(data,length);
+	init(false);
+}
+
+void DsdiffFileReader::setDefaults()
 {
-	// set some defaults
 	ast.hours = 0;
 	ast.minutes = 0;
 	ast.seconds = 0;
@@ -63,9 +85,23 @@ DsdiffFileReader::DsdiffFileReader(char* filePath) : DsdSampleReader()
 	emid=NULL;
 	diar=NULL;
 	diti=NULL;
-	// first let's open the file
-	file.open(filePath, fstreamPlus::in | fstreamPlus::binary);
-	// throw exception if that did not work.
+	chanIdentsAllocated = false;
+	sampleBufferAllocated = false;
+	dstFrameBuffer = NULL;
+	dstFrameBufferLen = 0;
+	dstEbunchAllocated = false;
+	dstIndexUsable = false;
+	dstIndexAdjust = 0;
+	dstIndexBuilt = false;
+	dstFramesChecked = 0;
+	dstCrcErrors = 0;
+	dstDecodeErrors = 0;
+	dstFirstBadFrame = -1;
+}
+
+void DsdiffFileReader::init(bool headersOnly)
+{
+	// throw exception if the file could not be opened.
 	if (!file.is_open()) {
 		errorMsg = "could not open file";
 		valid = false;
@@ -78,11 +114,12 @@ DsdiffFileReader::DsdiffFileReader(char* filePath) : DsdSampleReader()
 	// find the start and end of the tracks.
 	processTracks();
 		
-	// if DST data, then initialise the decoder
-	if (checkIdent(compressionType,const_cast<dsf2flac_int8*>("DST "))) {
-		DST_InitDecoder(&dstEbunch, getNumChannels(), getSamplingFreq()/44100);
-		dstEbunchAllocated = true;
-	}
+	if (headersOnly)
+		return;
+	
+	// see if the DSTI chunk can be used to seek
+	if (isDst())
+		checkDstIndex();
 	
 	rewind(); // calls allocateBlockBuffer
 	
@@ -100,8 +137,12 @@ DsdiffFileReader::~DsdiffFileReader()
 		delete[] chanIdents;
 	}
 	// free sample buffer
-	if (sampleBufferAllocated)
+	if (sampleBufferAllocated) {
 		delete[] sampleBuffer;
+		delete[] planarBuffer;
+	}
+	if (dstFrameBuffer)
+		delete[] dstFrameBuffer;
 	// free comments
 	typename std::vector<DsdiffComment>::iterator c=comments.begin();
 	while(c!=comments.end()) {
@@ -128,6 +169,8 @@ DsdiffFileReader::~DsdiffFileReader()
 	
 	// free the DST decoder (assuming one was used)
 	if (dstEbunchAllocated) {
+		dstTablesMade += dstEbunch.ICoefIMisses;
+		dstTablesReused += dstEbunch.ICoefIHits;
 		DST_CloseDecoder(&dstEbunch);
 	}
 }
@@ -137,24 +180,220 @@ void DsdiffFileReader::allocateSampleBuffer()
 	if (sampleBufferAllocated)
 		return;
 	sampleBuffer = new dsf2flac_uint8[getNumChannels()*sampleBufferLenPerChan];
+	planarBuffer = new dsf2flac_uint8[getNumChannels()*sampleBufferLenPerChan];
 	sampleBufferAllocated = true;
+	// a DST frame is never longer than the header byte plus the plain DSD data it holds (which is how
+	// frames that don't compress are stored), so this is only ever outgrown by broken files.
+	if (isDst())
+		allocateDstFrameBuffer(getNumChannels()*sampleBufferLenPerChan + 1);
 }
 
 void DsdiffFileReader::rewind()
 {
-	// position the file at the start of the data chunk
-	if (file.seekg(sampleDataPointer)) {
+	// position the file at the start of the data chunk.
+	// a stream which has not been stepped through since the last rewind is already there, or just past the
+	// header of the first DST frame (which is still in its buffer), and can't go back any further.
+	file.clear();
+	if (file.tellg() != sampleDataPointer && file.seekg(sampleDataPointer)) {
 		errorMsg = "dsfFileReader::rewind:file seek error";
 	}
 	allocateSampleBuffer();
-	bufferCounter = 0;
-	bufferMarker = 0;
-	readNextBlock();
-	bufferCounter = 0;
+	// nothing is read (or decoded) until the first step(), which finds the sample buffer used up.
+	bufferCounter = -1;
+	bufferMarker = sampleBufferLenPerChan;
 	posMarker = -1;
 	clearBuffer();
 }
 
+void DsdiffFileReader::seek(dsf2flac_int64 pos)
+{
+	dsf2flac_int64 target = pos < 0 ? -1 : pos/samplesPerChar;
+	// the circular buffers have to be refilled from the file, so stepping starts this far before the target
+	dsf2flac_int64 first = target + 1 - getBufferLength();
+	// streams and short hops forward just step there
+	if (!file.isSeekable() || (target >= posMarker && first <= posMarker + sampleBufferLenPerChan)) {
+		DsdSampleReader::seek(pos);
+		return;
+	}
+	// find the block (DST frame) holding the first byte
+	dsf2flac_int64 block = first > 0 ? first/sampleBufferLenPerChan : 0;
+	dsf2flac_int64 lastBlock = (sampleCountPerChan/samplesPerChar)/sampleBufferLenPerChan;
+	if (block > lastBlock)
+		block = lastBlock;
+	dsf2flac_uint64 blockStart;
+	if (!isDst())
+		blockStart = sampleDataPointer + block*sampleBufferLenPerChan*chanNum;
+	else {
+		// building the index reads through the file, so note where stepping would carry on from
+		std::streampos filePos = file.tellg();
+		if (!findDstFrame(block,&blockStart)) {
+			// without an index the frames can only be found by walking through them
+			file.clear();
+			if (file.seekg(filePos)) {
+				errorMsg = "dsdiffFileReader::seek:file seek error";
+				return;
+			}
+			DsdSampleReader::seek(pos);
+			return;
+		}
+	}
+	// jump there with nothing read yet (see rewind), then step up to the target
+	file.clear();
+	if (file.seekg(blockStart)) {
+		errorMsg = "dsdiffFileReader::seek:file seek error";
+		return;
+	}
+	bufferCounter = block - 1;
+	bufferMarker = sampleBufferLenPerChan;
+	posMarker = block*sampleBufferLenPerChan - 1;
+	clearBuffer();
+	DsdSampleReader::seek(pos);
+}
+
+bool DsdiffFileReader::findDstFrame(dsf2flac_uint64 frame, dsf2flac_uint64* chunkStart)
+{
+	// without a DSTI chunk the index is made the first time it is needed
+	if (!dstIndexUsable && !dstIndexBuilt)
+		buildDstIndex();
+	if (!dstIndexUsable || frame >= dstFrameIndices.size())
+		return false;
+	*chunkStart = dstFrameIndices[frame].offset - dstIndexAdjust;
+	return true;
+}
+
+void DsdiffFileReader::checkDstIndex()
+{
+	dstIndexUsable = false;
+	if (dstFrameIndices.size() < dstInfo.numFrames || dstFrameIndices.empty())
+		return;
+	// the index should point at the DSTF chunk, but allow for writers which point at its data instead.
+	dsf2flac_uint64 offset = dstFrameIndices[0].offset;
+	dsf2flac_uint32 adjust[2] = { 0, 12 };
+	for (int i = 0; i < 2; i++) {
+		dsf2flac_int8 ident[4];
+		file.clear();
+		if (offset < adjust[i] || offset - adjust[i] > dstChunkEnd || file.seekg(offset - adjust[i]) || file.read_int8(ident,4))
+			continue;
+		if (checkIdent(ident,const_cast<dsf2flac_int8*>("DSTF")) || checkIdent(ident,const_cast<dsf2flac_int8*>("DSTC"))) {
+			dstIndexAdjust = adjust[i];
+			dstIndexUsable = true;
+			break;
+		}
+	}
+	file.clear();
+}
+
+void DsdiffFileReader::setUseIndexCache(bool u)
+{
+	useIndexCache = u;
+}
+
+void DsdiffFileReader::setVerifyDstCrc(bool v)
+{
+	verifyDstCrc = v;
+}
+
+void DsdiffFileReader::buildDstIndex()
+{
+	dstIndexBuilt = true;
+	dstFrameIndices.clear();
+	dstIndexAdjust = 0;
+	if (useIndexCache && loadDstIndexCache()) {
+		dstIndexUsable = true;
+		return;
+	}
+	dstIndexUsable = scanDstFrames();
+	if (dstIndexUsable && useIndexCache)
+		saveDstIndexCache();
+}
+
+bool DsdiffFileReader::scanDstFrames()
+{
+	dsf2flac_uint64 chunkStart = sampleDataPointer;
+	dsf2flac_uint64 chunkSz;
+	dsf2flac_int8 ident[5];
+	ident[4]='\0';
+	file.clear();
+	while (chunkStart < dstChunkEnd) {
+		if (!readChunkHeader(ident,chunkStart,&chunkSz))
+			break;
+		// DSTC chunks (and anything else) between the frames are skipped over.
+		if (checkIdent(ident,const_cast<dsf2flac_int8*>("DSTF"))) {
+			DSTFrameIndex in;
+			in.offset = chunkStart;
+			in.length = chunkSz - 12;
+			dstFrameIndices.push_back(in);
+		}
+		chunkStart += chunkSz;
+	}
+	file.clear();
+	if (dstFrameIndices.empty()) {
+		errorMsg = "dsdiffFileReader::scanDstFrames:no DST frames found";
+		return false;
+	}
+	return true;
+}
+
+bool DsdiffFileReader::loadDstIndexCache()
+{
+	struct stat st;
+	if (filePath.empty() || stat(filePath.c_str(),&st))
+		return false;
+	FILE* f = fopen((filePath + ".dstidx").c_str(),"rb");
+	if (!f)
+		return false;
+	char magic[8];
+	dsf2flac_uint64 size;
+	dsf2flac_int64 mtime;
+	dsf2flac_uint64 n;
+	bool ok = fread(magic,8,1,f) == 1 && !memcmp(magic,dstIndexCacheMagic,8)
+		&& fread(&size,8,1,f) == 1 && size == (dsf2flac_uint64)st.st_size
+		&& fread(&mtime,8,1,f) == 1 && mtime == (dsf2flac_int64)st.st_mtime
+		&& fread(&n,8,1,f) == 1 && n > 0 && n <= (dsf2flac_uint64)st.st_size/12;
+	if (ok) {
+		dstFrameIndices.resize(n);
+		for (dsf2flac_uint64 i=0; ok && i<n; i++)
+			ok = fread(&dstFrameIndices[i].offset,8,1,f) == 1 && fread(&dstFrameIndices[i].length,4,1,f) == 1
+				&& dstFrameIndices[i].offset >= sampleDataPointer && dstFrameIndices[i].offset < dstChunkEnd;
+	}
+	fclose(f);
+	if (!ok)
+		dstFrameIndices.clear();
+	return ok;
+}
+
+void DsdiffFileReader::saveDstIndexCache()
+{
+	struct stat st;
+	if (filePath.empty() || stat(filePath.c_str(),&st) || !S_ISREG(st.st_mode))
+		return;
+	// write it under another name first so that a reader never sees half of it
+	std::string cachePath = filePath + ".dstidx";
+	std::string tmpPath = cachePath + ".tmp";
+	FILE* f = fopen(tmpPath.c_str(),"wb");
+	if (!f)
+		return;
+	dsf2flac_uint64 size = st.st_size;
+	dsf2flac_int64 mtime = st.st_mtime;
+	dsf2flac_uint64 n = dstFrameIndices.size();
+	bool ok = fwrite(dstIndexCacheMagic,8,1,f) == 1 && fwrite(&size,8,1,f) == 1
+		&& fwrite(&mtime,8,1,f) == 1 && fwrite(&n,8,1,f) == 1;
+	for (dsf2flac_uint64 i=0; ok && i<n; i++)
+		ok = fwrite(&dstFrameIndices[i].offset,8,1,f) == 1 && fwrite(&dstFrameIndices[i].length,4,1,f) == 1;
+	ok = !fclose(f) && ok;
+	if (!ok || rename(tmpPath.c_str(),cachePath.c_str()))
+		remove(tmpPath.c_str());
+}
+
+void DsdiffFileReader::allocateDstFrameBuffer(dsf2flac_uint64 len)
+{
+	if (dstFrameBuffer)
+		delete[] dstFrameBuffer;
+	// the decoder reads a byte past the end of a frame before it notices that it has run out
+	dstFrameBuffer = new dsf2flac_uint8[len + 8];
+	dstFrameBufferLen = len;
+}
+
 bool DsdiffFileReader::readNextBlock() {
 	
 	bool ok = true;
@@ -164,7 +403,8 @@ bool DsdiffFileReader::readNextBlock() {
 		ok = false;
 	}
 	
-	dsf2flac_int64 samplesLeft = getLength()-getPosition();
+	// posMarker is the byte which was stepped to last, so the block starts at the one after it.
+	dsf2flac_int64 samplesLeft = getLength()-(posMarker+1)*samplesPerChar;
 	
 	if (ok && checkIdent(compressionType,const_cast<dsf2flac_int8*>("DSD "))) {
 		if (samplesLeft/samplesPerChar < sampleBufferLenPerChan) {
@@ -182,7 +422,7 @@ bool DsdiffFileReader::readNextBlock() {
 	} else if (ok && checkIdent(compressionType,const_cast<dsf2flac_int8*>("DST "))) {
 		
 		dsf2flac_uint64 chunkStart = file.tellg();
-		dsf2flac_uint64 chunkSz;
+		dsf2flac_uint64 chunkSz = 0;
 		dsf2flac_int8 ident[5];
 		ident[4]='\0';
 		
@@ -193,17 +433,38 @@ bool DsdiffFileReader::readNextBlock() {
 		if (ok)
 			ok = readChunkHeader(ident,chunkStart,&chunkSz);
 		
-		// we might have a DSTC chunk, which we will ignore
-		if (ok)
-			if (checkIdent(ident,const_cast<dsf2flac_int8*>("DSTC")))
-				ok = readChunkHeader(ident,chunkStart,&chunkSz);
+		// a DSTC chunk belongs to the frame before it, so if we start at one (after a seek) it is skipped
+		if (ok && checkIdent(ident,const_cast<dsf2flac_int8*>("DSTC"))) {
+			chunkStart += chunkSz;
+			ok = chunkStart < dstChunkEnd && readChunkHeader(ident,chunkStart,&chunkSz);
+		}
 				
+		// the decoder is set up the first time it is needed
+		if (ok && !dstEbunchAllocated) {
+			DST_InitDecoder(&dstEbunch, getNumChannels(), getSamplingFreq()/44100);
+			dstEbunchAllocated = true;
+		}
+		
 		// decode
-		if (ok)
-			ok = readChunk_DSTF(chunkStart);
+		dsf2flac_int64 frame = (posMarker+1)/sampleBufferLenPerChan;
+		if (ok && !readChunk_DSTF(chunkStart)) {
+			dstDecodeErrors++;
+			if (dstFirstBadFrame < 0)
+				dstFirstBadFrame = frame;
+			ok = false;
+		}
+		dsf2flac_uint64 nextChunk = chunkStart + chunkSz;
+
+		// the frame may be followed by a DSTC chunk with its CRC
+		if (ok && nextChunk < dstChunkEnd && readChunkHeader(ident,nextChunk,&chunkSz)
+				&& checkIdent(ident,const_cast<dsf2flac_int8*>("DSTC"))) {
+			if (verifyDstCrc)
+				readChunk_DSTC(nextChunk,frame);
+			nextChunk += chunkSz;
+		}
 
 		// make sure we are in the right place for next time
-		file.seekg(chunkStart + chunkSz);
+		file.seekg(nextChunk);
 	} else
 		ok = false;
 	
@@ -214,32 +475,18 @@ bool DsdiffFileReader::readNextBlock() {
 			sampleBuffer[i] = getIdleSample();
 	}
 	
+	// split the channels out once per block so step() reads each channel contiguously.
+	deinterleave_bytes(sampleBuffer,planarBuffer,chanNum,sampleBufferLenPerChan);
+	
 	bufferCounter++;
 	bufferMarker=0;
 
 	return ok;
 }
 
-bool DsdiffFileReader::step()
+bool DsdiffFileReader::isDst()
 {
-	bool ok = true;
-	
-	if (!samplesAvailable())
-		ok = false;
-	else if (bufferMarker>=sampleBufferLenPerChan)
-		ok = readNextBlock();
-	
-	if (ok) {
-		for (dsf2flac_uint16 i=0; i<chanNum; i++)
-			circularBuffers[i].push_front(sampleBuffer[i+bufferMarker*chanNum]);
-		bufferMarker++;
-	} else {
-		for (dsf2flac_uint16 i=0; i<chanNum; i++)
-			circularBuffers[i].push_front(getIdleSample());
-	}
-	
-	posMarker++;
-	return ok;
+	return checkIdent(compressionType,const_cast<dsf2flac_int8*>("DST "));
 }
 
 dsf2flac_uint64 DsdiffFileReader::getTrackStart(dsf2flac_uint32 trackNum) {
@@ -365,6 +612,9 @@ bool DsdiffFileReader::readChunk_FRM8(dsf2flac_uint64 chunkStart)
 			readChunk_DSTI(subChunkStart);
 		} else
 			fprintf(stderr,"WARNING: unknown chunk type: %s\n",ident);
+		// a stream has to stop at the sound data, any chunks after it are lost.
+		if (found_dsdt && !file.isSeekable())
+			break;
 		// move to the next chunk
 		subChunkStart = subChunkStart + subChunkSz;
 	}
@@ -505,7 +755,8 @@ bool DsdiffFileReader::readChunk_CHNL(dsf2flac_uint64 chunkStart)
 		return false;
 	}
 	// read channel identifiers
-	chanIdents = new dsf2flac_int8*[chanNum];
+	chanIdents = new dsf2flac_int8*[chanNum]();
+	chanIdentsAllocated = true;
 	for (dsf2flac_uint16 i=0; i<chanNum; i++) {
 		chanIdents[i] = new dsf2flac_int8[5];
 		if (file.read_int8(chanIdents[i],4)) {
@@ -613,6 +864,8 @@ bool DsdiffFileReader::readChunk_ID3(dsf2flac_uint64 chunkStart)
 		return false;
 	}
 	// read the full id3 data
+	if (!file.canRead(id3tagLen))
+		return false;
 	dsf2flac_uint8* id3tag = new dsf2flac_uint8[ id3tagLen ];
 	if (file.read_uint8(id3tag,id3tagLen)) {
 		return false;
@@ -801,7 +1054,7 @@ bool DsdiffFileReader::readChunk_DSTI(dsf2flac_uint64 chunkStart)
 		errorMsg = "dsdiffFileReader::readChunk_DSTI:chunk ident error";
 		return false;
 	}
-	dsf2flac_uint64 n = (chunkSz - 12)/(32+64);
+	dsf2flac_uint64 n = (chunkSz - 12)/(8+4); // a 64 bit offset and a 32 bit length per frame
 	for (dsf2flac_uint64 i=0; i<n; i++) {
 		DSTFrameIndex in;
 		if (file.read_uint64_rev(&in.offset,1)) {
@@ -874,7 +1127,7 @@ bool DsdiffFileReader::readChunk_MARK(dsf2flac_uint64 chunkStart)
 		return false;
 	}
 	if (m.count % 2)
-		file.seekg(1,fstreamPlus::cur);
+		file.seekg(1,std::ios_base::cur);
 	markers.push_back(m);
 	//dispMarker(m);
 	return true;
@@ -890,6 +1143,70 @@ dsf2flac_uint64 decodeMarkerPosition(DsdiffAst ast, DsdiffMarker marker, dsf2fla
 	return pos; // note div by 8 to give position in chars
 }
 
+/// Appends a big endian number to a chunk being built up.
+template<typename T> static void appendBigEndian(std::vector<dsf2flac_uint8>& chunk, T x)
+{
+	for (int i = sizeof(T) - 1; i >= 0; i--)
+		chunk.push_back((dsf2flac_uint8)(x >> 8*i));
+}
+
+/// Appends a chunk, its header with the size and then the padding byte if the size is odd.
+static void appendChunk(std::vector<dsf2flac_uint8>& chunk, const char* ident, const std::vector<dsf2flac_uint8>& data)
+{
+	chunk.insert(chunk.end(),ident,ident + 4);
+	appendBigEndian<dsf2flac_uint64>(chunk,data.size());
+	chunk.insert(chunk.end(),data.begin(),data.end());
+	if (data.size() & 1)
+		chunk.push_back(0);
+}
+
+/// Appends a DIAR or DITI chunk: the length of the text and then the text.
+static void appendTextChunk(std::vector<dsf2flac_uint8>& chunk, const char* ident, const char* text)
+{
+	std::vector<dsf2flac_uint8> data;
+	dsf2flac_uint32 count = strlen(text);
+	appendBigEndian(data,count);
+	data.insert(data.end(),text,text + count);
+	appendChunk(chunk,ident,data);
+}
+
+std::vector<dsf2flac_uint8> DsdiffFileReader::getDiinChunk()
+{
+	std::vector<dsf2flac_uint8> diin;
+	if (emid) {
+		std::vector<dsf2flac_uint8> data(emid,emid + strlen(emid));
+		appendChunk(diin,"EMID",data);
+	}
+	for (dsf2flac_uint32 i = 0; i < markers.size(); i++) {
+		const DsdiffMarker& m = markers[i];
+		// the time from the start of the sound data, the offset is kept as it is
+		dsf2flac_int64 t = (dsf2flac_int64)decodeMarkerPosition(ast,m,samplingFreq) - m.offset;
+		if (t < 0)
+			t = 0;
+		std::vector<dsf2flac_uint8> data;
+		appendBigEndian<dsf2flac_uint16>(data,t / samplingFreq / 3600);
+		appendBigEndian<dsf2flac_uint8>(data,t / samplingFreq / 60 % 60);
+		appendBigEndian<dsf2flac_uint8>(data,t / samplingFreq % 60);
+		appendBigEndian<dsf2flac_uint32>(data,t % samplingFreq);
+		appendBigEndian(data,m.offset);
+		appendBigEndian(data,m.markType);
+		appendBigEndian(data,m.markChannel);
+		appendBigEndian(data,m.trackFlags);
+		appendBigEndian(data,m.count);
+		data.insert(data.end(),m.markerText,m.markerText + m.count);
+		appendChunk(diin,"MARK",data);
+	}
+	if (diar)
+		appendTextChunk(diin,"DIAR",diar);
+	if (diti)
+		appendTextChunk(diin,"DITI",diti);
+	if (diin.empty())
+		return diin;
+	std::vector<dsf2flac_uint8> chunk;
+	appendChunk(chunk,"DIIN",diin);
+	return chunk;
+}
+
 void DsdiffFileReader::processTracks() {
 	
 	numTracks = 0;
@@ -999,7 +1316,7 @@ bool DsdiffFileReader::readChunk_COMT(dsf2flac_uint64 chunkStart)
 			return false;
 		}
 		if (c.count % 2)
-			file.seekg(1,fstreamPlus::cur);
+			file.seekg(1,std::ios_base::cur);
 		comments.push_back(c);
 	}
 	return true;
@@ -1052,18 +1369,54 @@ bool DsdiffFileReader::readChunk_DSTF(dsf2flac_uint64 chunkStart)
 		return false;
 	}
 	dsf2flac_uint64 dst_framesize = chunkLen-12;
-	dsf2flac_uint8* dst_data = new dsf2flac_uint8[dst_framesize];
-	if (file.read_uint8_rev(dst_data,dst_framesize)) {
+	if (chunkLen < 12 || !file.canRead(dst_framesize)) {
+		errorMsg = "dsdiffFileReader::readChunk_DSTF:chunk size error";
+		return false;
+	}
+	if (dst_framesize > dstFrameBufferLen)
+		allocateDstFrameBuffer(dst_framesize);
+	if (file.read_uint8(dstFrameBuffer,dst_framesize)) {
 		errorMsg = "dsdiffFileReader::readChunk_DSTF:file read error";
 		return false;
 	}
 	
-	if (DST_FramDSTDecode(dst_data, sampleBuffer,dst_framesize, dstInfo.numFrames, &dstEbunch))
+	if (DST_FramDSTDecode(dstFrameBuffer, sampleBuffer,dst_framesize, dstInfo.numFrames, &dstEbunch)) {
+		errorMsg = "dsdiffFileReader::readChunk_DSTF:DST decode error";
 		return false;
+	}
 	
 	return true;
 }
 
+bool DsdiffFileReader::readChunk_DSTC(dsf2flac_uint64 chunkStart, dsf2flac_int64 frame)
+{
+	// read the header so that we are certain we are in the correct place.
+	dsf2flac_int8 ident[5];
+	ident[4]='\0';
+	dsf2flac_uint64 chunkSz;
+	if (!readChunkHeader(ident,chunkStart,&chunkSz))
+		return false;
+	// check the ident
+	if ( !checkIdent(ident,const_cast<dsf2flac_int8*>("DSTC")) ) {
+		errorMsg = "dsdiffFileReader::readChunk_DSTC:chunk ident error";
+		return false;
+	}
+	// the CRC is stored big endian, only 4 byte ones are understood.
+	dsf2flac_uint32 crc;
+	if (chunkSz < 12+4 || file.read_uint32_rev(&crc,1)) {
+		errorMsg = "dsdiffFileReader::readChunk_DSTC:chunk size error";
+		return false;
+	}
+	dstFramesChecked++;
+	if (crc == dst_frame_crc(sampleBuffer,chanNum*sampleBufferLenPerChan))
+		return true;
+	dstCrcErrors++;
+	if (dstFirstBadFrame < 0)
+		dstFirstBadFrame = frame;
+	errorMsg = "dsdiffFileReader::readChunk_DSTC:CRC error";
+	return false;
+}
+
 bool DsdiffFileReader::readChunk_DST(dsf2flac_uint64 chunkStart)
 {
 	// read the header so that we are certain we are in the correct place.
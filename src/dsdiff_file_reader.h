@@ -39,8 +39,11 @@
 #define DSDIFFFILEREADER_H
 
 #include "dsd_sample_reader.h" // Base class: dsdSampleReader
-#include "fstream_plus.h"
+#include "binary_reader.h"
+#include "libdstdec/types.h"
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <string>
+#include <atomic>
 
 // this struct holds comments
 typedef struct{
@@ -99,14 +102,20 @@ typedef struct {
  * Editied master files are supported, as is the undocumented ID3 chunk.
  * DST compression is also supported.
  */
-class DsdiffFileReader : public DsdSampleReader
+class DsdiffFileReader final : public DsdSampleReader
 {
 public:
 	/** Class constructor.
 	 *  filePath must be a valid dsdff file location.
 	 *  If there is an issue reading or loading the file then isValid() will be false.
+	 *  With headersOnly the chunks are read (including markers and tags) but the sample buffers are
+	 *  not set up, which is all that is needed to describe a file (see --probe).
 	 */
-	DsdiffFileReader(char* filePath);
+	DsdiffFileReader(char* filePath, bool headersOnly = false);
+	/** Class constructor for a dsdiff file which is already in memory.
+	 *  The length bytes at data are read in place, so they must remain valid for the life of the reader.
+	 */
+	DsdiffFileReader(const char* data, dsf2flac_uint64 length);
 	/** Class destructor.
 	 *  Closes the file and frees the internal buffers.
 	 */
@@ -115,6 +124,7 @@ public:
 	// public overridden from dsdSampleReader
 	bool step();
 	void rewind();
+	void seek(dsf2flac_int64 pos);
 	dsf2flac_int64 getLength() {return sampleCountPerChan;};
 	dsf2flac_uint32 getNumChannels() {return chanNum;};
 	dsf2flac_uint32 getSamplingFreq() {return samplingFreq;};
@@ -127,9 +137,55 @@ public:
 public: // other public methods
 	/// Can be called to display some useful info to stdout.
 	void dispFileInfo();
+	/// Returns true if the sound data is DST compressed.
+	bool isDst();
+	/// Returns the position in the file of the sound data (the interleaved samples when it isn't DST coded).
+	dsf2flac_uint64 getSampleDataPointer() { return sampleDataPointer; };
+	/** Returns a DIIN chunk (header and padding included) holding the edited master ID, markers, artist and title
+	 *  which were read, ready to be written into another dsdiff file of the same sound data. The marker times are
+	 *  made relative to the start of the sound data, as that file won't have an ABSS chunk. Empty if there is nothing to put in it.
+	 */
+	std::vector<dsf2flac_uint8> getDiinChunk();
+	/** DST files opened after this call keep the frame index they build (when they have no usable DSTI chunk)
+	 *  in a sidecar file next to them, <file>.dstidx, and reuse it while the file's size and modification time are unchanged.
+	 */
+	static void setUseIndexCache(bool useIndexCache);
+	/// The number of DST filters whose lookup tables were made, and reused from the frame before, by all of the readers closed so far.
+	static dsf2flac_uint64 getDstTablesMade() { return dstTablesMade; };
+	static dsf2flac_uint64 getDstTablesReused() { return dstTablesReused; };
+	/** DST files opened after this call check each frame which is followed by a DSTC chunk against the CRC in it
+	 *  (see dst_frame_crc.h). A frame which doesn't match is still used, it is only counted in getDstCrcErrors().
+	 */
+	static void setVerifyDstCrc(bool verifyDstCrc);
+	static bool getVerifyDstCrc() { return verifyDstCrc; };
+	/// The number of DST frames whose CRC was checked, and how many of those didn't match.
+	dsf2flac_uint64 getDstFramesChecked() { return dstFramesChecked; };
+	dsf2flac_uint64 getDstCrcErrors() { return dstCrcErrors; };
+	/// The number of DST frames which couldn't be read or decoded (silence was used instead).
+	dsf2flac_uint64 getDstDecodeErrors() { return dstDecodeErrors; };
+	/// The first DST frame which couldn't be decoded or didn't match its CRC, -1 if there hasn't been one.
+	dsf2flac_int64 getFirstBadDstFrame() { return dstFirstBadFrame; };
 private: // private methods
+	/// Sets the defaults which the constructors need before anything is read.
+	void setDefaults();
+	/// Reads the headers once the file is open and gets ready to read samples (shared by the constructors).
+	void init(bool headersOnly);
+	/// Finds the start of the chunk holding a DST frame using the DSTI index, returns false if it can't.
+	bool findDstFrame(dsf2flac_uint64 frame, dsf2flac_uint64* chunkStart);
+	/// Checks that the DSTI index covers every frame and works out what its offsets point at.
+	void checkDstIndex();
+	/// Makes a frame index for a file without a usable DSTI chunk, from the sidecar cache or by scanning the frame chunks.
+	void buildDstIndex();
+	/// Finds the DSTF chunks by hopping from one chunk header to the next (nothing is decoded).
+	bool scanDstFrames();
+	/// Reads the frame index from the sidecar cache, returns false if there isn't one for this version of the file.
+	bool loadDstIndexCache();
+	/// Writes the frame index to the sidecar cache (silently gives up if it can't).
+	void saveDstIndexCache();
 	/// Allocate the buffer to hold samples
 	void allocateSampleBuffer();
+	/// (Re)allocate the buffer which DST frames are read into to hold len bytes
+	void allocateDstFrameBuffer(dsf2flac_uint64 len);
 	/// Read the next block of samples into the buffer.
 	bool readNextBlock();
 	/// Finds the number, start and end points of the tracks in the file.
@@ -162,6 +218,8 @@ private: // private methods
 	bool readChunk_DST(dsf2flac_uint64 chunkStart);
 	/// read data from a DSTF chunk
 	bool readChunk_DSTF(dsf2flac_uint64 chunkStart);
+	/// read the CRC from a DSTC chunk and check the frame just decoded against it
+	bool readChunk_DSTC(dsf2flac_uint64 chunkStart, dsf2flac_int64 frame);
 	/// read data from a COMT chunk
 	bool readChunk_COMT(dsf2flac_uint64 chunkStart);
 	/// read data from a LSCO chunk
@@ -193,12 +251,18 @@ private: // private methods
 	void dispMarker(DsdiffMarker m);
 private:
 	// private variables
-	fstreamPlus file;
+	BinaryReader file;
+	std::string filePath; // empty when reading from memory
+	static bool useIndexCache;
+	static bool verifyDstCrc;
+	static std::atomic<dsf2flac_uint64> dstTablesMade;
+	static std::atomic<dsf2flac_uint64> dstTablesReused;
 	// read from the file - these are always present...
 	dsf2flac_uint32 dsdiffVersion;
 	dsf2flac_uint32 samplingFreq;
 	dsf2flac_uint16 chanNum;
 	dsf2flac_int8** chanIdents;
+	bool chanIdentsAllocated;
 	dsf2flac_int8  compressionType[5];
 	dsf2flac_int8* compressionName;
 	DsdiffAst ast;
@@ -214,6 +278,9 @@ private:
 	char* diar;
 	char* diti;
 	std::vector<DSTFrameIndex> dstFrameIndices;
+	bool dstIndexUsable; // dstFrameIndices can be used to seek (see checkDstIndex)
+	dsf2flac_uint32 dstIndexAdjust; // subtracted from the DSTI offsets to get the start of the frame chunks
+	bool dstIndexBuilt; // buildDstIndex has been tried
 	DSTFrameInformation dstInfo;
 	// track info
 	dsf2flac_uint32 numTracks;
@@ -221,11 +288,46 @@ private:
 	std::vector<dsf2flac_uint64> trackEndPositions;
 	
 	// vars to hold the data
-	dsf2flac_uint8* sampleBuffer;
+	dsf2flac_uint8* sampleBuffer; // interleaved, as in the file
+	dsf2flac_uint8* planarBuffer; // sampleBuffer split into one run of sampleBufferLenPerChan bytes per channel
 	dsf2flac_uint32 sampleBufferLenPerChan;
 	dsf2flac_int64 bufferCounter; // stores the index to the current blockBuffer
 	dsf2flac_int64 bufferMarker; // stores the current position in the blockBuffer
+	bool sampleBufferAllocated;
+	// DST decoder state
+	dsf2flac_uint8* dstFrameBuffer; // one DST frame as read from the file, reused for every frame
+	dsf2flac_uint64 dstFrameBufferLen;
+	ebunch dstEbunch;
+	bool dstEbunchAllocated;
+	// DST frame checks
+	dsf2flac_uint64 dstFramesChecked;
+	dsf2flac_uint64 dstCrcErrors;
+	dsf2flac_uint64 dstDecodeErrors;
+	dsf2flac_int64 dstFirstBadFrame;
 	
 };
 
+/// step() is defined here so that it can be inlined when the reader type is known (see pcm_track_helper in main.cpp).
+inline bool DsdiffFileReader::step()
+{
+	bool ok = true;
+	
+	if (!samplesAvailable())
+		ok = false;
+	else if (bufferMarker>=sampleBufferLenPerChan)
+		ok = readNextBlock();
+	
+	if (ok) {
+		for (dsf2flac_uint16 i=0; i<chanNum; i++)
+			circularBuffers[i].push_front(planarBuffer[i*sampleBufferLenPerChan+bufferMarker]);
+		bufferMarker++;
+	} else {
+		for (dsf2flac_uint16 i=0; i<chanNum; i++)
+			circularBuffers[i].push_front(getIdleSample());
+	}
+	
+	posMarker++;
+	return ok;
+}
+
 #endif // DSDIFFFILEREADER_H
@@ -0,0 +1,348 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+
+#include "dsdiff_file_writer.h"
+#include "dst_frame_crc.h"
+#include "libdstdec/dst_init.h"
+#include "libdstdec/dst_fram.h"
+#include <cstring>
+#include <algorithm>
+#include <thread>
+
+// the DST frames are 1/75 of a second long
+static const dsf2flac_uint16 dstFrameRate = 75;
+static const char dstCompressionName[] = "DST Encoded";
+static const char dsdCompressionName[] = "not compressed";
+
+DsdiffFileWriter::DsdiffFileWriter(const char* filePath, dsf2flac_uint32 fs, dsf2flac_uint32 nch, bool useDst, dsf2flac_uint32 nThreads) : DsdSampleWriter()
+{
+	file = NULL;
+	closed = true;
+	dst = useDst;
+	samplingFreq = fs;
+	numChannels = nch;
+	numThreads = nThreads > 0 ? nThreads : 1;
+	frameBytes = fs / dstFrameRate / 8 * nch;
+	batchFrames = numThreads * 4;
+	batchBuffer = NULL;
+	batchFill = 0;
+	dstBuffer = NULL;
+	dstStride = frameBytes + 1 + 8; // a plain frame is one byte longer than the DSD data, and the decoder may read a little past the end
+	nextFrame = 0;
+	encoders = NULL;
+	decoders = NULL;
+	checkBuffer = NULL;
+	frm8Start = 0;
+	soundStart = 0;
+	frteFramesPos = 0;
+	codedFrames = 0;
+	verifyErrors = 0;
+	dstBytes = 0;
+	dsdBytes = 0;
+
+	if (nch < 1 || nch > 1000 || fs % 44100) {
+		errorMsg = "dsdiffFileWriter::dsdiffFileWriter:unsupported number of channels or sampling frequency";
+		return;
+	}
+	if (dst && (fs != 2822400 || nch > MAX_CHANNELS)) {
+		errorMsg = "dsdiffFileWriter::dsdiffFileWriter:DST coding needs 2822400Hz DSD with 1 to 6 channels";
+		return;
+	}
+	if (!strcmp(filePath,"-")) {
+		errorMsg = "dsdiffFileWriter::dsdiffFileWriter:can't write to stdout, the chunk sizes are filled in at the end";
+		return;
+	}
+
+	if (dst) {
+		// an encoder and a decoder for each thread
+		encoders = new encbunch[numThreads]();
+		decoders = new ebunch[numThreads]();
+		for (dsf2flac_uint32 t=0; t<numThreads; t++) {
+			if (DST_InitEncoder(&encoders[t],nch,fs/44100,128)) {
+				errorMsg = "dsdiffFileWriter::dsdiffFileWriter:DST encoder init error";
+				return;
+			}
+			DST_InitDecoder(&decoders[t],nch,fs/44100);
+		}
+		batchBuffer = new dsf2flac_uint8[(size_t)batchFrames*frameBytes];
+		dstBuffer = new dsf2flac_uint8[(size_t)batchFrames*dstStride];
+		dstLength.resize(batchFrames);
+		checkBuffer = new dsf2flac_uint8[(size_t)numThreads*frameBytes];
+	}
+
+	file = fopen(filePath,"wb");
+	if (!file) {
+		errorMsg = "dsdiffFileWriter::dsdiffFileWriter:can't create the file";
+		return;
+	}
+	closed = false;
+
+	// FRM8 (the size is filled in by close()), FVER and PROP
+	const char* compressionName = dst ? dstCompressionName : dsdCompressionName;
+	dsf2flac_uint64 cmprSize = 4 + 1 + strlen(compressionName);
+	cmprSize += cmprSize & 1;
+	dsf2flac_uint64 propSize = 4 + (12 + 4) + (12 + 2 + 4*nch) + (12 + cmprSize);
+	bool ok = writeChunkHeader("FRM8",0);
+	frm8Start = ftello(file) - 12;
+	ok = ok && fwrite("DSD ",4,1,file) == 1;
+	ok = ok && writeChunkHeader("FVER",4) && writeUint32(0x01050000);
+	ok = ok && writeChunkHeader("PROP",propSize) && fwrite("SND ",4,1,file) == 1;
+	ok = ok && writeChunkHeader("FS  ",4) && writeUint32(fs);
+	ok = ok && writeChunkHeader("CHNL",2 + 4*nch) && writeUint16(nch);
+	for (dsf2flac_uint32 c=0; ok && c<nch; c++) {
+		char id[8];
+		if (nch == 2)
+			memcpy(id,c ? "SRGT" : "SLFT",4);
+		else if (nch == 5 || nch == 6)
+			memcpy(id,&"MLFTMRGTC   LFE LS  RS  "[4*(c + (nch == 5 && c > 2))],4);
+		else
+			snprintf(id,sizeof(id),"C%03d",(int)c);
+		ok = fwrite(id,4,1,file) == 1;
+	}
+	ok = ok && writeChunkHeader("CMPR",cmprSize) && fwrite(dst ? "DST " : "DSD ",4,1,file) == 1;
+	ok = ok && fputc(strlen(compressionName),file) != EOF;
+	ok = ok && fwrite(compressionName,cmprSize - 5,1,file) == 1; // includes the terminating zero as the pad byte
+
+	// the sound data chunk (its size is filled in by close()), the DST one starts with the frame count
+	ok = ok && writeChunkHeader(dst ? "DST " : "DSD ",0);
+	soundStart = ftello(file) - 12;
+	if (dst) {
+		ok = ok && writeChunkHeader("FRTE",6);
+		frteFramesPos = ftello(file);
+		ok = ok && writeUint32(0) && writeUint16(dstFrameRate);
+	}
+	if (!ok) {
+		errorMsg = "dsdiffFileWriter::dsdiffFileWriter:file write error";
+		return;
+	}
+	valid = true;
+}
+
+DsdiffFileWriter::~DsdiffFileWriter()
+{
+	if (!closed)
+		close();
+	if (encoders) {
+		for (dsf2flac_uint32 t=0; t<numThreads; t++)
+			DST_CloseEncoder(&encoders[t]);
+		delete[] encoders;
+	}
+	if (decoders) {
+		for (dsf2flac_uint32 t=0; t<numThreads; t++)
+			DST_CloseDecoder(&decoders[t]);
+		delete[] decoders;
+	}
+	delete[] batchBuffer;
+	delete[] dstBuffer;
+	delete[] checkBuffer;
+}
+
+bool DsdiffFileWriter::write(const dsf2flac_uint8* data, dsf2flac_uint64 len)
+{
+	if (!valid)
+		return false;
+	if (!dst) {
+		if (len > 0 && fwrite(data,len,1,file) != 1) {
+			errorMsg = "dsdiffFileWriter::write:file write error";
+			valid = false;
+			return false;
+		}
+		dsdBytes += len;
+		return true;
+	}
+	const dsf2flac_uint64 batchBytes = (dsf2flac_uint64)batchFrames*frameBytes;
+	while (len > 0) {
+		dsf2flac_uint64 n = std::min(len,batchBytes - batchFill);
+		memcpy(&batchBuffer[batchFill],data,n);
+		batchFill += n;
+		data += n;
+		len -= n;
+		if (batchFill == batchBytes && !writeFrames(batchFrames))
+			return false;
+	}
+	return true;
+}
+
+bool DsdiffFileWriter::copy(int fd, dsf2flac_uint64 offset, dsf2flac_uint64 len)
+{
+	if (!valid)
+		return false;
+	if (dst) {
+		errorMsg = "dsdiffFileWriter::copy:DST frames have to be encoded";
+		valid = false;
+		return false;
+	}
+	if (!copyToFile(file,fd,offset,len)) {
+		errorMsg = "dsdiffFileWriter::copy:file copy error";
+		valid = false;
+		return false;
+	}
+	dsdBytes += len;
+	return true;
+}
+
+bool DsdiffFileWriter::close()
+{
+	if (closed)
+		return valid;
+	// pad the last frame with silence, the frames are all the same length
+	if (valid && batchFill % frameBytes) {
+		dsf2flac_uint64 n = frameBytes - batchFill % frameBytes;
+		memset(&batchBuffer[batchFill],0x69,n);
+		batchFill += n;
+	}
+	bool ok = valid && (!dst || writeFrames(batchFill / frameBytes));
+	dsf2flac_int64 soundEnd = ok ? ftello(file) : 0;
+	if (ok && (soundEnd - soundStart) & 1)
+		ok = fputc(0,file) != EOF;
+
+	// the markers, the DST index and the tag, then the sizes and the frame count
+	if (!diinChunk.empty())
+		ok = ok && fwrite(diinChunk.data(),diinChunk.size(),1,file) == 1;
+	if (dst) {
+		ok = ok && writeChunkHeader("DSTI",12*frameOffsets.size());
+		for (dsf2flac_uint64 i=0; ok && i<frameOffsets.size(); i++)
+			ok = writeUint64(frameOffsets[i]) && writeUint32(frameLengths[i]);
+	}
+	if (!id3Data.empty()) {
+		ok = ok && writeChunkHeader("ID3 ",id3Data.size()) && fwrite(id3Data.data(),id3Data.size(),1,file) == 1;
+		if (ok && (id3Data.size() & 1))
+			ok = fputc(0,file) != EOF;
+	}
+	dsf2flac_int64 end = ok ? ftello(file) : 0;
+	ok = ok && patchUint64(soundStart + 4,soundEnd - soundStart - 12);
+	if (dst)
+		ok = ok && patchUint32(frteFramesPos,frameOffsets.size());
+	ok = ok && patchUint64(frm8Start + 4,end - frm8Start - 12);
+	ok = !fclose(file) && ok;
+	file = NULL;
+	closed = true;
+	if (!ok && valid) {
+		errorMsg = "dsdiffFileWriter::close:file write error";
+		valid = false;
+	}
+	return ok;
+}
+
+bool DsdiffFileWriter::writeFrames(dsf2flac_uint32 n)
+{
+	// encode the frames
+	nextFrame = 0;
+	dsf2flac_uint32 nt = std::min(numThreads,n);
+	std::vector<std::thread> threads;
+	for (dsf2flac_uint32 t=1; t<nt; t++)
+		threads.push_back(std::thread(&DsdiffFileWriter::encodeFrames,this,t,n));
+	encodeFrames(0,n);
+	for (dsf2flac_uint32 t=0; t<threads.size(); t++)
+		threads[t].join();
+
+	// and write them in order, each DSTF followed by a DSTC with the CRC of its DSD data (the DSDIFF one, see dst_frame_crc.h)
+	bool ok = true;
+	for (dsf2flac_uint32 i=0; ok && i<n; i++) {
+		const dsf2flac_uint8* dst = &dstBuffer[(size_t)i*dstStride];
+		dsf2flac_uint32 len = dstLength[i];
+		dsf2flac_int64 pos = ftello(file);
+		ok = writeChunkHeader("DSTF",len) && fwrite(dst,len,1,file) == 1;
+		if (ok && (len & 1))
+			ok = fputc(0,file) != EOF;
+		ok = ok && writeChunkHeader("DSTC",4) && writeUint32(dst_frame_crc(&batchBuffer[(size_t)i*frameBytes],frameBytes));
+		frameOffsets.push_back(pos);
+		frameLengths.push_back(len);
+		if (dst[0] & 0x80)
+			codedFrames++;
+		dstBytes += 12 + len + (len & 1);
+		dsdBytes += frameBytes;
+	}
+	batchFill = 0;
+	if (!ok) {
+		errorMsg = "dsdiffFileWriter::writeFrames:file write error";
+		valid = false;
+	}
+	return ok;
+}
+
+void DsdiffFileWriter::encodeFrames(dsf2flac_uint32 t, dsf2flac_uint32 n)
+{
+	dsf2flac_uint8* check = &checkBuffer[(size_t)t*frameBytes];
+	for (dsf2flac_uint32 i = nextFrame++; i < n; i = nextFrame++) {
+		dsf2flac_uint8* dsd = &batchBuffer[(size_t)i*frameBytes];
+		dsf2flac_uint8* dst = &dstBuffer[(size_t)i*dstStride];
+		int len = 0;
+		DST_FramDSTEncode(dsd,dst,&len,&encoders[t]);
+		memset(&dst[len],0,8);
+		// decode it again, anything but the same DSD data goes in as it is
+		if (DST_FramDSTDecode(dst,check,len,frameOffsets.size() + i,&decoders[t]) || memcmp(check,dsd,frameBytes)) {
+			verifyErrors++;
+			dst[0] = 0;
+			memcpy(&dst[1],dsd,frameBytes);
+			len = frameBytes + 1;
+		}
+		dstLength[i] = len;
+	}
+}
+
+bool DsdiffFileWriter::writeChunkHeader(const char* id, dsf2flac_uint64 size)
+{
+	return fwrite(id,4,1,file) == 1 && writeUint64(size);
+}
+
+bool DsdiffFileWriter::writeUint16(dsf2flac_uint16 x)
+{
+	dsf2flac_uint8 b[2] = { (dsf2flac_uint8)(x >> 8), (dsf2flac_uint8)x };
+	return fwrite(b,2,1,file) == 1;
+}
+
+bool DsdiffFileWriter::writeUint32(dsf2flac_uint32 x)
+{
+	return writeUint16(x >> 16) && writeUint16(x);
+}
+
+bool DsdiffFileWriter::writeUint64(dsf2flac_uint64 x)
+{
+	return writeUint32(x >> 32) && writeUint32(x);
+}
+
+bool DsdiffFileWriter::patchUint32(dsf2flac_int64 pos, dsf2flac_uint32 x)
+{
+	return !fseeko(file,pos,SEEK_SET) && writeUint32(x);
+}
+
+bool DsdiffFileWriter::patchUint64(dsf2flac_int64 pos, dsf2flac_uint64 x)
+{
+	return !fseeko(file,pos,SEEK_SET) && writeUint64(x);
+}
@@ -0,0 +1,161 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsdiff_file_writer.h
+  *
+  * Header file for the class DsdiffFileWriter.
+  *
+  * Writes DSD audio to a DSDIFF (.dff) file, as plain DSD or DST compressed.
+  *
+  */
+
+#ifndef DSDIFFFILEWRITER_H
+#define DSDIFFFILEWRITER_H
+
+#include "dsd_sample_writer.h" // Base class: DsdSampleWriter
+#include "libdstenc/dst_enc.h"
+#include "libdstdec/types.h"
+#include <cstdio>
+#include <vector>
+#include <atomic>
+
+/**
+ * The DsdiffFileWriter takes interleaved DSD bytes (one byte per channel in turn, the msb played first,
+ * just as they are in a dsdiff file). Plain DSD is written as it comes into a "DSD " sound data chunk.
+ * With DST the bytes are collected into frames of 1/75 of a second.
+ *
+ * DST frames are collected into batches which are encoded by several threads at once and then written
+ * in order. Each DSTF frame chunk is followed by a DSTC chunk with the CRC of the frame's DSD data
+ * (see dst_frame_crc.h), and a DSTI index of the frames is written after the sound data.
+ *
+ * Every frame is decoded again with the libdstdec decoder before it is written. A frame which doesn't
+ * decode to exactly the DSD data it was made from is written as plain DSD instead (in a DST frame) and
+ * counted in getVerifyErrors(), so the file is always lossless.
+ *
+ * Only 2822400Hz (DSD64) with up to 6 channels can be DST coded, as for the decoder.
+ *
+ * The tag (see setID3Tag()) goes into an "ID3 " chunk at the end, where the DsdiffFileReader finds it.
+ */
+class DsdiffFileWriter final : public DsdSampleWriter
+{
+public:
+	/** Class constructor.
+	 *  Creates the file at filePath and writes the headers. With dst the sound data is DST coded,
+	 *  numThreads frames at a time. If there is an issue creating the file then isValid() will be false.
+	 */
+	DsdiffFileWriter(const char* filePath, dsf2flac_uint32 samplingFreq, dsf2flac_uint32 numChannels, bool dst, dsf2flac_uint32 numThreads = 1);
+	/** Class destructor.
+	 *  Calls close() if it hasn't been called.
+	 */
+	virtual ~DsdiffFileWriter();
+public:
+	// public overridden from dsdSampleWriter
+	dsf2flac_uint32 getNumChannels() { return numChannels; };
+	bool msbIsPlayedFirst() { return false; };
+	bool write(const dsf2flac_uint8* data, dsf2flac_uint64 len);
+	/// Takes the interleaved bytes of a "DSD " sound data chunk, only when the output isn't DST coded.
+	bool copy(int fd, dsf2flac_uint64 offset, dsf2flac_uint64 len);
+	/** Writes what is left, the markers, the index, the tag and the chunk sizes, and closes the file.
+	 *  DST frames all hold 1/75 of a second, so the last one is padded with silence (0x69) and the
+	 *  sound data of a DST coded file is that much longer than what was written.
+	 */
+	bool close();
+public: // other public methods
+	/// Sets a DIIN chunk to write after the sound data (see DsdiffFileReader::getDiinChunk()), must be called before close().
+	void setDiinChunk(const std::vector<dsf2flac_uint8>& chunk) { diinChunk = chunk; };
+	/// Returns true if the sound data is DST coded.
+	bool isDst() { return dst; };
+	/// The number of DST frames written, how many of those are DST coded and how many are plain DSD.
+	dsf2flac_uint64 getFrames() { return frameOffsets.size(); };
+	dsf2flac_uint64 getCodedFrames() { return codedFrames; };
+	dsf2flac_uint64 getPlainFrames() { return frameOffsets.size() - codedFrames; };
+	/// The number of frames which didn't decode to their DSD data and were written as plain DSD.
+	dsf2flac_uint64 getVerifyErrors() { return verifyErrors; };
+	/// The size of the DST coded sound data, including the chunk headers of the frames.
+	dsf2flac_uint64 getDstBytes() { return dstBytes; };
+	/// The size of the DSD data which went in (including the padding of the last DST frame).
+	dsf2flac_uint64 getDsdBytes() { return dsdBytes; };
+private: // private methods
+	/// Encodes the first n frames of the batch buffer (in numThreads threads) and writes them.
+	bool writeFrames(dsf2flac_uint32 n);
+	/// Encodes and checks the frames of the batch, taking them from nextFrame until there are none left (one call per thread).
+	void encodeFrames(dsf2flac_uint32 thread, dsf2flac_uint32 n);
+	/// Write a chunk header (the id and a size), returns false on error.
+	bool writeChunkHeader(const char* id, dsf2flac_uint64 size);
+	/// Write big endian numbers, return false on error.
+	bool writeUint16(dsf2flac_uint16 x);
+	bool writeUint32(dsf2flac_uint32 x);
+	bool writeUint64(dsf2flac_uint64 x);
+	/// Overwrite the big endian number at pos, return false on error.
+	bool patchUint32(dsf2flac_int64 pos, dsf2flac_uint32 x);
+	bool patchUint64(dsf2flac_int64 pos, dsf2flac_uint64 x);
+private:
+	FILE* file;
+	bool closed;
+	bool dst;
+	dsf2flac_uint32 samplingFreq;
+	dsf2flac_uint32 numChannels;
+	dsf2flac_uint32 numThreads;
+	dsf2flac_uint32 frameBytes; // DSD bytes in a frame (all channels)
+	dsf2flac_uint32 batchFrames; // frames encoded at a time
+	// the frames being collected, and the DST frames they are encoded into
+	dsf2flac_uint8* batchBuffer; // batchFrames*frameBytes
+	dsf2flac_uint64 batchFill;
+	dsf2flac_uint8* dstBuffer; // batchFrames*dstStride
+	dsf2flac_uint32 dstStride;
+	std::vector<int> dstLength;
+	std::atomic<dsf2flac_uint32> nextFrame;
+	// an encoder and a decoder (with its output) for each thread
+	encbunch* encoders;
+	ebunch* decoders;
+	dsf2flac_uint8* checkBuffer; // numThreads*frameBytes
+	std::vector<dsf2flac_uint8> diinChunk; // written as it is, empty if there isn't one
+	// where things are in the file
+	dsf2flac_int64 frm8Start;
+	dsf2flac_int64 soundStart; // the DSD or DST chunk
+	dsf2flac_int64 frteFramesPos;
+	std::vector<dsf2flac_uint64> frameOffsets;
+	std::vector<dsf2flac_uint32> frameLengths;
+	// stats
+	dsf2flac_uint64 codedFrames;
+	std::atomic<dsf2flac_uint64> verifyErrors;
+	dsf2flac_uint64 dstBytes;
+	dsf2flac_uint64 dsdBytes;
+};
+
+#endif // DSDIFFFILEWRITER_H
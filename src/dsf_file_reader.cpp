@@ -37,14 +37,26 @@
 
 #include <dsf_file_reader.h>
 
-static bool blockBufferAllocated = false;
-
-DsfFileReader::DsfFileReader(char* filePath) : DsdSampleReader()
+DsfFileReader::DsfFileReader(char* filePath, bool headersOnly) : DsdSampleReader()
 {
 	this->filePath = filePath;
+	blockBufferAllocated = false;
 	// first let's open the file
-	file.open(filePath, fstreamPlus::in | fstreamPlus::binary);
-	// throw exception if that did not work.
+	file.open(filePath);
+	init(headersOnly);
+}
+
+DsfFileReader::DsfFileReader(const char* data, dsf2flac_uint64 length) : DsdSampleReader()
+{
+	filePath = NULL;
+	blockBufferAllocated = false;
+	file.openMemory(data,length);
+	init(false);
+}
+
+void DsfFileReader::init(bool headersOnly)
+{
+	// throw exception if the file could not be opened.
 	if (!file.is_open()) {
 		errorMsg = "could not open file";
 		valid = false;
@@ -53,17 +65,12 @@ DsfFileReader::DsfFileReader(char* filePath) : DsdSampleReader()
 	// read the header data
 	if (!(valid = readHeaders()))
 		return;
-
-	// this code only works with single bit data (could be upgraded later on)
-	if (samplesPerChar!=8) {
-		errorMsg = "Sorry, only one bit data is supported";
-		valid = false;
-		return;
-	}
-	// read the metadata
-	readMetadata();
+	// read the metadata (it's at the end of the file, so a stream can't get at it without skipping the audio)
+	if (file.isSeekable())
+		readMetadata();
 	
-	rewind(); // calls clearBuffer -> allocateBuffer
+	if (!headersOnly)
+		rewind(); // calls clearBuffer -> allocateBuffer
 }
 
 DsfFileReader::~DsfFileReader()
@@ -80,45 +87,51 @@ DsfFileReader::~DsfFileReader()
 	}
 }
 
-bool DsfFileReader::step()
-{
-	bool ok = true;
-	
-	if (!samplesAvailable())
-		ok = false;
-	else if (blockMarker>=blockSzPerChan)
-		ok = readNextBlock();
-	
-	if (ok) {
-		for (dsf2flac_uint32 i=0; i<chanNum; i++)
-			circularBuffers[i].push_front(blockBuffer[i][blockMarker]);
-		blockMarker++;
-	} else {
-		for (dsf2flac_uint32 i=0; i<chanNum; i++)
-			circularBuffers[i].push_front(getIdleSample());
-	}
-
-	posMarker++;
-	return ok;
-}
-
 void DsfFileReader::rewind()
 {
-	// position the file at the start of the data chunk
-	if (file.seekg(sampleDataPointer)) {
+	// position the file at the start of the data chunk.
+	// a stream which has not been stepped through since the last rewind is already there (and can't go back).
+	file.clear();
+	if ((file.isSeekable() || posMarker != -1) && file.seekg(sampleDataPointer)) {
 		errorMsg = "dsfFileReader::readFirstBlock:file seek error";
 		return;
 	}
 	allocateBlockBuffer();
-	blockCounter = 0;
-	blockMarker = 0;
-	readNextBlock();
-	blockCounter = 0;
+	// nothing is read until the first step(), which finds the block buffer used up.
+	blockCounter = -1;
+	blockMarker = blockSzPerChan;
 	posMarker = -1;
 	clearBuffer();
 	return;
 }
 
+void DsfFileReader::seek(dsf2flac_int64 pos)
+{
+	dsf2flac_int64 target = pos < 0 ? -1 : pos/samplesPerChar;
+	// the circular buffers have to be refilled from the file, so stepping starts this far before the target
+	dsf2flac_int64 first = target + 1 - getBufferLength();
+	// streams and short hops forward just step there
+	if (!file.isSeekable() || (target >= posMarker && first <= posMarker + blockSzPerChan)) {
+		DsdSampleReader::seek(pos);
+		return;
+	}
+	// jump to the start of the block holding the first byte, with nothing read yet (see rewind)
+	dsf2flac_int64 block = first > 0 ? first/blockSzPerChan : 0;
+	dsf2flac_int64 lastBlock = (sampleCount/samplesPerChar)/blockSzPerChan;
+	if (block > lastBlock)
+		block = lastBlock;
+	file.clear();
+	if (file.seekg(sampleDataPointer + block*blockSzPerChan*chanNum)) {
+		errorMsg = "dsfFileReader::seek:file seek error";
+		return;
+	}
+	blockCounter = block - 1;
+	blockMarker = blockSzPerChan;
+	posMarker = block*blockSzPerChan - 1;
+	clearBuffer();
+	DsdSampleReader::seek(pos);
+}
+
 bool DsfFileReader::readNextBlock()
 {
 	// return false if this is the end of the file
@@ -236,16 +249,17 @@ bool DsfFileReader::readHeaders()
 		return false;
 	}
 	// 4 bytes bitsPerSample
-	dsf2flac_uint32 bitsPerSample = 0;
 	if (file.read_uint32(&bitsPerSample,1)) {
 		errorMsg = "dsfFileReader::readHeaders:file read error";
 		return false;
 	}
-	if (bitsPerSample==1) {
-		samplesPerChar = 8;
-	} else if (bitsPerSample==8) {
-		samplesPerChar = 1;
+	// the data is always packed 8 samples to a byte, bitsPerSample only gives the bit order:
+	// 1 means the lsb is played first, 8 means the msb is played first.
+	if (bitsPerSample!=1 && bitsPerSample!=8) {
+		errorMsg = "dsfFileReader::readHeaders:unsupported bits per sample";
+		return false;
 	}
+	samplesPerChar = 8;
 	// 8 bytes sampleCount
 	if (file.read_uint64(&sampleCount,1)) {
 		errorMsg = "dsfFileReader::readHeaders:file read error";
@@ -257,7 +271,7 @@ bool DsfFileReader::readHeaders()
 		return false;
 	}
 	// 4 bytes ununsed
-	if (file.seekg(4,fstreamPlus::cur)) {
+	if (file.seekg(4,std::ios_base::cur)) {
 		errorMsg = "dsfFileReader::readHeaders:file read error";
 		return false;
 	}
@@ -334,6 +348,8 @@ void DsfFileReader::readMetadata()
 		return;
 	}
 	// read the full id3 data
+	if (!file.canRead(id3tagLen))
+		return;
 	dsf2flac_uint8* id3tag = new dsf2flac_uint8[ id3tagLen ];
 	if (file.read_uint8(id3tag,id3tagLen)) {
 			return;
@@ -359,6 +375,7 @@ void DsfFileReader::dispFileInfo()
 	printf("chanType: %" PRIu32 "\n",chanType);
 	printf("chanNum: %" PRIu32 "\n",chanNum);
 	printf("samplingFreq: %" PRIu32 "\n",samplingFreq);
+	printf("bitsPerSample: %" PRIu32 "\n",bitsPerSample);
 	printf("samplesPerChar: %" PRIu32 "\n",samplesPerChar);
 	printf("sampleCount: %" PRIu64 "\n",sampleCount);
 	printf("blockSzPerChan: %" PRIu32 "\n",blockSzPerChan);
@@ -39,23 +39,29 @@
 #define DSFFILEREADER_H
 
 #include <dsd_sample_reader.h> // Base class: dsdSampleReader
-#include <fstream_plus.h>
+#include <binary_reader.h>
 
 /**
  * This class extends dsdSampleReader providing access to dsd samples and other info
  * from dsf files.
  *
  * Some of the rarer features of dsf are not well tested due to a lack of files:
- * 8bit dsd
+ * 8bit dsd (msb first data, which is passed on as is and handled by the decimators like dsdiff data)
  */
-class DsfFileReader : public DsdSampleReader
+class DsfFileReader final : public DsdSampleReader
 {
 public:
 	/** Class constructor.
 	 *  filePath must be a valid dsf file location.
 	 *  If there is an issue reading or loading the file then isValid() will be false.
+	 *  With headersOnly the file info and metadata are read but the reader is not made ready to read
+	 *  samples, which is all that is needed to describe a file (see --probe).
 	 */
-	DsfFileReader(char* filePath);
+	DsfFileReader(char* filePath, bool headersOnly = false);
+	/** Class constructor for a dsf file which is already in memory.
+	 *  The length bytes at data are read in place, so they must remain valid for the life of the reader.
+	 */
+	DsfFileReader(const char* data, dsf2flac_uint64 length);
 	/** Class destructor.
 	 *  Closes the file and frees the internal buffers.
 	 */
@@ -65,15 +71,23 @@ public: // methods overriding dsdSampleReader
 	dsf2flac_uint32 getSamplingFreq() {return samplingFreq;};
 	bool step();
 	void rewind();
+	void seek(dsf2flac_int64 pos);
 	dsf2flac_int64 getLength() {return sampleCount;};
 	dsf2flac_uint32 getNumChannels() {return chanNum;};
-	bool msbIsPlayedFirst() { return true;}
+	bool msbIsPlayedFirst() { return bitsPerSample == 1;} // true when the lsb is played first (the msb is the newest sample)
 	bool samplesAvailable() { return !file.eof() && DsdSampleReader::samplesAvailable(); }; // false when no more samples left
 	ID3_Tag getID3Tag(dsf2flac_uint32 trackNum) {return metadata;}
 public:
 	/// Can be called to display some useful info to stdout.
 	void dispFileInfo();
+	/// Returns the bitsPerSample field (1 for lsb first data, 8 for msb first data).
+	dsf2flac_uint32 getBitsPerSample() {return bitsPerSample;};
+	/// Returns the position in the file of the first block of samples, and the size of the blocks (per channel).
+	dsf2flac_uint64 getSampleDataPointer() {return sampleDataPointer;};
+	dsf2flac_uint32 getBlockSzPerChan() {return blockSzPerChan;};
 private:
+	/// Reads the headers once the file is open and gets ready to read samples (shared by the constructors).
+	void init(bool headersOnly);
 	/// Allocates the block buffer which holds the dsd data read from the file for when it is required by the circular buffer.
 	void allocateBlockBuffer();
 	/// Reads lots of info from the file.
@@ -87,7 +101,7 @@ private:
 private:
 	// private variables
 	char* filePath;
-	fstreamPlus file;
+	BinaryReader file;
 	// below store file info
 	dsf2flac_uint64 fileSz;
 	dsf2flac_uint64 metaChunkPointer;
@@ -98,6 +112,7 @@ private:
 	dsf2flac_uint32 chanType;
 	dsf2flac_uint32 chanNum;
 	dsf2flac_uint32 samplingFreq;
+	dsf2flac_uint32 bitsPerSample; // 1 or 8, the bit order of the data
 	dsf2flac_uint64 sampleCount; //per channel
 	dsf2flac_uint32 blockSzPerChan;
 	ID3_Tag metadata;
@@ -105,6 +120,30 @@ private:
 	dsf2flac_uint8** blockBuffer; // used to store blocks of raw data from the file
 	dsf2flac_int64 blockCounter; // stores the index to the current blockBuffer
 	dsf2flac_int64 blockMarker; // stores the current position in the blockBuffer
+	bool blockBufferAllocated;
 };
 
+/// step() is defined here so that it can be inlined when the reader type is known (see pcm_track_helper in main.cpp).
+inline bool DsfFileReader::step()
+{
+	bool ok = true;
+	
+	if (!samplesAvailable())
+		ok = false;
+	else if (blockMarker>=blockSzPerChan)
+		ok = readNextBlock();
+	
+	if (ok) {
+		for (dsf2flac_uint32 i=0; i<chanNum; i++)
+			circularBuffers[i].push_front(blockBuffer[i][blockMarker]);
+		blockMarker++;
+	} else {
+		for (dsf2flac_uint32 i=0; i<chanNum; i++)
+			circularBuffers[i].push_front(getIdleSample());
+	}
+
+	posMarker++;
+	return ok;
+}
+
 #endif // DSFFILEREADER_H
@@ -0,0 +1,204 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+
+#include "dsf_file_writer.h"
+#include "deinterleave.h"
+#include <cstring>
+#include <algorithm>
+
+// the dsf channel type for each number of channels
+static const dsf2flac_uint32 dsfChannelTypes[] = { 0, 1, 2, 3, 4, 6, 7 };
+
+DsfFileWriter::DsfFileWriter(const char* filePath, dsf2flac_uint32 fs, dsf2flac_uint32 nch) : DsdSampleWriter()
+{
+	file = NULL;
+	closed = true;
+	samplingFreq = fs;
+	numChannels = nch;
+	blockBuffer = NULL;
+	planarBuffer = NULL;
+	blockFill = 0;
+	bytesPerChan = 0;
+	fileSzPos = 0;
+	metaPointerPos = 0;
+	sampleCountPos = 0;
+	dataStart = 0;
+
+	if (nch < 1 || nch > 6 || fs == 0) {
+		errorMsg = "dsfFileWriter::dsfFileWriter:dsf files have 1 to 6 channels";
+		return;
+	}
+	if (!strcmp(filePath,"-")) {
+		errorMsg = "dsfFileWriter::dsfFileWriter:can't write to stdout, the chunk sizes are filled in at the end";
+		return;
+	}
+	blockBuffer = new dsf2flac_uint8[blockSzPerChan*nch];
+	planarBuffer = new dsf2flac_uint8[blockSzPerChan*nch];
+
+	file = fopen(filePath,"wb");
+	if (!file) {
+		errorMsg = "dsfFileWriter::dsfFileWriter:can't create the file";
+		return;
+	}
+	closed = false;
+
+	// DSD chunk, the file size and the metadata pointer are filled in by close()
+	bool ok = fwrite("DSD ",4,1,file) == 1 && writeUint64(28);
+	fileSzPos = ftello(file);
+	ok = ok && writeUint64(0);
+	metaPointerPos = ftello(file);
+	ok = ok && writeUint64(0);
+	// fmt chunk, the sample count is filled in by close()
+	ok = ok && fwrite("fmt ",4,1,file) == 1 && writeUint64(52);
+	ok = ok && writeUint32(1); // format version
+	ok = ok && writeUint32(0); // format id: DSD raw
+	ok = ok && writeUint32(dsfChannelTypes[nch]);
+	ok = ok && writeUint32(nch);
+	ok = ok && writeUint32(fs);
+	ok = ok && writeUint32(1); // bits per sample: lsb first
+	sampleCountPos = ftello(file);
+	ok = ok && writeUint64(0);
+	ok = ok && writeUint32(blockSzPerChan);
+	ok = ok && writeUint32(0); // reserved
+	// data chunk, the size is filled in by close()
+	dataStart = ftello(file);
+	ok = ok && fwrite("data",4,1,file) == 1 && writeUint64(0);
+	if (!ok) {
+		errorMsg = "dsfFileWriter::dsfFileWriter:file write error";
+		return;
+	}
+	valid = true;
+}
+
+DsfFileWriter::~DsfFileWriter()
+{
+	if (!closed)
+		close();
+	delete[] blockBuffer;
+	delete[] planarBuffer;
+}
+
+bool DsfFileWriter::write(const dsf2flac_uint8* data, dsf2flac_uint64 len)
+{
+	if (!valid)
+		return false;
+	dsf2flac_uint64 frames = len / numChannels;
+	while (frames > 0) {
+		dsf2flac_uint64 n = std::min<dsf2flac_uint64>(frames,blockSzPerChan - blockFill);
+		memcpy(&blockBuffer[blockFill*numChannels],data,n*numChannels);
+		blockFill += n;
+		bytesPerChan += n;
+		data += n*numChannels;
+		frames -= n;
+		if (blockFill == blockSzPerChan && !writeBlock())
+			return false;
+	}
+	return true;
+}
+
+bool DsfFileWriter::copy(int fd, dsf2flac_uint64 offset, dsf2flac_uint64 len)
+{
+	if (!valid)
+		return false;
+	if (blockFill != 0 || len % ((dsf2flac_uint64)blockSzPerChan*numChannels)) {
+		errorMsg = "dsfFileWriter::copy:only whole blocks can be copied";
+		valid = false;
+		return false;
+	}
+	if (!copyToFile(file,fd,offset,len)) {
+		errorMsg = "dsfFileWriter::copy:file copy error";
+		valid = false;
+		return false;
+	}
+	bytesPerChan += len / numChannels;
+	return true;
+}
+
+bool DsfFileWriter::close()
+{
+	if (closed)
+		return valid;
+	bool ok = valid && (blockFill == 0 || writeBlock());
+	dsf2flac_int64 dataEnd = ok ? ftello(file) : 0;
+	// the tag goes after the samples
+	if (ok && !id3Data.empty())
+		ok = fwrite(id3Data.data(),id3Data.size(),1,file) == 1;
+	dsf2flac_int64 end = ok ? ftello(file) : 0;
+	ok = ok && patchUint64(fileSzPos,end);
+	ok = ok && patchUint64(metaPointerPos,id3Data.empty() ? 0 : dataEnd);
+	ok = ok && patchUint64(sampleCountPos,bytesPerChan*8);
+	ok = ok && patchUint64(dataStart + 4,dataEnd - dataStart);
+	ok = !fclose(file) && ok;
+	file = NULL;
+	closed = true;
+	if (!ok && valid) {
+		errorMsg = "dsfFileWriter::close:file write error";
+		valid = false;
+	}
+	return ok;
+}
+
+bool DsfFileWriter::writeBlock()
+{
+	// a short last block is padded with zeros
+	memset(&blockBuffer[blockFill*numChannels],0,(blockSzPerChan - blockFill)*numChannels);
+	deinterleave_bytes(blockBuffer,planarBuffer,numChannels,blockSzPerChan);
+	blockFill = 0;
+	if (fwrite(planarBuffer,blockSzPerChan*numChannels,1,file) != 1) {
+		errorMsg = "dsfFileWriter::writeBlock:file write error";
+		valid = false;
+		return false;
+	}
+	return true;
+}
+
+bool DsfFileWriter::writeUint32(dsf2flac_uint32 x)
+{
+	dsf2flac_uint8 b[4] = { (dsf2flac_uint8)x, (dsf2flac_uint8)(x >> 8), (dsf2flac_uint8)(x >> 16), (dsf2flac_uint8)(x >> 24) };
+	return fwrite(b,4,1,file) == 1;
+}
+
+bool DsfFileWriter::writeUint64(dsf2flac_uint64 x)
+{
+	return writeUint32(x) && writeUint32(x >> 32);
+}
+
+bool DsfFileWriter::patchUint64(dsf2flac_int64 pos, dsf2flac_uint64 x)
+{
+	return !fseeko(file,pos,SEEK_SET) && writeUint64(x);
+}
@@ -0,0 +1,108 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsf_file_writer.h
+  *
+  * Header file for the class DsfFileWriter.
+  *
+  * Writes DSD audio to a DSF (.dsf) file.
+  *
+  */
+
+#ifndef DSFFILEWRITER_H
+#define DSFFILEWRITER_H
+
+#include "dsd_sample_writer.h" // Base class: DsdSampleWriter
+#include <cstdio>
+
+/**
+ * This class extends DsdSampleWriter writing dsf files.
+ *
+ * The samples are written lsb first (bitsPerSample 1) in blocks of 4096 bytes per channel, the last
+ * block is padded with zeros. The tag (see setID3Tag()) goes into the metadata chunk at the end.
+ * Up to 6 channels are supported, in the order of the dsf channel types (e.g. FL FR C LFE BL BR for 5.1).
+ */
+class DsfFileWriter final : public DsdSampleWriter
+{
+public:
+	/// The block size per channel.
+	static const dsf2flac_uint32 blockSzPerChan = 4096;
+public:
+	/** Class constructor.
+	 *  Creates the file at filePath and writes the headers.
+	 *  If there is an issue creating the file then isValid() will be false.
+	 */
+	DsfFileWriter(const char* filePath, dsf2flac_uint32 samplingFreq, dsf2flac_uint32 numChannels);
+	/** Class destructor.
+	 *  Calls close() if it hasn't been called.
+	 */
+	virtual ~DsfFileWriter();
+public:
+	// public overridden from dsdSampleWriter
+	dsf2flac_uint32 getNumChannels() { return numChannels; };
+	bool msbIsPlayedFirst() { return true; }; // the lsb is played first, as for DsfFileReader
+	bool write(const dsf2flac_uint8* data, dsf2flac_uint64 len);
+	/// Takes whole blocks of an lsb first dsf file with the same number of channels, only when whole blocks have gone in so far.
+	bool copy(int fd, dsf2flac_uint64 offset, dsf2flac_uint64 len);
+	/// Writes the last block, the metadata and the sizes, and closes the file.
+	bool close();
+private:
+	/// Writes the block buffer (padded with zeros when it isn't full) as one block of each channel.
+	bool writeBlock();
+	/// Write little endian numbers, return false on error.
+	bool writeUint32(dsf2flac_uint32 x);
+	bool writeUint64(dsf2flac_uint64 x);
+	/// Overwrite the little endian number at pos, return false on error.
+	bool patchUint64(dsf2flac_int64 pos, dsf2flac_uint64 x);
+private:
+	FILE* file;
+	bool closed;
+	dsf2flac_uint32 samplingFreq;
+	dsf2flac_uint32 numChannels;
+	dsf2flac_uint8* blockBuffer; // the next block, interleaved as it comes in
+	dsf2flac_uint8* planarBuffer; // the block as it is written, one channel after the other
+	dsf2flac_uint32 blockFill; // bytes per channel in the block buffer
+	dsf2flac_uint64 bytesPerChan; // written so far, without the padding
+	// where things are in the file
+	dsf2flac_int64 fileSzPos;
+	dsf2flac_int64 metaPointerPos;
+	dsf2flac_int64 sampleCountPos;
+	dsf2flac_int64 dataStart;
+};
+
+#endif // DSFFILEWRITER_H
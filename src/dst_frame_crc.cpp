@@ -0,0 +1,77 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "dst_frame_crc.h"
+
+static const dsf2flac_uint32 crcPolynomial = 0x80000011; // x^32 + x^31 + x^4 + 1 without the x^32 term
+
+/// The slicing by 8 tables: t[0] is the usual one byte table, t[k] moves a byte k places further on.
+struct DstCrcTables {
+	dsf2flac_uint32 t[8][256];
+	DstCrcTables() {
+		for (dsf2flac_uint32 b=0; b<256; b++) {
+			dsf2flac_uint32 c = b << 24;
+			for (int i=0; i<8; i++)
+				c = (c & 0x80000000) ? (c << 1) ^ crcPolynomial : (c << 1);
+			t[0][b] = c;
+		}
+		for (int k=1; k<8; k++)
+			for (dsf2flac_uint32 b=0; b<256; b++)
+				t[k][b] = (t[k-1][b] << 8) ^ t[0][t[k-1][b] >> 24];
+	}
+};
+
+static inline dsf2flac_uint32 load_be32(const dsf2flac_uint8* p)
+{
+	return ((dsf2flac_uint32)p[0] << 24) | ((dsf2flac_uint32)p[1] << 16) | ((dsf2flac_uint32)p[2] << 8) | p[3];
+}
+
+dsf2flac_uint32 dst_frame_crc(const dsf2flac_uint8* data, size_t len, dsf2flac_uint32 crc)
+{
+	static const DstCrcTables tables; // made on first use (thread safe)
+	const dsf2flac_uint32 (*t)[256] = tables.t;
+
+	for (; len >= 8; len -= 8, data += 8) {
+		dsf2flac_uint32 hi = crc ^ load_be32(data);
+		dsf2flac_uint32 lo = load_be32(data+4);
+		crc = t[7][hi >> 24] ^ t[6][(hi >> 16) & 0xff] ^ t[5][(hi >> 8) & 0xff] ^ t[4][hi & 0xff]
+		    ^ t[3][lo >> 24] ^ t[2][(lo >> 16) & 0xff] ^ t[1][(lo >> 8) & 0xff] ^ t[0][lo & 0xff];
+	}
+	for (; len > 0; len--, data++)
+		crc = (crc << 8) ^ t[0][(crc >> 24) ^ *data];
+	return crc;
+}
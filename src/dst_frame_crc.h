@@ -0,0 +1,65 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dst_frame_crc.h
+  *
+  * Header file for the DST frame CRC.
+  *
+  * A DSDIFF file with DST compressed sound data may follow each DSTF frame chunk with a DSTC chunk
+  * holding the CRC of the frame's DSD data (all channels, interleaved as the decoder writes them).
+  * The CRC is the one in the DSDIFF specification: the remainder of the modulo-2 division, MSB first,
+  * of the data with 32 zero bits appended by G(x) = x^32 + x^31 + x^4 + 1 (0x80000011). Worked a byte
+  * at a time from an initial value of 0 and without a final inversion, that is the same thing.
+  *
+  */
+
+#ifndef DST_FRAME_CRC_H
+#define DST_FRAME_CRC_H
+
+#include "dsf2flac_types.h"
+#include <cstddef>
+
+/**
+ * Returns the CRC of len bytes at data, continuing from crc (0 for the first block).
+ *
+ * Eight bytes are done at a time with eight lookup tables (slicing by 8), which is far quicker
+ * than the DST decoding which produced the data.
+ */
+dsf2flac_uint32 dst_frame_crc(const dsf2flac_uint8* data, size_t len, dsf2flac_uint32 crc = 0);
+
+#endif // DST_FRAME_CRC_H
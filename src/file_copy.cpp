@@ -0,0 +1,99 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "file_copy.h"
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+// the size of each request made to the kernel, and of the buffer when the data has to be read and written
+static const size_t copyChunkLength = 16*1024*1024;
+
+bool copy_file_data(int inFd, dsf2flac_uint64 offset, int outFd, dsf2flac_uint64 len)
+{
+#ifdef __linux__
+	// within the kernel, copy_file_range first (it fails at once where it isn't supported, e.g. across filesystems on older kernels)
+	bool useCopyFileRange = true;
+	while (len > 0) {
+		size_t n = std::min<dsf2flac_uint64>(len,copyChunkLength);
+		ssize_t r;
+		if (useCopyFileRange) {
+			loff_t off = offset;
+			r = copy_file_range(inFd,&off,outFd,NULL,n,0);
+			if (r < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+				useCopyFileRange = false;
+				continue;
+			}
+		} else {
+			off_t off = offset;
+			r = sendfile(outFd,inFd,&off,n);
+			if (r < 0 && (errno == ENOSYS || errno == EINVAL))
+				break;
+		}
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return false;
+		offset += r;
+		len -= r;
+	}
+#endif
+	// read and write whatever is left
+	char* buffer = len > 0 ? new char[std::min<dsf2flac_uint64>(len,copyChunkLength)] : NULL;
+	bool ok = true;
+	while (ok && len > 0) {
+		size_t n = std::min<dsf2flac_uint64>(len,copyChunkLength);
+		ssize_t r = pread(inFd,buffer,n,offset);
+		if (r < 0 && errno == EINTR)
+			continue;
+		ok = r > 0;
+		for (ssize_t done = 0; ok && done < r; ) {
+			ssize_t w = write(outFd,buffer + done,r - done);
+			if (w < 0 && errno == EINTR)
+				continue;
+			ok = w > 0;
+			done += ok ? w : 0;
+		}
+		offset += ok ? r : 0;
+		len -= ok ? r : 0;
+	}
+	delete[] buffer;
+	return ok;
+}
@@ -0,0 +1,62 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * file_copy.h
+  *
+  * Header file for the file range copying helper.
+  *
+  * Used to put sound data which is already laid out as the output needs it straight into the output
+  * file, without it passing through the readers and writers a byte at a time.
+  *
+  */
+
+#ifndef FILECOPY_H
+#define FILECOPY_H
+
+#include "dsf2flac_types.h"
+
+/**
+ * Copies len bytes from inFd, starting at offset, to the current position of outFd. Returns false on error.
+ *
+ * The file position of inFd is not used or changed. Where the kernel can, the data is copied within it
+ * (copy_file_range, which on some filesystems shares the blocks rather than copying them, then sendfile),
+ * otherwise it is read and written in large blocks.
+ */
+bool copy_file_data(int inFd, dsf2flac_uint64 offset, int outFd, dsf2flac_uint64 len);
+
+#endif // FILECOPY_H
@@ -46,13 +46,57 @@
   */
 
 #include "fstream_plus.h"
+#include <cstring>
+
+dsf2flac_uint32 fstreamPlus::readAheadBlockSize = ReadAheadBuffer::defaultBlockSize;
+dsf2flac_uint32 fstreamPlus::readAheadBlocks = 0;
 
 fstreamPlus::fstreamPlus() : std::fstream()
 {
+	readAhead = NULL;
+	streaming = false;
 }
 
 fstreamPlus::~fstreamPlus()
 {
+	// the read ahead thread uses the filebuf, so stop it first
+	close();
+}
+
+void fstreamPlus::open(const char* filename, ios_base::openmode mode)
+{
+	close();
+	if (!strcmp(filename,"-") && (mode & ios_base::in) && !(mode & ios_base::out)) {
+		std::ios::rdbuf(PipeBuffer::getStdin());
+		streaming = true;
+		return;
+	}
+	std::fstream::open(filename,mode);
+	if (is_open() && readAheadBlocks > 0 && (mode & ios_base::in) && !(mode & ios_base::out)) {
+		readAhead = new ReadAheadBuffer(std::fstream::rdbuf(),readAheadBlockSize,readAheadBlocks);
+		std::ios::rdbuf(readAhead);
+	}
+}
+
+void fstreamPlus::close()
+{
+	if (streaming) {
+		std::ios::rdbuf(std::fstream::rdbuf());
+		streaming = false;
+	}
+	if (readAhead) {
+		std::ios::rdbuf(std::fstream::rdbuf());
+		delete readAhead;
+		readAhead = NULL;
+	}
+	if (is_open())
+		std::fstream::close();
+}
+
+void fstreamPlus::setReadAhead(dsf2flac_uint32 blockSize, dsf2flac_uint32 nBlocks)
+{
+	readAheadBlockSize = blockSize;
+	readAheadBlocks = nBlocks;
 }
 
 /** Overload seekg methods to return true on fail **/
@@ -50,6 +50,8 @@
 
 #include <fstream>
 #include "dsf2flac_types.h"
+#include "read_ahead_buffer.h"
+#include "pipe_buffer.h"
 
 typedef dsf2flac_uint64 stream_size;
 
@@ -59,6 +61,18 @@ public:
 	fstreamPlus();
 	virtual ~fstreamPlus();
 	
+	/** Open and close, files opened for reading only are read ahead in a background thread if enabled **/
+	// The filename "-" reads stdin, which can only seek within what is buffered (see PipeBuffer).
+	void open(const char* filename, ios_base::openmode mode = ios_base::in | ios_base::out);
+	void close();
+	bool is_open() { return streaming || std::fstream::is_open(); };
+	/// Returns the streambuf which is actually read (the read ahead, stdin or file buffer).
+	std::streambuf* getBuffer() { return std::ios::rdbuf(); };
+	/// Returns false for streams that can't seek backwards freely (stdin).
+	bool isSeekable() { return !streaming; };
+	/// Sets the read ahead used by files opened after this call: nBlocks blocks of blockSize bytes. nBlocks=0 disables read ahead.
+	static void setReadAhead(dsf2flac_uint32 blockSize, dsf2flac_uint32 nBlocks);
+	
 	/** Overload seekg methods to return true on fail **/
 	bool seekg(std::streampos pos);
 	bool seekg(std::streamoff pos, ios_base::seekdir way);
@@ -90,6 +104,11 @@ public:
 	
 private:
 
+	ReadAheadBuffer* readAhead;
+	bool streaming; // reading stdin through PipeBuffer::getStdin()
+	static dsf2flac_uint32 readAheadBlockSize;
+	static dsf2flac_uint32 readAheadBlocks;
+
 	/** templates for the readers **/
 	template<typename rType> bool read_helper(rType* b, stream_size n);
 	template<typename rType> bool read_helper_rev(rType* b, stream_size n);
@@ -114,6 +114,8 @@ Changes:
 #define AC_HISMAX           (1 << AC_HISBITS)
 #define AC_QSTEP            (SIZE_PREDCOEF - AC_HISBITS)  /* Quantization step 
                                                              for histogram */
+#define ADATA_PADDING       8  /* Zero bytes after the packed arithmetic code,
+                                  the decoder reads a few bytes ahead */
 
 /* RICE CODING OF PREDICTION COEFFICIENTS AND PTABLES */
 #define NROFFRICEMETHODS    3   /* Number of different Pred. Methods for filters
@@ -93,7 +93,7 @@ Changes:
 /* function : Arithmetic decode one bit.                                   */
 /*                                                                         */
 /* pre      : p       : probability for next bit being a "one"             */
-/*            cb[]    : filled with arithmetic code bit(s)                 */
+/*            cb[]    : arithmetic code bit(s), packed MSB first           */
 /*            fs      : Current length of the arithm. code                 */
 /*            Flush   : 0 = Normal operation,                              */
 /*                      1 = flush remaider of the decoder                  */
@@ -126,7 +126,7 @@ void DST_ACDecodeBit(ACData *AC, unsigned char *b, int p, unsigned char *cb,
       AC->C <<= 1;
       if (AC->cbptr < fs)
       {
-        AC->C |= cb[AC->cbptr];
+        AC->C |= (cb[AC->cbptr >> 3] >> (7 - (AC->cbptr & 7))) & 1;
       }
     }
   }
@@ -157,7 +157,7 @@ void DST_ACDecodeBit(ACData *AC, unsigned char *b, int p, unsigned char *cb,
       AC->C <<= 1;
       if (AC->cbptr < fs)
       {
-        AC->C |= cb[AC->cbptr];
+        AC->C |= (cb[AC->cbptr >> 3] >> (7 - (AC->cbptr & 7))) & 1;
       }
       AC->cbptr++;
     }
@@ -174,7 +174,7 @@ void DST_ACDecodeBit(ACData *AC, unsigned char *b, int p, unsigned char *cb,
       *b = 1;
       while ((AC->cbptr < fs) && (*b == 1))
       {
-        if (cb[AC->cbptr] != 0)
+        if (cb[AC->cbptr >> 3] & (0x80 >> (AC->cbptr & 7)))
         {
           *b = 1;
         }
@@ -63,11 +63,9 @@ Changes:
 /*       INCLUDES                                                             */
 /*============================================================================*/
 
-#ifndef __APPLE__
-#include <malloc.h>
-#endif
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "types.h"
 #include "dst_data.h"
 
@@ -80,83 +78,84 @@ int getbits(StrData* S, long *outword, int out_bitptr);
 
 
 /***********************************************************************
- * GetDSTDataPointer
+ * LoadBE64: the 8 bytes at p as a big endian number
  ***********************************************************************/
 
-int GetDSTDataPointer (StrData* SD, uint8_t** pBuffer)
+static __inline uint64_t LoadBE64(const uint8_t* p)
 {
-  int hr = 0;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+  uint64_t Word;
 
-  *pBuffer = SD->pDSTdata;
+  memcpy(&Word, p, sizeof(Word));
+  return __builtin_bswap64(Word);
+#elif defined(__GNUC__) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+  uint64_t Word;
 
-  return (hr);
+  memcpy(&Word, p, sizeof(Word));
+  return Word;
+#else
+  uint64_t Word = 0;
+  int      i;
+
+  for (i = 0; i < 8; i++)
+  {
+    Word = (Word << 8) | p[i];
+  }
+  return Word;
+#endif
 }
 
 
 /***********************************************************************
- * ResetReadingIndex
+ * FillCache: top up SD->Cache to at least 56 bits (or to the end of
+ * the frame). Bits below the CacheBits valid ones are either zero or
+ * already the right stream bits, so they can simply be or-ed in again.
  ***********************************************************************/
 
-int ResetReadingIndex(StrData* SD)
+static __inline void FillCache(StrData* SD)
 {
-  int hr = 0;
-
-  SD->BitPosition = 0;
-  SD->ByteCounter = 0;
-  SD->DataByte    = 0;
-
-  return (hr);
+  if (SD->TotalBytes - SD->ByteCounter >= 8)
+  {
+    SD->Cache       |= LoadBE64(SD->pDSTdata + SD->ByteCounter) >> SD->CacheBits;
+    SD->ByteCounter += (63 - SD->CacheBits) >> 3;
+    SD->CacheBits   |= 56;
+  }
+  else
+  {
+    while ((SD->CacheBits <= 55) && (SD->ByteCounter < SD->TotalBytes))
+    {
+      SD->Cache     |= (uint64_t)SD->pDSTdata[SD->ByteCounter++] << (56 - SD->CacheBits);
+      SD->CacheBits += 8;
+    }
+  }
 }
 
 
 /***********************************************************************
- * CreateBuffer
+ * GetDSTDataPointer
  ***********************************************************************/
 
-int CreateBuffer(StrData* SD, int32_t Size)
+int GetDSTDataPointer (StrData* SD, uint8_t** pBuffer)
 {
   int hr = 0;
 
-  SD->TotalBytes = Size;
-
-  /* delete buffer if exist */
-  if (SD->pDSTdata != NULL)
-  {
-    free( SD->pDSTdata );
-    SD->pDSTdata = NULL;
-  }
-
-  /* create new buffer for data */
-  SD->pDSTdata = (uint8_t*) malloc (Size);
-
-  if (SD->pDSTdata == NULL)
-  {
-    SD->TotalBytes = 0;
-    hr = -1;
-  }
-
-  ResetReadingIndex(SD);
+  *pBuffer = SD->pDSTdata;
 
   return (hr);
 }
 
 
 /***********************************************************************
- * DeleteBuffer
+ * ResetReadingIndex
  ***********************************************************************/
 
-int DeleteBuffer(StrData* SD)
+int ResetReadingIndex(StrData* SD)
 {
   int hr = 0;
 
-  SD->TotalBytes = 0;
-
-  if (SD->pDSTdata != NULL)
-  {
-    hr = -1;
-  }
-
-  ResetReadingIndex(SD);
+  SD->ByteCounter = 0;
+  SD->Cache       = 0;
+  SD->CacheBits   = 0;
 
   return (hr);
 }
@@ -169,16 +168,11 @@ int DeleteBuffer(StrData* SD)
 int FillBuffer(StrData* SD, uint8_t* pBuf, int32_t Size)
 {
   int hr = 0;
-  int32_t    cnt;
-
-  // SD->pDSTdata = NULL; /* BUG: this line causes memory leak */
 
-  CreateBuffer(SD, Size);
-
-  for (cnt = 0; cnt < Size; cnt++)
-  {
-    SD->pDSTdata[cnt] = pBuf[cnt];
-  }
+  /* read the frame in place (rather than a copy in a buffer allocated for */
+  /* every frame), the caller keeps pBuf until the frame is decoded       */
+  SD->pDSTdata   = pBuf;
+  SD->TotalBytes = Size;
 
   ResetReadingIndex(SD);
 
@@ -357,69 +351,157 @@ int FIO_BitGetShortSigned(StrData* SD, int Len, short *x)
 
 /***************************************************************************/
 /*                                                                         */
-/* name     : getbits                                                      */
+/* name     : FIO_BitGetBytes                                              */
 /*                                                                         */
-/* function : Read bits from the bitstream and decrement the counter.      */
+/* function : Read Len whole bytes (8 bits each) from the bitstream.       */
 /*                                                                         */
-/* pre      : out_bitptr                                                   */
+/* pre      : Len, x[] must have room for Len bytes                        */
 /*                                                                         */
-/* post     : m_ByteCounter, outword, returns EOF on EOF or 0 otherwise.   */
+/* post     : x[] is filled with the bytes read (0 past the end of the     */
+/*            stream), returns -1 on EOF or 0 otherwise.                   */
 /*                                                                         */
-/* uses     : stdio.h                                                      */
+/* uses     : string.h                                                     */
 /*                                                                         */
 /***************************************************************************/
 
-static int masks[] = { 0, 1, 3, 7, 0xf, 0x1f, 0x3f, 0x7f, 0xff };
-
-int getbits(StrData* SD, long *outword, int out_bitptr)
+int FIO_BitGetBytes(StrData* SD, int Len, uint8_t *x)
 {
-    if (out_bitptr == 1)
+  int  i = 0;
+  int  n;
+  long tmp;
+
+  if ((SD->CacheBits & 7) == 0)
+  {
+    /* byte aligned: empty the cache and copy the rest straight from the frame */
+    for (; (i < Len) && (SD->CacheBits > 0); i++)
     {
-        if (SD->BitPosition == 0)
-        {
-            SD->DataByte = SD->pDSTdata[SD->ByteCounter++];
-            if (SD->ByteCounter > SD->TotalBytes)
-            {
-                return (-1); /* EOF */
-            }
-            SD->BitPosition = 8;
-        }
+      x[i]            = (uint8_t)(SD->Cache >> 56);
+      SD->Cache     <<= 8;
+      SD->CacheBits  -= 8;
+    }
+    n = MIN(Len - i, SD->TotalBytes - SD->ByteCounter);
+    if (n > 0)
+    {
+      memcpy(&x[i], SD->pDSTdata + SD->ByteCounter, n);
+      SD->ByteCounter += n;
+      SD->Cache        = 0;
+      i               += n;
+    }
+  }
+  else
+  {
+    /* not byte aligned: shift the bytes out of the cache 4 at a time */
+    for (; (i + 4 <= Len) && (getbits(SD, &tmp, 32) == 0); i += 4)
+    {
+      x[i    ] = (uint8_t)(tmp >> 24);
+      x[i + 1] = (uint8_t)(tmp >> 16);
+      x[i + 2] = (uint8_t)(tmp >>  8);
+      x[i + 3] = (uint8_t)(tmp      );
+    }
+    for (; (i < Len) && (getbits(SD, &tmp, 8) == 0); i++)
+    {
+      x[i] = (uint8_t)tmp;
+    }
+  }
 
-        SD->BitPosition--;
-        *outword = (SD->DataByte >> SD->BitPosition) & 1;
+  if (i < Len)
+  {
+    memset(&x[i], 0, Len - i);
+    return -1; /* EOF */
+  }
+  return 0;
+}
+
+
+/***************************************************************************/
+/*                                                                         */
+/* name     : FIO_BitGetUnary                                              */
+/*                                                                         */
+/* function : Count the zero bits up to (and reading) the next one bit.    */
+/*                                                                         */
+/* pre      : x                                                            */
+/*                                                                         */
+/* post     : *x is the number of zero bits, returns -1 on EOF or 0        */
+/*            otherwise.                                                   */
+/*                                                                         */
+/* uses     : -                                                            */
+/*                                                                         */
+/***************************************************************************/
+
+int FIO_BitGetUnary(StrData* SD, int *x)
+{
+  uint64_t Bits;
+  int      Zeros;
 
-        return 0;
+  *x = 0;
+  for (;;)
+  {
+    if (SD->CacheBits == 0)
+    {
+      FillCache(SD);
+      if (SD->CacheBits == 0)
+      {
+        return -1; /* EOF */
+      }
     }
 
-    *outword = 0;
-    while(out_bitptr > 0)
+    /* only the CacheBits valid bits count, not the ones below them */
+    Bits = SD->Cache & ~((((uint64_t)1) << (64 - SD->CacheBits)) - 1);
+    if (Bits == 0)
     {
-        int thisbits, mask, shift;
+      *x            += SD->CacheBits;
+      SD->Cache      = 0;
+      SD->CacheBits  = 0;
+      continue;
+    }
 
-        if (!SD->BitPosition)
-        {
-            SD->DataByte = SD->pDSTdata[SD->ByteCounter++];
-            if (SD->ByteCounter > SD->TotalBytes)
-            {
-                return (-1); /* EOF */
-            }
-            SD->BitPosition = 8;
-        }
+#if defined(__GNUC__)
+    Zeros = __builtin_clzll(Bits);
+#else
+    for (Zeros = 0; (Bits & ((uint64_t)1 << 63)) == 0; Zeros++)
+    {
+      Bits <<= 1;
+    }
+#endif
+    *x            += Zeros;
+    SD->Cache    <<= Zeros + 1;
+    SD->CacheBits -= Zeros + 1;
+    return 0;
+  }
+}
 
-        thisbits = MIN(SD->BitPosition, out_bitptr);
-        shift = (SD->BitPosition - thisbits);
-        mask = masks[thisbits] << shift;
 
-        shift = (out_bitptr - thisbits) - shift;
-        if (shift <= 0)
-            *outword |= ((SD->DataByte & mask) >> -shift);
-        else
-            *outword |= ((SD->DataByte & mask) << shift);
+/***************************************************************************/
+/*                                                                         */
+/* name     : getbits                                                      */
+/*                                                                         */
+/* function : Read bits from the bitstream and decrement the counter.      */
+/*            The bits are taken from a 64 bit cache which is refilled     */
+/*            8 bytes at a time, rather than one byte at a time.           */
+/*                                                                         */
+/* pre      : out_bitptr (1..32)                                           */
+/*                                                                         */
+/* post     : m_ByteCounter, outword, returns EOF on EOF or 0 otherwise.   */
+/*                                                                         */
+/* uses     : stdio.h                                                      */
+/*                                                                         */
+/***************************************************************************/
 
-        out_bitptr -= thisbits;
-        SD->BitPosition -= thisbits;
+int getbits(StrData* SD, long *outword, int out_bitptr)
+{
+    if (SD->CacheBits < out_bitptr)
+    {
+        FillCache(SD);
+        if (SD->CacheBits < out_bitptr)
+        {
+            return (-1); /* EOF */
+        }
     }
 
+    *outword       = (long)(SD->Cache >> (64 - out_bitptr));
+    SD->Cache    <<= out_bitptr;
+    SD->CacheBits -= out_bitptr;
+
     return 0;
 }
 
@@ -439,7 +521,7 @@ int getbits(StrData* SD, long *outword, int out_bitptr)
 
 int get_in_bitcount(StrData* SD)
 {
-  return SD->ByteCounter * 8 - SD->BitPosition;
+  return SD->ByteCounter * 8 - SD->CacheBits;
 }
 
 
@@ -84,11 +84,10 @@ int FIO_BitGetChrUnsigned(StrData* SD, int Len, unsigned char *x);
 int FIO_BitGetIntUnsigned(StrData* SD, int Len, int *x);
 int FIO_BitGetIntSigned(StrData* SD, int Len, int *x);
 int FIO_BitGetShortSigned(StrData* SD, int Len, short *x);
+int FIO_BitGetBytes(StrData* SD, int Len, uint8_t *x);
+int FIO_BitGetUnary(StrData* SD, int *x);
 int get_in_bitcount(StrData* SD);
 
-int CreateBuffer(StrData* SD, int32_t Size);
-int DeleteBuffer(StrData* SD);
-
 
 #endif /* !defined(__DSTDATA_H_INCLUDED) */
 
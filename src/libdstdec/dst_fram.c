@@ -70,6 +70,7 @@ Changes:
 #include "dst_ac.h"
 #include "types.h"
 #include "dst_fram.h"
+#include "dst_fram_filter.h"
 #include "unpack_dst.h"
 
 /*============================================================================*/
@@ -85,75 +86,74 @@ Changes:
 #define ONE     (1 << ABITS)
 #define HALF    (1 << (ABITS - 1))
 
-static __inline void LT_ACDecodeBit_Init(ACData *AC, uint8_t *cb, int fs)
+/* The next n (0..24) bits of the arithmetic code cb[] (packed MSB first) */
+/* from bit position pos on.                                              */
+static __inline unsigned int LT_ACGetBits(const uint8_t *cb, int pos, int n)
 {
-    AC->Init = 0;
-    AC->A    = ONE - 1;
-    AC->C    = 0;
-    for (AC->cbptr = 1; AC->cbptr <= ABITS; AC->cbptr++)
+    const uint8_t *p = &cb[pos >> 3];
+    uint64_t      Window;
+
+    Window = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    return (unsigned int)(((Window << (pos & 7)) & 0xffffffffu) >> (32 - n));
+}
+
+static __inline int LT_CountLeadingZeros(unsigned int x)
+{
+#if defined(__GNUC__)
+    return __builtin_clz(x);
+#else
+    int n = 0;
+
+    while ((x & 0x80000000u) == 0)
     {
-        AC->C <<= 1;
-        if (AC->cbptr < fs)
-        {
-            AC->C |= cb[AC->cbptr];
-        }
+        x <<= 1;
+        n++;
     }
+    return n;
+#endif
 }
-  
+
+static __inline void LT_ACDecodeBit_Init(ACData *AC, uint8_t *cb)
+{
+    /* cb[] is zero padded past the end of the code, so there is no need to */
+    /* check for the end                                                    */
+    AC->Init  = 0;
+    AC->A     = ONE - 1;
+    AC->C     = LT_ACGetBits(cb, 1, ABITS);
+    AC->cbptr = ABITS + 1;
+}
+   
 static __inline void LT_ACDecodeBit_Decode(ACData *AC, uint8_t *b, int p, uint8_t *cb, int fs)
 {
     unsigned int ap;
     unsigned int h;
+    unsigned int Zero;
+    int          n;
 
     /* approximate (A * p) with "partial rounding". */
     ap = ((AC->A >> PBITS) | ((AC->A >> (PBITS - 1)) & 1)) * p;
     
-    h = AC->A - ap;
-    if (AC->C >= h)
-    {
-        *b = 0;
-        AC->C -= h;
-        AC->A  = ap;
-    }
-    else
-    {
-        *b = 1;
-        AC->A  = h;
-    }
-    while (AC->A < HALF)
-    {
-        AC->A <<= 1;
-      
-        /* Use new flushing technique; insert zero in LSB of C if reading past
-            the end of the arithmetic code */
-        AC->C <<= 1;
-        if (AC->cbptr < fs)
-        {
-            AC->C |= cb[AC->cbptr];
-        }
-        AC->cbptr++;
-    }
+    /* The decoded bit is close to random, so select without branching */
+    h      = AC->A - ap;
+    Zero   = 0u - (unsigned int)(AC->C >= h);       /* all ones if the bit is 0 */
+    *b     = (uint8_t)(Zero + 1);
+    AC->C -= h & Zero;
+    AC->A  = (ap & Zero) | (h & ~Zero);
+
+    /* Renormalise in one go: shift A up to HALF or more and shift as many */
+    /* code bits into C. Use new flushing technique; insert zeros in the   */
+    /* LSBs of C if reading past the end of the arithmetic code (cb[] is   */
+    /* zero from bit fs on).                                               */
+    n          = LT_CountLeadingZeros(AC->A) - (32 - ABITS);
+    AC->C      = (AC->C << n) | LT_ACGetBits(cb, (AC->cbptr < fs) ? AC->cbptr : fs, n);
+    AC->A    <<= n;
+    AC->cbptr += n;
 }
 
-static __inline void LT_ACDecodeBit_Flush(ACData *AC, uint8_t *b, int p, uint8_t *cb, int fs)
+static __inline void LT_ACDecodeBit_Flush(ACData *AC, uint8_t *b, int fs)
 {
     AC->Init = 1;
-    if (AC->cbptr < fs - 7)
-    {
-        *b = 0;
-    }
-    else
-    {
-        *b = 1;
-        while ((AC->cbptr < fs) && (*b == 1))
-        {
-            if (cb[AC->cbptr] != 0)
-            {
-                *b = 1;
-            }
-            AC->cbptr++;
-        }
-    }
+    *b       = (AC->cbptr < fs - 7) ? 0 : 1;
 }
 
 static __inline int LT_ACGetPtableIndex(int16_t PredicVal, int PtableLen)
@@ -238,13 +238,42 @@ static int16_t Reverse7LSBs(int16_t c)
     return reverse[(c + (1 << SIZE_PREDCOEF)) & 127];
 }
 
-static void LT_InitCoefTablesI(ebunch *D, int16_t ICoefI[2 * MAX_CHANNELS][16][256])
+/* FNV-1a hash of the coefficients of a filter */
+static uint32_t LT_HashCoefs(const int16_t *Coef, int FilterLength)
+{
+    uint32_t Hash = 2166136261u;
+    int      i;
+
+    for (i = 0; i < FilterLength; i++)
+    {
+        Hash = (Hash ^ (uint16_t)Coef[i]) * 16777619u;
+    }
+    return Hash;
+}
+
+/* Makes the FIR lookup tables of the filters in this frame. The tables are   */
+/* kept in D between frames, and a filter which has the same coefficients as  */
+/* the one its tables were made for last time reuses them.                    */
+static void LT_InitCoefTablesI(ebunch *D)
 {
+    int16_t (*ICoefI)[16][256] = D->ICoefI;
     int FilterNr, FilterLength, TableNr, k, i, j;
+    uint32_t Hash;
 
     for (FilterNr = 0; FilterNr < D->FrameHdr.NrOfFilters; FilterNr++)
     {
         FilterLength = D->FrameHdr.PredOrder[FilterNr];
+        Hash = LT_HashCoefs(D->FrameHdr.ICoefA[FilterNr], FilterLength);
+        if (D->ICoefIOrder[FilterNr] == FilterLength && D->ICoefIHash[FilterNr] == Hash &&
+            memcmp(D->ICoefIKey[FilterNr], D->FrameHdr.ICoefA[FilterNr], FilterLength * sizeof(int16_t)) == 0)
+        {
+            D->ICoefIHits++;
+            continue;
+        }
+        D->ICoefIMisses++;
+        D->ICoefIOrder[FilterNr] = FilterLength;
+        D->ICoefIHash[FilterNr]  = Hash;
+        memcpy(D->ICoefIKey[FilterNr], D->FrameHdr.ICoefA[FilterNr], FilterLength * sizeof(int16_t));
         for (TableNr = 0; TableNr < 16; TableNr++)
         {
             k = FilterLength - TableNr * 8;
@@ -296,24 +325,6 @@ static void LT_InitStatus(ebunch *D, uint8_t Status[MAX_CHANNELS][16])
 /* post     : D->WM.Pwm                                                    */
 /*                                                                         */
 /***************************************************************************/
-#define LT_RUN_FILTER_I(FilterTable, ChannelStatus) \
-    Predict  = FilterTable[ 0][ChannelStatus[ 0]]; \
-    Predict += FilterTable[ 1][ChannelStatus[ 1]]; \
-    Predict += FilterTable[ 2][ChannelStatus[ 2]]; \
-    Predict += FilterTable[ 3][ChannelStatus[ 3]]; \
-    Predict += FilterTable[ 4][ChannelStatus[ 4]]; \
-    Predict += FilterTable[ 5][ChannelStatus[ 5]]; \
-    Predict += FilterTable[ 6][ChannelStatus[ 6]]; \
-    Predict += FilterTable[ 7][ChannelStatus[ 7]]; \
-    Predict += FilterTable[ 8][ChannelStatus[ 8]]; \
-    Predict += FilterTable[ 9][ChannelStatus[ 9]]; \
-    Predict += FilterTable[10][ChannelStatus[10]]; \
-    Predict += FilterTable[11][ChannelStatus[11]]; \
-    Predict += FilterTable[12][ChannelStatus[12]]; \
-    Predict += FilterTable[13][ChannelStatus[13]]; \
-    Predict += FilterTable[14][ChannelStatus[14]]; \
-    Predict += FilterTable[15][ChannelStatus[15]];
-
 #define LT_RUN_FILTER_U(FilterTable, ChannelStatus) \
     { \
         uint32_t Predict32; \
@@ -349,22 +360,21 @@ int DST_FramDSTDecode(uint8_t *DSTdata, uint8_t *MuxedDSDdata, int FrameSizeInBy
     if (error == DSTErr_NoError && D->FrameHdr.DSTCoded == 1)
     {
         ACData AC;
+        int16_t  (*const LT_ICoefI)[16][256] = D->ICoefI;
 #ifdef _MSC_VER
-        __declspec(align(16)) int16_t  LT_ICoefI[2 * MAX_CHANNELS][16][256];
         __declspec(align(16)) uint8_t  LT_Status[MAX_CHANNELS][16];
 #else
-        int16_t  LT_ICoefI[2 * MAX_CHANNELS][16][256]  __attribute__ ((aligned (16)));
         uint8_t  LT_Status[MAX_CHANNELS][16] __attribute__ ((aligned (16)));
 #endif
 
         FillTable4Bit(NrOfChannels, NrOfBitsPerCh, &D->FrameHdr.FSeg, D->FrameHdr.Filter4Bit);
         FillTable4Bit(NrOfChannels, NrOfBitsPerCh, &D->FrameHdr.PSeg, D->FrameHdr.Ptable4Bit);
 
-        LT_InitCoefTablesI(D, LT_ICoefI);
+        LT_InitCoefTablesI(D);
         //LT_InitCoefTablesU(D, LT_ICoefU);
         LT_InitStatus(D, LT_Status);
 
-        LT_ACDecodeBit_Init(&AC, D->AData, D->ADataLen);
+        LT_ACDecodeBit_Init(&AC, D->AData);
         LT_ACDecodeBit_Decode(&AC, &ACError, Reverse7LSBs(D->FrameHdr.ICoefA[0][0]), D->AData, D->ADataLen);
 
         memset(MuxedDSD, 0, NrOfBitsPerCh * NrOfChannels / 8); 
@@ -405,18 +415,12 @@ int DST_FramDSTDecode(uint8_t *DSTdata, uint8_t *MuxedDSDdata, int FrameSizeInBy
                 MuxedDSD[ByteNr * NrOfChannels + ChNr] |= (uint8_t)(BitVal << (7 - BitNr % 8));
 
                 /* Update filter */
-                {
-                    uint32_t* const st = (uint32_t*)LT_Status[ChNr];
-                    st[3] = (st[3] << 1) | ((st[2] >> 31) & 1);
-                    st[2] = (st[2] << 1) | ((st[1] >> 31) & 1);
-                    st[1] = (st[1] << 1) | ((st[0] >> 31) & 1);
-                    st[0] = (st[0] << 1) | BitVal;
-                }
+                LT_UPDATE_STATUS(LT_Status[ChNr], BitVal);
             }
         }
 
         /* Flush the arithmetic decoder */
-        LT_ACDecodeBit_Flush(&AC, &ACError, 0, D->AData, D->ADataLen);
+        LT_ACDecodeBit_Flush(&AC, &ACError, D->ADataLen);
 
         if (ACError != 1)
             error = DSTErr_ArithmeticDecoder;
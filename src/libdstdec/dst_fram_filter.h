@@ -0,0 +1,122 @@
+/***********************************************************************
+MPEG-4 Audio RM Module
+Lossless coding of 1-bit oversampled audio - DST (Direct Stream Transfer)
+
+This software was originally developed by:
+
+* Aad Rijnberg 
+  Philips Digital Systems Laboratories Eindhoven 
+  <aad.rijnberg@philips.com>
+
+* Fons Bruekers
+  Philips Research Laboratories Eindhoven
+  <fons.bruekers@philips.com>
+   
+* Eric Knapen
+  Philips Digital Systems Laboratories Eindhoven
+  <h.w.m.knapen@philips.com> 
+
+And edited by:
+
+* Richard Theelen
+  Philips Digital Systems Laboratories Eindhoven
+  <r.h.m.theelen@philips.com>
+
+* Maxim Anisiutkin
+  ICT Group
+  <maxim.anisiutkin@gmail.com>
+
+in the course of development of the MPEG-4 Audio standard ISO-14496-1, 2 and 3.
+This software module is an implementation of a part of one or more MPEG-4 Audio
+tools as specified by the MPEG-4 Audio standard. ISO/IEC gives users of the
+MPEG-4 Audio standards free licence to this software module or modifications
+thereof for use in hardware or software products claiming conformance to the
+MPEG-4 Audio standards. Those intending to use this software module in hardware
+or software products are advised that this use may infringe existing patents.
+The original developers of this software of this module and their company,
+the subsequent editors and their companies, and ISO/EIC have no liability for
+use of this software module or modifications thereof in an implementation.
+Copyright is not released for non MPEG-4 Audio conforming products. The
+original developer retains full right to use this code for his/her own purpose,
+assign or donate the code to a third party and to inhibit third party from
+using the code for non MPEG-4 Audio conforming products. This copyright notice
+must be included in all copies of derivative works.
+
+Copyright © 2004.
+
+Source file: dst_fram_filter.h (Prediction filter of the DST frame decoding)
+
+Required libraries: <none>
+
+Authors:
+RT:  Richard Theelen, PDSL-labs Eindhoven <r.h.m.theelen@philips.com>
+MA:  Maxim Anisiutkin, ICT Group <maxim.anisiutkin@gmail.com>
+
+Changes:
+08-Mar-2004 RT  Initial version
+26-Jun-2011 MA  Improved performance with the unrolled FIR cycle
+
+************************************************************************/
+
+#ifndef __DST_FRAM_FILTER_H_INCLUDED
+#define __DST_FRAM_FILTER_H_INCLUDED
+
+/*============================================================================*/
+/*       INCLUDES                                                             */
+/*============================================================================*/
+
+#include "types.h"
+#if !defined(NO_SSE2) && (defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__))
+#define LT_SSE2_STATUS
+#include <emmintrin.h>
+#endif
+
+/*============================================================================*/
+/*       MACROS                                                               */
+/*============================================================================*/
+
+/* Sets Predict to the output of the FIR filter: the sum of the filter table */
+/* entries looked up by the 16 status bytes of the channel.                 */
+#define LT_RUN_FILTER_I(FilterTable, ChannelStatus) \
+    Predict  = FilterTable[ 0][ChannelStatus[ 0]]; \
+    Predict += FilterTable[ 1][ChannelStatus[ 1]]; \
+    Predict += FilterTable[ 2][ChannelStatus[ 2]]; \
+    Predict += FilterTable[ 3][ChannelStatus[ 3]]; \
+    Predict += FilterTable[ 4][ChannelStatus[ 4]]; \
+    Predict += FilterTable[ 5][ChannelStatus[ 5]]; \
+    Predict += FilterTable[ 6][ChannelStatus[ 6]]; \
+    Predict += FilterTable[ 7][ChannelStatus[ 7]]; \
+    Predict += FilterTable[ 8][ChannelStatus[ 8]]; \
+    Predict += FilterTable[ 9][ChannelStatus[ 9]]; \
+    Predict += FilterTable[10][ChannelStatus[10]]; \
+    Predict += FilterTable[11][ChannelStatus[11]]; \
+    Predict += FilterTable[12][ChannelStatus[12]]; \
+    Predict += FilterTable[13][ChannelStatus[13]]; \
+    Predict += FilterTable[14][ChannelStatus[14]]; \
+    Predict += FilterTable[15][ChannelStatus[15]];
+
+/* The 16 status bytes of a channel hold its last 128 bits, the newest in bit 0 */
+/* of byte 0: shift the whole 128 bits up by one and put the new bit in.       */
+/* The scalar version is always there to check the SSE2 one against.           */
+#define LT_UPDATE_STATUS_SCALAR(ChannelStatus, BitVal) \
+    { \
+        uint32_t* const st = (uint32_t*)(ChannelStatus); \
+        st[3] = (st[3] << 1) | ((st[2] >> 31) & 1); \
+        st[2] = (st[2] << 1) | ((st[1] >> 31) & 1); \
+        st[1] = (st[1] << 1) | ((st[0] >> 31) & 1); \
+        st[0] = (st[0] << 1) | (BitVal); \
+    }
+
+#ifdef LT_SSE2_STATUS
+#define LT_UPDATE_STATUS(ChannelStatus, BitVal) \
+    { \
+        __m128i st    = _mm_load_si128((const __m128i*)(ChannelStatus)); \
+        __m128i carry = _mm_srli_epi64(_mm_slli_si128(st, 8), 63); \
+        st = _mm_or_si128(_mm_or_si128(_mm_slli_epi64(st, 1), carry), _mm_cvtsi32_si128(BitVal)); \
+        _mm_store_si128((__m128i*)(ChannelStatus), st); \
+    }
+#else
+#define LT_UPDATE_STATUS(ChannelStatus, BitVal) LT_UPDATE_STATUS_SCALAR(ChannelStatus, BitVal)
+#endif
+
+#endif /* !defined(__DST_FRAM_FILTER_H_INCLUDED) */
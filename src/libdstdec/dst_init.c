@@ -237,6 +237,7 @@ static void FreeDecMemory (ebunch * D)
   MemoryFree(D->P_one[0]);
   MemoryFree(D->P_one);
   MemoryFree(D->AData);
+  MemoryFree(D->ICoefI);
 }
 
 /* Allocate memory for all dynamic variables of the decoder. */
@@ -260,6 +261,7 @@ static void AllocateDecMemory (ebunch * D)
   D->StrPtable.CPredCoef = AllocateArray(2, sizeof(**D->StrPtable.CPredCoef), NROFPRICEMETHODS, MAXCPREDORDER);
   D->P_one = AllocateArray(2, sizeof(**D->P_one), D->FrameHdr.MaxNrOfPtables, AC_HISMAX);
   D->AData = MemoryAllocate(D->FrameHdr.BitStreamLen,  sizeof(*D->AData));
+  D->ICoefI = MemoryAllocate(D->FrameHdr.MaxNrOfFilters, sizeof(*D->ICoefI));
 }
 
 /***************************************************************************/
@@ -290,6 +292,7 @@ static void AllocateDecMemory (ebunch * D)
 int DST_InitDecoder(ebunch * D, int NrOfChannels, int SampleRate) 
 {
   int  retval = 0;
+  int  i;
 
   memset(D, 0, sizeof(ebunch));
 
@@ -313,6 +316,12 @@ int DST_InitDecoder(ebunch * D, int NrOfChannels, int SampleRate)
     AllocateDecMemory(D);
   }
 
+  /* no FIR lookup tables have been made yet */
+  for (i = 0; i < 2 * MAX_CHANNELS; i++)
+  {
+    D->ICoefIOrder[i] = -1;
+  }
+
   if (retval==0) 
   {
     retval = CCP_CalcInit(&D->StrFilter);
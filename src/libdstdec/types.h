@@ -142,9 +142,9 @@ typedef struct
 {
     uint8_t*   pDSTdata;
     int32_t    TotalBytes;
-    int32_t    ByteCounter;
-    int        BitPosition;
-    uint8_t    DataByte;
+    int32_t    ByteCounter;  /* Bytes of pDSTdata moved into Cache so far   */
+    uint64_t   Cache;        /* Next bits of the stream, MSB first          */
+    int        CacheBits;    /* Number of valid bits in Cache (0..63)       */
 } StrData;
 
 typedef struct
@@ -163,11 +163,18 @@ typedef struct
     CodedTable   StrPtable;                                      /* Contains Ptable-entry compression data      */
                                                                  /* input stream.                               */
     int          **P_one;                                        /* Probability table for arithmetic coder      */
-    uint8_t      *AData;                                         /* Contains the arithmetic coded bit stream    */
+    uint8_t      *AData;                                         /* The arithmetic coded bits, packed MSB first */
                                                                  /* of a complete frame                         */
     int          ADataLen;                                       /* Number of code bits contained in AData[]    */
     StrData      S;                                              /* DST data stream */
 
+    int16_t      (*ICoefI)[16][256];                             /* FIR lookup tables, kept between frames      */
+    int          ICoefIOrder[2 * MAX_CHANNELS];                  /* PredOrder each table was made for (-1=none) */
+    uint32_t     ICoefIHash[2 * MAX_CHANNELS];                   /* Hash of the coefs each table was made for   */
+    int16_t      ICoefIKey[2 * MAX_CHANNELS][1 << SIZE_CODEDPREDORDER]; /* The coefs each table was made for    */
+    uint64_t     ICoefIHits;                                     /* Filters whose tables were reused            */
+    uint64_t     ICoefIMisses;                                   /* Filters whose tables had to be made         */
+
     int          SSE2;
 } ebunch;
 
@@ -117,11 +117,7 @@ void ReadDSDframe(StrData      *S,
                   int           NrOfChannels, 
                   unsigned char *DSDFrame)
 {
-  int             ByteNr;
-  int             max = (MaxFrameLen*NrOfChannels);
-  
-  for (ByteNr = 0; ByteNr < max; ByteNr++) 
-    FIO_BitGetChrUnsigned(S, 8,&DSDFrame[ByteNr]);
+  FIO_BitGetBytes(S, MaxFrameLen * NrOfChannels, DSDFrame);
 }
 
 /***************************************************************************/
@@ -142,17 +138,11 @@ int RiceDecode(StrData* S, int m)
 {
   int LSBs;
   int Nr;
-  int RLBit;
   int RunLength;
   int Sign;
 
   /* Retrieve run length code */
-  RunLength = 0;
-  do
-  {
-    FIO_BitGetIntUnsigned(S,1, &RLBit);
-    RunLength += (1-RLBit);
-  } while (RLBit == 0);
+  FIO_BitGetUnary(S, &RunLength);
 
   /* Retrieve least significant bits */
   FIO_BitGetIntUnsigned(S, m, &LSBs);
@@ -827,50 +817,30 @@ int ReadProbabilityTables(StrData      *SD,
 /*                                                                         */
 /* pre      : a file must be opened by using getbits_init(), ADataLen      */
 /*                                                                         */
-/* post     : AData[]                                                      */
+/* post     : AData[], ADataLen bits packed MSB first and followed by      */
+/*            ADATA_PADDING zero bytes                                     */
 /*                                                                         */
 /* uses     : fio_bit.h                                                    */
 /*                                                                         */
 /***************************************************************************/
 
-static const int spread[16] = {
-#if defined(__BIG_ENDIAN__)
-    0x00000000, 0x00000001, 0x00000100, 0x00000101,
-    0x00010000, 0x00010001, 0x00010100, 0x00010101,
-    0x01000000, 0x01000001, 0x01000100, 0x01000101,
-    0x01010000, 0x01010001, 0x01010100, 0x01010101
-#else
-    0x00000000, 0x01000000, 0x00010000, 0x01010000,
-    0x00000100, 0x01000100, 0x00010100, 0x01010100,
-    0x00000001, 0x01000001, 0x00010001, 0x01010001,
-    0x00000101, 0x01000101, 0x00010101, 0x01010101
-#endif
-};
-
 void ReadArithmeticCodedData(StrData       *SD,
                              int           ADataLen, 
                              unsigned char *AData)
 {
-  int j;
-  int val;
+  int Bytes = ADataLen / 8;
+  int Bits  = ADataLen % 8;
 
-  for(j = 0; j < ADataLen-31; j += 32)
+  /* Keep the bits packed, MSB first, rather than one bit per byte */
+  FIO_BitGetBytes(SD, Bytes, AData);
+  if (Bits > 0)
   {
-    FIO_BitGetIntUnsigned(SD, 32, &val);
-
-    /* Write out the expanded bits a nibble worth at a time */
-    *(int *)&AData[j    ] = spread[(val>>28) & 0xf];
-    *(int *)&AData[j+  4] = spread[(val>>24) & 0xf];
-    *(int *)&AData[j+  8] = spread[(val>>20) & 0xf];
-    *(int *)&AData[j+ 12] = spread[(val>>16) & 0xf];
-    *(int *)&AData[j+ 16] = spread[(val>>12) & 0xf];
-    *(int *)&AData[j+ 20] = spread[(val>> 8) & 0xf];
-    *(int *)&AData[j+ 24] = spread[(val>> 4) & 0xf];
-    *(int *)&AData[j+ 28] = spread[(val    ) & 0xf];
+    FIO_BitGetChrUnsigned(SD, Bits, &AData[Bytes]);
+    AData[Bytes++] <<= 8 - Bits;
   }
-  /* Handle remaining bits */
-  for(; j < ADataLen; j++)
-    FIO_BitGetChrUnsigned(SD, 1, &AData[j]);
+
+  /* The decoder reads a few bytes ahead of the end of the code */
+  memset(&AData[Bytes], 0, ADATA_PADDING);
 }
 
 
@@ -932,9 +902,12 @@ int UnpackDSTframe(ebunch*  D,
       return error;
 
     D->ADataLen = D->FrameHdr.CalcNrOfBits - get_in_bitcount(&D->S);
+    if (D->ADataLen / 8 + 1 + ADATA_PADDING > D->FrameHdr.BitStreamLen)
+      return DSTErr_InvalidArithmeticCode;
+
     ReadArithmeticCodedData(&D->S, D->ADataLen, D->AData);
 
-    if ((D->ADataLen > 0) && (D->AData[0] != 0))
+    if ((D->ADataLen > 0) && (D->AData[0] & 0x80))
       return DSTErr_InvalidArithmeticCode;
   }
 
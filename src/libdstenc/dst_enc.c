@@ -0,0 +1,281 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * dst_enc.c
+ *
+ * DST encoder (see dst_enc.h).
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dst_enc.h"
+#include "enc_ac.h"
+#include "enc_filter.h"
+#include "pack_dst.h"
+
+/* The quantisation scales tried for each filter: the largest one the      */
+/* coefficients fit in and then each a factor of sqrt(2) smaller. Smaller  */
+/* ones than these are hardly ever the best.                               */
+#define NROFSCALES 4
+
+static int DST_EncReverse7LSBs(int16_t c)
+{
+    const int v = (c + (1 << SIZE_PREDCOEF)) & 127;
+    int       r = 0;
+    int       i;
+
+    for (i = 0; i < 7; i++)
+    {
+        r |= ((v >> i) & 1) << (6 - i);
+    }
+
+    return r + 1;
+}
+
+/* Splits the interleaved DSD bytes into the bits of each channel. */
+static void DST_EncSplitChannels(encbunch *E, const uint8_t *MuxedDSDdata)
+{
+    const int NrOfWords = E->NrOfBitsPerCh / 64;
+    int       ChNr;
+    int       w;
+    int       i;
+
+    for (ChNr = 0; ChNr < E->NrOfChannels; ChNr++)
+    {
+        uint64_t       *Bits = &E->ChBits[ChNr * NrOfWords];
+        const uint8_t  *In   = &MuxedDSDdata[ChNr];
+
+        for (w = 0; w < NrOfWords; w++)
+        {
+            uint64_t Word = 0;
+
+            for (i = 0; i < 8; i++, In += E->NrOfChannels)
+            {
+                Word = (Word << 8) | *In;
+            }
+            Bits[w] = Word;
+        }
+    }
+}
+
+/* Finds the filter and Ptable of a channel which code it in the fewest bits, */
+/* and leaves the filter output for each bit in Predict[].                    */
+static void DST_EncChooseFilter(encbunch *E, int ChNr)
+{
+    const uint64_t *Bits    = &E->ChBits[ChNr * (E->NrOfBitsPerCh / 64)];
+    int16_t        *Predict = &E->Predict[ChNr * E->NrOfBitsPerCh];
+    double         R[(1 << SIZE_CODEDPREDORDER) + 1];
+    double         A[1 << SIZE_CODEDPREDORDER];
+    int16_t        ICoefA[1 << SIZE_CODEDPREDORDER];
+    int            Count[AC_HISMAX];
+    int            Wrong[AC_HISMAX];
+    int            P_one[AC_HISMAX];
+    double         Scale;
+    double         MaxA = 0;
+    double         TrialBits;
+    double         BestBits = -1;
+    int            BestScale = -1;
+    int            PredOrder;
+    int            PtableLen;
+    int            ScaleNr;
+    int            i;
+
+    EF_Autocorrelation(Bits, E->NrOfBitsPerCh, E->MaxPredOrder, R);
+    EF_Levinson(R, E->MaxPredOrder, A);
+    for (i = 0; i < E->MaxPredOrder; i++)
+    {
+        if (fabs(A[i]) > MaxA)
+        {
+            MaxA = fabs(A[i]);
+        }
+    }
+    if (MaxA == 0)
+    {
+        MaxA = 1;
+    }
+
+    for (ScaleNr = 0; ScaleNr < NROFSCALES; ScaleNr++)
+    {
+        Scale     = ((1 << (SIZE_PREDCOEF - 1)) - 0.5) / MaxA / pow(2.0, ScaleNr / 2.0);
+        PredOrder = EF_Quantise(A, E->MaxPredOrder, Scale, ICoefA);
+        EF_InitCoefTables(ICoefA, PredOrder, E->ICoefI);
+        EF_RunFilter(Bits, E->NrOfBitsPerCh, PredOrder, E->ICoefI, NULL, PredOrder, Count, Wrong);
+        PtableLen = EF_MakePtable(Count, Wrong, P_one);
+
+        E->PredOrder[ChNr] = PredOrder;
+        memcpy(E->ICoefA[ChNr], ICoefA, sizeof(ICoefA));
+        E->PtableLen[ChNr] = PtableLen;
+        memcpy(E->P_one[ChNr], P_one, sizeof(P_one));
+        TrialBits = EF_PtableCost(Count, Wrong, P_one, PtableLen) + PredOrder + PackFilterBits(E, ChNr) + PackPtableBits(E, ChNr);
+        if (BestBits < 0 || TrialBits < BestBits)
+        {
+            BestBits  = TrialBits;
+            BestScale = ScaleNr;
+        }
+    }
+
+    /* run the best one again for the filter output */
+    Scale              = ((1 << (SIZE_PREDCOEF - 1)) - 0.5) / MaxA / pow(2.0, BestScale / 2.0);
+    PredOrder          = EF_Quantise(A, E->MaxPredOrder, Scale, E->ICoefA[ChNr]);
+    EF_InitCoefTables(E->ICoefA[ChNr], PredOrder, E->ICoefI);
+    EF_RunFilter(Bits, E->NrOfBitsPerCh, PredOrder, E->ICoefI, Predict, PredOrder, Count, Wrong);
+    E->PredOrder[ChNr] = PredOrder;
+    E->PtableLen[ChNr] = EF_MakePtable(Count, Wrong, E->P_one[ChNr]);
+}
+
+int DST_InitEncoder(encbunch *E, int NrOfChannels, int SampleRate, int MaxPredOrder)
+{
+    memset(E, 0, sizeof(*E));
+
+    E->NrOfChannels  = NrOfChannels;
+    /*  64FS =>  4704 */
+    E->FrameLen      = 588 * SampleRate / 8;
+    E->NrOfBitsPerCh = E->FrameLen * RESOL;
+    E->MaxPredOrder  = MaxPredOrder;
+    if (NrOfChannels < 1 || NrOfChannels > MAX_CHANNELS || E->NrOfBitsPerCh > MAX_DSDBITS_INFRAME ||
+        E->NrOfBitsPerCh % 64 != 0 || MaxPredOrder < 1 || MaxPredOrder > (1 << SIZE_CODEDPREDORDER))
+    {
+        return 1;
+    }
+
+    /* room for a frame which comes out larger than the DSD, it is then */
+    /* written as plain DSD instead                                     */
+    E->StreamLen = 2 * E->FrameLen * NrOfChannels + 1024;
+    E->ChBits    = malloc(NrOfChannels * (E->NrOfBitsPerCh / 64) * sizeof(*E->ChBits));
+    E->Predict   = malloc(NrOfChannels * E->NrOfBitsPerCh * sizeof(*E->Predict));
+    E->AData     = malloc(E->StreamLen + 8);
+    E->Stream    = malloc(E->StreamLen + 8);
+    E->ICoefI    = malloc(16 * sizeof(*E->ICoefI));
+    if (!E->ChBits || !E->Predict || !E->AData || !E->Stream || !E->ICoefI)
+    {
+        DST_CloseEncoder(E);
+        return 1;
+    }
+
+    return 0;
+}
+
+int DST_CloseEncoder(encbunch *E)
+{
+    free(E->ChBits);
+    free(E->Predict);
+    free(E->AData);
+    free(E->Stream);
+    free(E->ICoefI);
+    E->ChBits  = NULL;
+    E->Predict = NULL;
+    E->AData   = NULL;
+    E->Stream  = NULL;
+    E->ICoefI  = NULL;
+
+    return 0;
+}
+
+/* Encodes the NrOfChannels * FrameLen interleaved DSD bytes of a frame, most */
+/* significant bit first, into DSTdata, which must have room for one byte     */
+/* more than that.                                                            */
+int DST_FramDSTEncode(uint8_t *MuxedDSDdata, uint8_t *DSTdata, int *FrameSizeInBytes, encbunch *E)
+{
+    const long PlainSize = 1 + E->FrameLen * E->NrOfChannels;
+    ACEncData  AC;
+    PutData    PD;
+    int        BitNr;
+    int        ChNr;
+    long       NrOfBytes;
+
+    DST_EncSplitChannels(E, MuxedDSDdata);
+    for (ChNr = 0; ChNr < E->NrOfChannels; ChNr++)
+    {
+        DST_EncChooseFilter(E, ChNr);
+    }
+
+    /* arithmetic code the bits in the order the decoder reads them, starting */
+    /* with the bit the decoder decodes (and ignores) before the first one    */
+    memset(E->AData, 0, E->StreamLen + 8);
+    EAC_Init(&AC, E->AData);
+    EAC_EncodeBit(&AC, 1, DST_EncReverse7LSBs(E->ICoefA[0][0]));
+    for (BitNr = 0; BitNr < E->NrOfBitsPerCh && AC.cbptr < E->StreamLen * 8 - 64; BitNr++)
+    {
+        const int      Shift = 63 - (BitNr & 63);
+        const uint64_t *Bits = &E->ChBits[BitNr >> 6];
+
+        for (ChNr = 0; ChNr < E->NrOfChannels; ChNr++)
+        {
+            const int16_t Predict = E->Predict[ChNr * E->NrOfBitsPerCh + BitNr];
+            const int     Bit     = (int)(Bits[ChNr * (E->NrOfBitsPerCh / 64)] >> Shift) & 1;
+            int           p;
+
+            if (BitNr < E->PredOrder[ChNr])
+            {
+                p = AC_PROBS / 2;
+            }
+            else
+            {
+                p = E->P_one[ChNr][EF_PtableIndex(Predict, E->PtableLen[ChNr])];
+            }
+            /* 1 when the bit is the one predicted */
+            EAC_EncodeBit(&AC, Bit ^ (Predict < 0), p);
+        }
+    }
+    EAC_Flush(&AC);
+
+    /* header, then the arithmetic code */
+    memset(E->Stream, 0, E->StreamLen + 8);
+    FIO_BitPutInit(&PD, E->Stream, E->StreamLen);
+    PackDSTheader(&PD, E);
+    FIO_BitPutBits(&PD, E->AData, AC.cbptr);
+    NrOfBytes = (PD.BitCounter + 7) / 8;
+
+    if (PD.Overflow || BitNr < E->NrOfBitsPerCh || NrOfBytes >= PlainSize)
+    {
+        /* plain DSD: a zero header byte and the DSD bytes as they are */
+        DSTdata[0] = 0;
+        memcpy(&DSTdata[1], MuxedDSDdata, PlainSize - 1);
+        *FrameSizeInBytes = (int)PlainSize;
+        E->PlainFrames++;
+    }
+    else
+    {
+        memcpy(DSTdata, E->Stream, NrOfBytes);
+        *FrameSizeInBytes = (int)NrOfBytes;
+        E->CodedFrames++;
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * dst_enc.h
+ *
+ * DST (Direct Stream Transfer) encoder, the counterpart of libdstdec.
+ *
+ * Each channel of a frame gets its own prediction filter, found by linear prediction on the +1/-1 signal,
+ * and its own Ptable, made from how often the filter predicts wrong for each size of its output. The bits
+ * are then arithmetic coded exactly as DST_FramDSTDecode decodes them. A frame which doesn't get smaller
+ * is stored as plain DSD.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef __DST_ENC_H_INCLUDED
+#define __DST_ENC_H_INCLUDED
+
+/*============================================================================*/
+/*       INCLUDES                                                             */
+/*============================================================================*/
+
+#include <stdint.h>
+#include "../libdstdec/conststr.h"
+
+/*============================================================================*/
+/*       TYPE DEFINITIONS                                                     */
+/*============================================================================*/
+
+typedef struct
+{
+    int      NrOfChannels;                                  /* Number of channels in the recording        */
+    long     FrameLen;                                      /* DSD bytes per channel in a frame           */
+    int      NrOfBitsPerCh;                                 /* FrameLen * RESOL                           */
+    int      MaxPredOrder;                                  /* Longest prediction filter that is tried    */
+
+    int      PredOrder[MAX_CHANNELS];                       /* Filter of each channel in this frame       */
+    int16_t  ICoefA[MAX_CHANNELS][1 << SIZE_CODEDPREDORDER];
+    int      PtableLen[MAX_CHANNELS];                       /* Ptable of each channel in this frame       */
+    int      P_one[MAX_CHANNELS][AC_HISMAX];
+
+    uint64_t *ChBits;                                       /* Bits of each channel, first bit in the MSB */
+    int16_t  *Predict;                                      /* Filter output for each bit of each channel */
+    uint8_t  *AData;                                        /* The arithmetic code, packed MSB first      */
+    uint8_t  *Stream;                                       /* The DST frame as it is written             */
+    long     StreamLen;                                     /* Size of AData and Stream in bytes          */
+    int16_t  (*ICoefI)[256];                                /* FIR lookup tables of the filter tried      */
+
+    uint64_t CodedFrames;                                   /* Frames written DST coded                   */
+    uint64_t PlainFrames;                                   /* Frames written as plain DSD                */
+} encbunch;
+
+/*============================================================================*/
+/*       FUNCTION PROTOTYPES                                                  */
+/*============================================================================*/
+
+int DST_InitEncoder(encbunch *E, int NrOfChannels, int SampleRate, int MaxPredOrder);
+int DST_FramDSTEncode(uint8_t *MuxedDSDdata, uint8_t *DSTdata, int *FrameSizeInBytes, encbunch *E);
+int DST_CloseEncoder(encbunch *E);
+
+#endif  /* __DST_ENC_H_INCLUDED */
+
+#ifdef __cplusplus
+}
+#endif
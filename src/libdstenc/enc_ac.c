@@ -0,0 +1,157 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * enc_ac.c
+ *
+ * The arithmetic encoder of the DST encoder (see enc_ac.h).
+ */
+
+#include "enc_ac.h"
+#include "../libdstdec/conststr.h"
+
+#define PBITS   AC_BITS
+#define NBITS   4
+#define ABITS   (PBITS + NBITS)
+#define ONE     (1u << ABITS)
+#define HALF    (1u << (ABITS - 1))
+
+static void EAC_PutBit(ACEncData *AC, unsigned int Bit)
+{
+    if (Bit)
+    {
+        AC->cb[AC->cbptr >> 3] |= (uint8_t)(0x80 >> (AC->cbptr & 7));
+    }
+    AC->cbptr++;
+}
+
+/* Adds one to the bits written so far. The code never reaches 1.0, so the */
+/* carry always stops before the first bit.                                */
+static void EAC_Carry(ACEncData *AC)
+{
+    long    Pos = AC->cbptr - 1;
+    uint8_t Mask;
+
+    for (;;)
+    {
+        Mask = (uint8_t)(0x80 >> (Pos & 7));
+        if ((AC->cb[Pos >> 3] & Mask) == 0)
+        {
+            break;
+        }
+        AC->cb[Pos >> 3] &= (uint8_t)~Mask;
+        Pos--;
+    }
+    AC->cb[Pos >> 3] |= Mask;
+}
+
+void EAC_Init(ACEncData *AC, uint8_t *cb)
+{
+    AC->cb    = cb;
+    AC->A     = ONE - 1;
+    AC->L     = 0;
+    AC->cbptr = 0;
+
+    /* The decoder wants the first bit of the code to be 0 */
+    EAC_PutBit(AC, 0);
+}
+
+void EAC_EncodeBit(ACEncData *AC, int b, int p)
+{
+    unsigned int ap;
+    unsigned int h;
+
+    /* approximate (A * p) with "partial rounding", as the decoder does */
+    ap = ((AC->A >> PBITS) | ((AC->A >> (PBITS - 1)) & 1)) * p;
+    h  = AC->A - ap;
+
+    /* a 1 takes the bottom part of the interval, a 0 the top part */
+    if (b)
+    {
+        AC->A = h;
+    }
+    else
+    {
+        AC->L += h;
+        AC->A  = ap;
+        if (AC->L >= ONE)
+        {
+            EAC_Carry(AC);
+            AC->L -= ONE;
+        }
+    }
+
+    while (AC->A < HALF)
+    {
+        EAC_PutBit(AC, AC->L >> (ABITS - 1));
+        AC->L = (AC->L << 1) & (ONE - 1);
+        AC->A <<= 1;
+    }
+}
+
+void EAC_Flush(ACEncData *AC)
+{
+    unsigned int Step;
+    unsigned int V;
+    int          n;
+
+    /* The decoder reads zeros after the end of the code, so write the shortest */
+    /* value which lies in the interval.                                        */
+    for (n = 1; n < ABITS; n++)
+    {
+        Step = 1u << (ABITS - n);
+        V    = (AC->L + Step - 1) & ~(Step - 1);
+        if (V < AC->L + AC->A)
+        {
+            break;
+        }
+    }
+    if (n == ABITS)
+    {
+        V = AC->L;
+    }
+    if (V >= ONE)
+    {
+        EAC_Carry(AC);
+        V -= ONE;
+    }
+    while (n-- > 0)
+    {
+        EAC_PutBit(AC, (V >> (ABITS - 1)) & 1);
+        V <<= 1;
+    }
+}
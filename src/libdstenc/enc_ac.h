@@ -0,0 +1,67 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * enc_ac.h
+ *
+ * The arithmetic encoder of the DST encoder. It is the exact inverse of LT_ACDecodeBit_Decode in
+ * libdstdec/dst_fram.c: the same 12 bit interval, the same approximation of A * p and the same
+ * renormalisation, with the carries of the additions to the low end going back into the bits already
+ * written.
+ */
+
+#ifndef __ENC_AC_H_INCLUDED
+#define __ENC_AC_H_INCLUDED
+
+#include <stdint.h>
+
+typedef struct
+{
+    unsigned int A;      /* Width of the interval                      */
+    unsigned int L;      /* Low end of the interval, the next 12 bits  */
+    long         cbptr;  /* Number of bits written to cb[]             */
+    uint8_t      *cb;    /* The code, packed MSB first                 */
+} ACEncData;
+
+/* Starts a code in cb[], which must be zeroed and large enough for it. */
+void EAC_Init(ACEncData *AC, uint8_t *cb);
+/* Codes the bit b, where p (1..128) is the probability of a 0 in 1/256ths. */
+void EAC_EncodeBit(ACEncData *AC, int b, int p);
+/* Ends the code with the fewest bits that still decode correctly, cbptr is then its length. */
+void EAC_Flush(ACEncData *AC);
+
+#endif  /* __ENC_AC_H_INCLUDED */
@@ -0,0 +1,340 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * enc_filter.c
+ *
+ * Prediction filters and Ptables for the DST encoder (see enc_filter.h).
+ */
+
+#include <math.h>
+#include <string.h>
+#include "enc_filter.h"
+
+static __inline int EF_PopCount(uint64_t x)
+{
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int n = 0;
+
+    while (x)
+    {
+        x &= x - 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+void EF_Autocorrelation(const uint64_t *Bits, int NrOfBits, int MaxLag, double *R)
+{
+    const int NrOfWords = NrOfBits / 64;
+    int       Lag;
+    int       w;
+
+    /* the product of two bits is +1 where they are equal and -1 where they */
+    /* differ, so count the differences 64 bits at a time                   */
+    for (Lag = 0; Lag <= MaxLag; Lag++)
+    {
+        const int q    = Lag >> 6;
+        const int r    = Lag & 63;
+        long      Diff = 0;
+
+        for (w = q; w < NrOfWords; w++)
+        {
+            uint64_t Delayed = Bits[w - q] >> r;
+            uint64_t d;
+
+            if (r != 0 && w > q)
+            {
+                Delayed |= Bits[w - q - 1] << (64 - r);
+            }
+            d = Bits[w] ^ Delayed;
+            if (w == q)
+            {
+                /* the first Lag bits have nothing to be compared with */
+                d &= ~(uint64_t)0 >> r;
+            }
+            Diff += EF_PopCount(d);
+        }
+        R[Lag] = (double)(NrOfBits - Lag) - 2.0 * (double)Diff;
+    }
+}
+
+void EF_Levinson(const double *R, int Order, double *A)
+{
+    double Tmp[1 << SIZE_CODEDPREDORDER];
+    double Err;
+    double Acc;
+    double K;
+    int    i;
+    int    j;
+
+    memset(A, 0, Order * sizeof(*A));
+
+    /* a little white noise keeps the long filters well conditioned */
+    Err = R[0] * 1.000001;
+    if (Err <= 0)
+    {
+        return;
+    }
+    for (i = 0; i < Order; i++)
+    {
+        Acc = R[i + 1];
+        for (j = 0; j < i; j++)
+        {
+            Acc -= A[j] * R[i - j];
+        }
+        K = Acc / Err;
+        for (j = 0; j < i; j++)
+        {
+            Tmp[j] = A[j] - K * A[i - 1 - j];
+        }
+        for (j = 0; j < i; j++)
+        {
+            A[j] = Tmp[j];
+        }
+        A[i] = K;
+        Err *= 1.0 - K * K;
+        if (Err <= 0)
+        {
+            break;
+        }
+    }
+}
+
+int EF_Quantise(const double *A, int Order, double Scale, int16_t *ICoefA)
+{
+    const int CoefMax = (1 << (SIZE_PREDCOEF - 1)) - 1;
+    int       PredOrder = 1;
+    int       i;
+    long      c;
+
+    for (i = 0; i < Order; i++)
+    {
+        c = lround(A[i] * Scale);
+        if (c > CoefMax)
+        {
+            c = CoefMax;
+        }
+        else if (c < -CoefMax - 1)
+        {
+            c = -CoefMax - 1;
+        }
+        ICoefA[i] = (int16_t)c;
+        if (c != 0)
+        {
+            PredOrder = i + 1;
+        }
+    }
+    for (i = PredOrder; i < (1 << SIZE_CODEDPREDORDER); i++)
+    {
+        ICoefA[i] = 0;
+    }
+
+    return PredOrder;
+}
+
+void EF_InitCoefTables(const int16_t *ICoefA, int PredOrder, int16_t ICoefI[16][256])
+{
+    int TableNr;
+    int k;
+    int i;
+    int j;
+
+    for (TableNr = 0; TableNr < 16; TableNr++)
+    {
+        k = PredOrder - TableNr * 8;
+        if (k > 8)
+        {
+            k = 8;
+        }
+        else if (k < 0)
+        {
+            k = 0;
+        }
+        for (i = 0; i < 256; i++)
+        {
+            int cvalue = 0;
+
+            for (j = 0; j < k; j++)
+            {
+                cvalue += (((i >> j) & 1) * 2 - 1) * ICoefA[TableNr * 8 + j];
+            }
+            ICoefI[TableNr][i] = (int16_t)cvalue;
+        }
+    }
+}
+
+int EF_PtableIndex(int16_t Predict, int PtableLen)
+{
+    int j;
+
+    j = (Predict > 0 ? Predict : -Predict) >> AC_QSTEP;
+    if (j >= PtableLen)
+    {
+        j = PtableLen - 1;
+    }
+
+    return j;
+}
+
+void EF_RunFilter(const uint64_t *Bits, int NrOfBits, int PredOrder, int16_t ICoefI[16][256], int16_t *Predict,
+                  int From, int Count[AC_HISMAX], int Wrong[AC_HISMAX])
+{
+    /* the last 128 bits, the newest in the LSB of St0, start as 0xaa bytes like the decoder's status */
+    uint64_t St0 = 0xaaaaaaaaaaaaaaaaull;
+    uint64_t St1 = 0xaaaaaaaaaaaaaaaaull;
+    const int NrOfTables = (PredOrder + 7) / 8;
+    int      BitNr;
+    int      t;
+
+    memset(Count, 0, AC_HISMAX * sizeof(*Count));
+    memset(Wrong, 0, AC_HISMAX * sizeof(*Wrong));
+
+    for (BitNr = 0; BitNr < NrOfBits; BitNr++)
+    {
+        const unsigned int Bit = (unsigned int)(Bits[BitNr >> 6] >> (63 - (BitNr & 63))) & 1;
+        int16_t            P;
+        int                Sum = 0;
+
+        /* tables past the prediction order are all zero */
+        for (t = 0; t < NrOfTables && t < 8; t++)
+        {
+            Sum += ICoefI[t][(St0 >> (8 * t)) & 255];
+        }
+        for (; t < NrOfTables; t++)
+        {
+            Sum += ICoefI[t][(St1 >> (8 * (t - 8))) & 255];
+        }
+        P = (int16_t)Sum;
+        if (Predict)
+        {
+            Predict[BitNr] = P;
+        }
+
+        /* the prediction is a 1 when P >= 0 */
+        if (BitNr >= From)
+        {
+            const int j = EF_PtableIndex(P, AC_HISMAX);
+
+            Count[j]++;
+            Wrong[j] += Bit ^ (P >= 0);
+        }
+
+        St1 = (St1 << 1) | (St0 >> 63);
+        St0 = (St0 << 1) | Bit;
+    }
+}
+
+int EF_MakePtable(const int Count[AC_HISMAX], const int Wrong[AC_HISMAX], int P_one[AC_HISMAX])
+{
+    int PtableLen = 2;
+    int Last = -1;
+    int j;
+    int p;
+
+    for (j = 0; j < AC_HISMAX; j++)
+    {
+        if (Count[j] > 0)
+        {
+            PtableLen = j + 1;
+        }
+    }
+    if (PtableLen < 2)
+    {
+        /* a Ptable of one entry can't be sent, it is always 128 */
+        PtableLen = 2;
+    }
+
+    for (j = 0; j < PtableLen; j++)
+    {
+        if (Count[j] == 0)
+        {
+            P_one[j] = -1;
+            continue;
+        }
+        p = (int)(((long)Wrong[j] * AC_PROBS + Count[j] / 2) / Count[j]);
+        if (p < 1)
+        {
+            p = 1;
+        }
+        else if (p > AC_PROBS / 2)
+        {
+            p = AC_PROBS / 2;
+        }
+        P_one[j] = p;
+        if (Last < 0)
+        {
+            /* fill in the unused entries at the start */
+            for (Last = 0; Last < j; Last++)
+            {
+                P_one[Last] = p;
+            }
+        }
+        Last = j;
+    }
+    /* unused entries after a used one repeat it, which Rice codes cheaply */
+    for (j = 0; j < PtableLen; j++)
+    {
+        if (P_one[j] < 0)
+        {
+            P_one[j] = j > 0 ? P_one[j - 1] : AC_PROBS / 2;
+        }
+    }
+
+    return PtableLen;
+}
+
+double EF_PtableCost(const int Count[AC_HISMAX], const int Wrong[AC_HISMAX], const int P_one[AC_HISMAX], int PtableLen)
+{
+    double Bits = 0;
+    int    j;
+
+    for (j = 0; j < AC_HISMAX; j++)
+    {
+        if (Count[j] > 0)
+        {
+            const double p = (double)P_one[j < PtableLen ? j : PtableLen - 1] / AC_PROBS;
+
+            Bits -= Wrong[j] * log2(p) + (Count[j] - Wrong[j]) * log2(1.0 - p);
+        }
+    }
+
+    return Bits;
+}
@@ -0,0 +1,75 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * enc_filter.h
+ *
+ * Prediction filters and Ptables for the DST encoder.
+ *
+ * The bits of a channel are taken as a +1/-1 signal and the filter is the linear predictor of it which
+ * minimises the squared error (autocorrelation and Levinson-Durbin). DST only uses the sign of the
+ * filter output as the prediction and its size to pick the probability that the prediction is wrong,
+ * so the scale that the coefficients are quantised at is chosen by trying a few and counting the bits.
+ */
+
+#ifndef __ENC_FILTER_H_INCLUDED
+#define __ENC_FILTER_H_INCLUDED
+
+#include <stdint.h>
+#include "../libdstdec/conststr.h"
+
+/* Autocorrelation R[0..MaxLag] of the +1/-1 signal of NrOfBits bits (a multiple of 64, first bit in the MSB). */
+void EF_Autocorrelation(const uint64_t *Bits, int NrOfBits, int MaxLag, double *R);
+/* Linear predictor A[0..Order-1] from R[0..Order]: x[n] is about A[0] * x[n-1] + ... + A[Order-1] * x[n-Order]. */
+void EF_Levinson(const double *R, int Order, double *A);
+/* Quantises A[0..Order-1] times Scale into coefficients, returns the prediction order left after dropping the trailing zeros. */
+int EF_Quantise(const double *A, int Order, double Scale, int16_t *ICoefA);
+/* Makes the FIR lookup tables of the coefficients, as the decoder does. */
+void EF_InitCoefTables(const int16_t *ICoefA, int PredOrder, int16_t ICoefI[16][256]);
+/* Runs the filter over the channel from the status the decoder starts each frame with. The output for each bit
+ * goes into Predict[] (if not NULL), and from bit From on the bits and the wrongly predicted bits are counted
+ * for each Ptable entry. */
+void EF_RunFilter(const uint64_t *Bits, int NrOfBits, int PredOrder, int16_t ICoefI[16][256], int16_t *Predict,
+                  int From, int Count[AC_HISMAX], int Wrong[AC_HISMAX]);
+/* Makes a Ptable from the counts, returns its length. */
+int EF_MakePtable(const int Count[AC_HISMAX], const int Wrong[AC_HISMAX], int P_one[AC_HISMAX]);
+/* The number of bits the counted bits take when coded with the Ptable. */
+double EF_PtableCost(const int Count[AC_HISMAX], const int Wrong[AC_HISMAX], const int P_one[AC_HISMAX], int PtableLen);
+/* The Ptable entry used for a filter output. */
+int EF_PtableIndex(int16_t Predict, int PtableLen);
+
+#endif  /* __ENC_FILTER_H_INCLUDED */
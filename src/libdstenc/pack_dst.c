@@ -0,0 +1,323 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * pack_dst.c
+ *
+ * Writing DST frames for the DST encoder (see pack_dst.h). Everything here is read back by the functions
+ * of the same name with Read instead of Pack in libdstdec/unpack_dst.c.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pack_dst.h"
+
+/* The predictions used to Rice code the filter coefficients and the Ptable */
+/* entries, the same as CCP_CalcInit sets up for the decoder.               */
+static const int FilterCPredOrder[NROFFRICEMETHODS] = { 1, 2, 3 };
+static const int FilterCPredCoef[NROFFRICEMETHODS][MAXCPREDORDER] = { { -8, 0, 0 }, { -16, 8, 0 }, { -9, -5, 6 } };
+static const int PtableCPredOrder[NROFPRICEMETHODS] = { 1, 2, 3 };
+static const int PtableCPredCoef[NROFPRICEMETHODS][MAXCPREDORDER] = { { -8, 0, 0 }, { -16, 8, 0 }, { -24, 24, -8 } };
+
+/* How the entries of a filter or Ptable are coded */
+typedef struct
+{
+    int  Method;  /* -1 for plain, otherwise the Rice method */
+    int  m;       /* Rice parameter                          */
+    long Bits;    /* Bits taken by the entries and the coding */
+} TableCoding;
+
+void FIO_BitPutInit(PutData *PD, uint8_t *pDSTdata, long MaxBytes)
+{
+    PD->pDSTdata   = pDSTdata;
+    PD->MaxBits    = MaxBytes * 8;
+    PD->BitCounter = 0;
+    PD->Overflow   = 0;
+}
+
+void FIO_BitPutIntUnsigned(PutData *PD, int Len, long x)
+{
+    while (Len-- > 0)
+    {
+        if (PD->BitCounter >= PD->MaxBits)
+        {
+            PD->Overflow = 1;
+            return;
+        }
+        if ((x >> Len) & 1)
+        {
+            PD->pDSTdata[PD->BitCounter >> 3] |= (uint8_t)(0x80 >> (PD->BitCounter & 7));
+        }
+        PD->BitCounter++;
+    }
+}
+
+void FIO_BitPutBits(PutData *PD, const uint8_t *Bits, long Len)
+{
+    const int Shift = (int)(PD->BitCounter & 7);
+    uint8_t   *Out;
+    long      i;
+
+    if (PD->BitCounter + Len > PD->MaxBits)
+    {
+        PD->Overflow = 1;
+        return;
+    }
+
+    /* whole bytes, shifted to where the stream is up to */
+    Out = &PD->pDSTdata[PD->BitCounter >> 3];
+    for (i = 0; i < Len / 8; i++)
+    {
+        Out[i] |= (uint8_t)(Bits[i] >> Shift);
+        if (Shift != 0)
+        {
+            Out[i + 1] = (uint8_t)(Bits[i] << (8 - Shift));
+        }
+    }
+    PD->BitCounter += (Len / 8) * 8;
+    if (Len % 8 != 0)
+    {
+        FIO_BitPutIntUnsigned(PD, (int)(Len % 8), Bits[Len / 8] >> (8 - Len % 8));
+    }
+}
+
+static int PackLog2RoundUp(long x)
+{
+    int y = 0;
+
+    while (x >= (1 << y))
+    {
+        y++;
+    }
+
+    return y;
+}
+
+/* The value the decoder Rice decodes for entry Nr of a table */
+static int PackRiceValue(const int *Val, int Nr, const int *CPredCoef, int CPredOrder)
+{
+    int TapNr;
+    int x = 0;
+
+    for (TapNr = 0; TapNr < CPredOrder; TapNr++)
+    {
+        x += CPredCoef[TapNr] * Val[Nr - TapNr - 1];
+    }
+
+    return (x >= 0) ? Val[Nr] + (x + 4) / 8 : Val[Nr] - (-x + 3) / 8;
+}
+
+static long PackRiceBits(int Nr, int m)
+{
+    const int Mag = abs(Nr);
+
+    return (Mag >> m) + 1 + m + (Nr != 0);
+}
+
+static void RiceEncode(PutData *PD, int Nr, int m)
+{
+    const int Mag = abs(Nr);
+    int       RunLength;
+
+    /* run length in unary, then the least significant bits and a sign */
+    for (RunLength = Mag >> m; RunLength > 0; RunLength--)
+    {
+        FIO_BitPutIntUnsigned(PD, 1, 0);
+    }
+    FIO_BitPutIntUnsigned(PD, 1, 1);
+    FIO_BitPutIntUnsigned(PD, m, Mag & ((1 << m) - 1));
+    if (Nr != 0)
+    {
+        FIO_BitPutIntUnsigned(PD, 1, Nr < 0);
+    }
+}
+
+/* Picks the cheapest way of coding Val[0..Len-1], entries of EntryBits bits each. */
+static void PackChooseCoding(const int *Val, int Len, int EntryBits, const int *CPredOrder,
+                             const int (*CPredCoef)[MAXCPREDORDER], int NrOfMethods, int MaxM, TableCoding *TC)
+{
+    int  Method;
+    int  m;
+    int  Nr;
+    long Bits;
+
+    TC->Method = -1;
+    TC->m      = 0;
+    TC->Bits   = (long)Len * EntryBits;
+
+    for (Method = 0; Method < NrOfMethods; Method++)
+    {
+        if (CPredOrder[Method] >= Len)
+        {
+            continue;
+        }
+        for (m = 0; m <= MaxM; m++)
+        {
+            Bits = SIZE_RICEMETHOD + (long)CPredOrder[Method] * EntryBits + SIZE_RICEM;
+            for (Nr = CPredOrder[Method]; Nr < Len; Nr++)
+            {
+                Bits += PackRiceBits(PackRiceValue(Val, Nr, CPredCoef[Method], CPredOrder[Method]), m);
+            }
+            if (Bits < TC->Bits)
+            {
+                TC->Method = Method;
+                TC->m      = m;
+                TC->Bits   = Bits;
+            }
+        }
+    }
+}
+
+/* Writes the Coded flag and the entries, the first ones plain as Val - Offset. */
+static void PackTable(PutData *PD, const int *Val, int Len, int EntryBits, int Offset, const int *CPredOrder,
+                      const int (*CPredCoef)[MAXCPREDORDER], const TableCoding *TC)
+{
+    const long Mask = (1L << EntryBits) - 1;
+    int        Nr;
+
+    FIO_BitPutIntUnsigned(PD, 1, TC->Method >= 0);
+    if (TC->Method < 0)
+    {
+        for (Nr = 0; Nr < Len; Nr++)
+        {
+            FIO_BitPutIntUnsigned(PD, EntryBits, (Val[Nr] - Offset) & Mask);
+        }
+        return;
+    }
+
+    FIO_BitPutIntUnsigned(PD, SIZE_RICEMETHOD, TC->Method);
+    for (Nr = 0; Nr < CPredOrder[TC->Method]; Nr++)
+    {
+        FIO_BitPutIntUnsigned(PD, EntryBits, (Val[Nr] - Offset) & Mask);
+    }
+    FIO_BitPutIntUnsigned(PD, SIZE_RICEM, TC->m);
+    for (Nr = CPredOrder[TC->Method]; Nr < Len; Nr++)
+    {
+        RiceEncode(PD, PackRiceValue(Val, Nr, CPredCoef[TC->Method], CPredOrder[TC->Method]), TC->m);
+    }
+}
+
+static void PackFilterCoding(encbunch *E, int ChNr, int *Coef, TableCoding *TC)
+{
+    int CoefNr;
+
+    for (CoefNr = 0; CoefNr < E->PredOrder[ChNr]; CoefNr++)
+    {
+        Coef[CoefNr] = E->ICoefA[ChNr][CoefNr];
+    }
+    PackChooseCoding(Coef, E->PredOrder[ChNr], SIZE_PREDCOEF, FilterCPredOrder, FilterCPredCoef,
+                     NROFFRICEMETHODS, MAX_RICE_M_F, TC);
+}
+
+long PackFilterBits(encbunch *E, int ChNr)
+{
+    int         Coef[1 << SIZE_CODEDPREDORDER];
+    TableCoding TC;
+
+    PackFilterCoding(E, ChNr, Coef, &TC);
+
+    return SIZE_CODEDPREDORDER + 1 + TC.Bits;
+}
+
+long PackPtableBits(encbunch *E, int ChNr)
+{
+    TableCoding TC;
+
+    if (E->PtableLen[ChNr] == 1)
+    {
+        return AC_HISBITS;
+    }
+    PackChooseCoding(E->P_one[ChNr], E->PtableLen[ChNr], AC_BITS - 1, PtableCPredOrder, PtableCPredCoef,
+                     NROFPRICEMETHODS, MAX_RICE_M_P, &TC);
+
+    return AC_HISBITS + 1 + TC.Bits;
+}
+
+void PackDSTheader(PutData *PD, encbunch *E)
+{
+    int         Coef[1 << SIZE_CODEDPREDORDER];
+    TableCoding TC;
+    int         ChNr;
+
+    /* DST coded */
+    FIO_BitPutIntUnsigned(PD, 1, 1);
+
+    /* Segmentation: the Ptables are segmented as the filters, and there is */
+    /* one segment, the same for all channels                               */
+    FIO_BitPutIntUnsigned(PD, 1, 1);   /* PSameSegAsF   */
+    FIO_BitPutIntUnsigned(PD, 1, 1);   /* FSameSegAllCh */
+    FIO_BitPutIntUnsigned(PD, 1, 1);   /* EndOfChannel  */
+
+    /* Mapping: the Ptables are mapped as the filters, and each channel has */
+    /* its own filter, numbered as the channels are                         */
+    FIO_BitPutIntUnsigned(PD, 1, 1);   /* PSameMapAsF   */
+    FIO_BitPutIntUnsigned(PD, 1, E->NrOfChannels == 1);   /* FSameMapAllCh */
+    if (E->NrOfChannels > 1)
+    {
+        for (ChNr = 1; ChNr < E->NrOfChannels; ChNr++)
+        {
+            FIO_BitPutIntUnsigned(PD, PackLog2RoundUp(ChNr), ChNr);
+        }
+    }
+
+    /* HalfProb: the first PredOrder bits of each channel, which are predicted */
+    /* from the start status rather than the signal, are coded with p = 1/2    */
+    for (ChNr = 0; ChNr < E->NrOfChannels; ChNr++)
+    {
+        FIO_BitPutIntUnsigned(PD, 1, 1);
+    }
+
+    /* Filters */
+    for (ChNr = 0; ChNr < E->NrOfChannels; ChNr++)
+    {
+        PackFilterCoding(E, ChNr, Coef, &TC);
+        FIO_BitPutIntUnsigned(PD, SIZE_CODEDPREDORDER, E->PredOrder[ChNr] - 1);
+        PackTable(PD, Coef, E->PredOrder[ChNr], SIZE_PREDCOEF, 0, FilterCPredOrder, FilterCPredCoef, &TC);
+    }
+
+    /* Ptables */
+    for (ChNr = 0; ChNr < E->NrOfChannels; ChNr++)
+    {
+        FIO_BitPutIntUnsigned(PD, AC_HISBITS, E->PtableLen[ChNr] - 1);
+        if (E->PtableLen[ChNr] > 1)
+        {
+            PackChooseCoding(E->P_one[ChNr], E->PtableLen[ChNr], AC_BITS - 1, PtableCPredOrder, PtableCPredCoef,
+                             NROFPRICEMETHODS, MAX_RICE_M_P, &TC);
+            PackTable(PD, E->P_one[ChNr], E->PtableLen[ChNr], AC_BITS - 1, 1, PtableCPredOrder, PtableCPredCoef, &TC);
+        }
+    }
+}
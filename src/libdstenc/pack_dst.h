@@ -0,0 +1,71 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+/*
+ * pack_dst.h
+ *
+ * Writing DST frames for the DST encoder, the counterpart of libdstdec/unpack_dst.c.
+ */
+
+#ifndef __PACK_DST_H_INCLUDED
+#define __PACK_DST_H_INCLUDED
+
+#include <stdint.h>
+#include "dst_enc.h"
+
+typedef struct
+{
+    uint8_t *pDSTdata;   /* Zeroed buffer the bits are written into, MSB first */
+    long    MaxBits;     /* Size of pDSTdata in bits                           */
+    long    BitCounter;  /* Bits written so far                                */
+    int     Overflow;    /* 1 if more than MaxBits bits were written           */
+} PutData;
+
+void FIO_BitPutInit(PutData *PD, uint8_t *pDSTdata, long MaxBytes);
+/* Writes the Len (0..24) LSBs of x. */
+void FIO_BitPutIntUnsigned(PutData *PD, int Len, long x);
+/* Writes the first Len bits of Bits[]. */
+void FIO_BitPutBits(PutData *PD, const uint8_t *Bits, long Len);
+
+/* The number of bits the filter of a channel takes in the frame header. */
+long PackFilterBits(encbunch *E, int ChNr);
+/* The number of bits the Ptable of a channel takes in the frame header. */
+long PackPtableBits(encbunch *E, int ChNr);
+/* Writes the header of a DST coded frame (one segment and one filter and Ptable per channel). */
+void PackDSTheader(PutData *PD, encbunch *E);
+
+#endif  /* __PACK_DST_H_INCLUDED */
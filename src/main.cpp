@@ -40,15 +40,77 @@
 #include <FLAC++/metadata.h>
 #include <FLAC++/encoder.h>
 #include <sstream>
+#include <vector>
+#include <algorithm>
 #include <cmath>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <fcntl.h>
+#include <unistd.h>
 #include "cmdline.h"
 #include "dsd_decimator.h"
+#include "dsd_popcount_decimator.h"
+#include "dsd_cic_decimator.h"
+#include "dsd_batch_decimator.h"
 #include "dsf_file_reader.h"
 #include "dsdiff_file_reader.h"
+#include "dsdiff_file_writer.h"
+#include "dsf_file_writer.h"
 #include "tagConversion.h"
+#include "id3/misc_support.h"
 #include "dop_packer.h"
+#include "pipe_buffer.h"
 
 #define flacBlockLen 1024
+#define dsdBlockLen 4096
+
+/**
+ * DecimatorEngine
+ *
+ * which of the DsdDecimator classes is used for PCM conversion.
+ */
+enum DecimatorEngine {
+	tableEngine, // DsdDecimator
+	cicEngine, // DsdCicDecimator
+	popcountEngine // DsdPopcountDecimator
+};
+
+/**
+ * PcmOutputSpec
+ *
+ * the sample rate, bit depth and dither setting of one PCM output.
+ */
+struct PcmOutputSpec {
+	int fs;
+	int bits;
+	bool dither;
+};
+
+/**
+ * PcmOutput
+ *
+ * the state of one PCM output while the tracks are being converted.
+ */
+struct PcmOutput {
+	PcmOutputSpec spec;
+	DsdDecimator* dec;
+	FLAC::Encoder::File* encoder;
+	FLAC__StreamMetadata* metadata[2];
+	FLAC__int32* buffer;
+	unsigned int bufferFill;
+	dsf2flac_float64 scale;
+	dsf2flac_float64 tpdfDitherPeakAmplitude;
+	dsf2flac_float64 clipAmplitude;
+	dsf2flac_uint32 track;
+	dsf2flac_float64 startPos;
+	dsf2flac_float64 endPos;
+	dsf2flac_uint32 countdown; // reader steps until the next sample is due
+	dsf2flac_int64 gridOrigin; // reader position (in uint8s) of the first sample of the first track, the rest follow every getDecimationRatio()/8
+	bool started;
+	bool finished;
+	bool ok;
+};
 
 using boost::timer::cpu_timer;
 using boost::timer::cpu_times;
@@ -103,34 +165,81 @@ boost::filesystem::path muti_track_name_helper(boost::filesystem::path outpath,
 }
 
 /**
- * int track_helper()
- * 
- * converts a track at a time to PCM FLAC
- * 
+ * multi_rate_name_helper
+ *
+ * little helper to construct file names when several PCM outputs are made from one input.
+ */
+boost::filesystem::path multi_rate_name_helper(boost::filesystem::path outpath, PcmOutputSpec spec) {
+	std::ostringstream suffix;
+	suffix << " [";
+	suffix << spec.fs;
+	suffix << "Hz ";
+	suffix << spec.bits;
+	suffix << "bit]";
+	boost::filesystem::path rateOutPath = outpath.parent_path() / (outpath.stem().string() + suffix.str() + outpath.extension().string());
+	return rateOutPath;
+}
+
+/**
+ * bool parse_output_specs()
+ *
+ * parses a comma separated list of rate[:bits[:nodither]] output specs.
+ * bits and dither default to the values given by -b and -n.
  */
-bool pcm_track_helper(
+bool parse_output_specs(const char* arg, int defaultBits, bool defaultDither, std::vector<PcmOutputSpec> &specs)
+{
+	std::istringstream list(arg);
+	std::string item;
+	while (std::getline(list,item,',')) {
+		PcmOutputSpec spec;
+		spec.fs = 0;
+		spec.bits = defaultBits;
+		spec.dither = defaultDither;
+		std::istringstream fields(item);
+		std::string field;
+		int n = 0;
+		while (std::getline(fields,field,':')) {
+			if (n == 0)
+				spec.fs = atoi(field.c_str());
+			else if (n == 1)
+				spec.bits = atoi(field.c_str());
+			else if (n == 2 && field == "nodither")
+				spec.dither = false;
+			else if (n == 2 && field == "dither")
+				spec.dither = true;
+			else
+				return false;
+			n++;
+		}
+		if (spec.fs <= 0 || (spec.bits != 16 && spec.bits != 20 && spec.bits != 24))
+			return false;
+		specs.push_back(spec);
+	}
+	return !specs.empty();
+}
+
+/**
+ * bool pcm_encoder_init()
+ *
+ * creates and sets up a flac encoder (and its metadata) for a PCM output file.
+ */
+bool pcm_encoder_init(
+	FLAC::Encoder::File* &encoderPtr,
+	FLAC__StreamMetadata** metadata,
 	boost::filesystem::path outpath,
-	DsdDecimator* dec,
+	dsf2flac_uint32 channels,
 	int bits,
-	dsf2flac_float64 scale,
-	dsf2flac_float64 tpdfDitherPeakAmplitude,
-	dsf2flac_float64 clipAmplitude,
-	dsf2flac_float64 startPos,
-	dsf2flac_float64 endPos,
+	dsf2flac_uint32 sampleRate,
+	dsf2flac_uint64 totalSamplesEstimate,
 	ID3_Tag	id3tag)
 {
-	
-	if ( startPos > dec->getLength()-1 )
-		startPos = dec->getLength()-1;
-		
-	if ( endPos > dec->getLength() )
-		endPos = dec->getLength();
-	
+	metadata[0] = metadata[1] = NULL;
+
 	// flac vars
 	bool ok = true;
-	FLAC::Encoder::File encoder;
+	encoderPtr = new FLAC::Encoder::File;
+	FLAC::Encoder::File &encoder = *encoderPtr;
 	FLAC__StreamEncoderInitStatus init_status;
-	FLAC__StreamMetadata* metadata[2];
 
 	// setup the encoder
 	if(!encoder) {
@@ -139,10 +248,10 @@ bool pcm_track_helper(
 	}
 	ok &= encoder.set_verify(true);
 	ok &= encoder.set_compression_level(5);
-	ok &= encoder.set_channels(dec->getNumChannels());
+	ok &= encoder.set_channels(channels);
 	ok &= encoder.set_bits_per_sample(bits);
-	ok &= encoder.set_sample_rate(dec->getOutputSampleRate());
-	ok &= encoder.set_total_samples_estimate(endPos - startPos);
+	ok &= encoder.set_sample_rate(sampleRate);
+	ok &= encoder.set_total_samples_estimate(totalSamplesEstimate);
 
 	// add tags and a padding block
 	if(ok) {
@@ -151,7 +260,7 @@ bool pcm_track_helper(
 		metadata[1]->length = 2048; /* set the padding length */
 		ok = encoder.set_metadata(metadata, 2);
 	}
-	
+
 	// initialize encoder
 	if(ok) {
 		init_status = encoder.init(outpath.c_str());
@@ -161,40 +270,28 @@ bool pcm_track_helper(
 		}
 	}
 
-	// return if there is a problem with any of the flac stuff.
-	if (!ok)
-		return ok;
+	return ok;
+}
 
-	// creep up to the start point.
-	while (dec->getPosition() < startPos) {
-		dec->step();
-	}
-	// create a FLAC__int32 buffer to hold the samples as they are converted
-	unsigned int bufferLen = dec->getNumChannels()*flacBlockLen;
-	FLAC__int32* buffer = new FLAC__int32[bufferLen];
-	// MAIN CONVERSION LOOP //
-	while (dec->getPosition() <= endPos-flacBlockLen) {
-		dec->getSamples(buffer,bufferLen,scale,tpdfDitherPeakAmplitude,clipAmplitude);
-		if(!(ok = encoder.process_interleaved(buffer, flacBlockLen)))
-			fprintf(stderr, "   state: %s\n", encoder.get_state().resolved_as_cstring(encoder));
-		checkTimer(dec->getPositionInSeconds(),dec->getPositionAsPercent());
-	}
-	// delete the old buffer and make a new one with a single sample per chan
-	delete[] buffer;
-	buffer = new FLAC__int32[dec->getNumChannels()];
-	// creep up to the end
-	while (dec->getPosition() <= endPos) {
-		dec->getSamples(buffer,dec->getNumChannels(),scale,tpdfDitherPeakAmplitude,clipAmplitude);
-		if(!(ok = encoder.process_interleaved(buffer, 1)))
-			fprintf(stderr, "   state: %s\n", encoder.get_state().resolved_as_cstring(encoder));
-		checkTimer(dec->getPositionInSeconds(),dec->getPositionAsPercent());
-	}
-	delete[] buffer;
+/**
+ * bool pcm_encoder_finish()
+ *
+ * closes the flac file, reports back to the user and frees the encoder and metadata.
+ */
+bool pcm_encoder_finish(
+	FLAC::Encoder::File* &encoderPtr,
+	FLAC__StreamMetadata** metadata,
+	bool ok,
+	dsf2flac_float64 percent)
+{
+	if (!encoderPtr)
+		return true;
+	FLAC::Encoder::File &encoder = *encoderPtr;
 	// close the flac file
 	ok &= encoder.finish();
 	// report back to the user
 	fprintf(stderr,"\33[2K\r");
-	fprintf(stderr,"%3.1f%%\t",dec->getPositionAsPercent());
+	fprintf(stderr,"%3.1f%%\t",percent);
 	if (ok) {
 		fprintf(stderr,"Conversion completed sucessfully.\n");
 	} else {
@@ -203,8 +300,220 @@ bool pcm_track_helper(
 		fprintf(stderr, "   state: %s\n", encoder.get_state().resolved_as_cstring(encoder));
 	}
 	// free things
-	FLAC__metadata_object_delete(metadata[0]);
-	FLAC__metadata_object_delete(metadata[1]);
+	if (metadata[0])
+		FLAC__metadata_object_delete(metadata[0]);
+	if (metadata[1])
+		FLAC__metadata_object_delete(metadata[1]);
+	metadata[0] = metadata[1] = NULL;
+	delete encoderPtr;
+	encoderPtr = NULL;
+
+	return ok;
+}
+
+/**
+ * void pcm_track_bounds()
+ *
+ * works out the start and end of track n in the output samples of a decimator.
+ */
+void pcm_track_bounds(
+	DsdDecimator* dec,
+	DsdSampleReader* dsr,
+	dsf2flac_uint32 n,
+	bool onefile,
+	dsf2flac_float64 &startPos,
+	dsf2flac_float64 &endPos)
+{
+	if (onefile) {
+		// convert whole file
+		startPos = dec->getFirstValidSample();
+		endPos = dec->getLastValidSample();
+	} else {
+		// get and check the start and end samples
+		startPos = (dsf2flac_float64)dsr->getTrackStart(n) / dec->getDecimationRatio();
+		endPos = (dsf2flac_float64)dsr->getTrackEnd(n) / dec->getDecimationRatio();
+		if (startPos < dec->getFirstValidSample())
+			startPos = dec->getFirstValidSample();
+		if (startPos >= dec->getLastValidSample() )
+			startPos = dec->getLastValidSample() - 1;
+		if (endPos <= dec->getFirstValidSample())
+			endPos = dec->getFirstValidSample() + 1;
+		if (endPos > dec->getLastValidSample())
+			endPos = dec->getLastValidSample();
+	}
+
+	if ( startPos > dec->getLength()-1 )
+		startPos = dec->getLength()-1;
+
+	if ( endPos > dec->getLength() )
+		endPos = dec->getLength();
+}
+
+/**
+ * bool pcm_output_open_track()
+ *
+ * works out the start and end of track n for one PCM output and sets up a flac encoder for it.
+ */
+bool pcm_output_open_track(
+	PcmOutput* out,
+	DsdSampleReader* dsr,
+	dsf2flac_uint32 n,
+	boost::filesystem::path outpath,
+	bool onefile,
+	bool multiRate)
+{
+	DsdDecimator* dec = out->dec;
+	dsf2flac_float64 startPos;
+	dsf2flac_float64 endPos;
+	ID3_Tag id3tag;
+
+	pcm_track_bounds(dec,dsr,n,onefile,startPos,endPos);
+	if (onefile)
+		id3tag = NULL;
+	else
+		id3tag = dsr->getID3Tag(n);
+
+	// construct an appropriate filename for multi rate and multi track files.
+	boost::filesystem::path trackOutPath = outpath;
+	if (multiRate)
+		trackOutPath = multi_rate_name_helper(trackOutPath,out->spec);
+	if (!onefile && dsr->getNumTracks() > 1)
+		trackOutPath = muti_track_name_helper(trackOutPath,n);
+	printf("Output file\n\t%s\n",trackOutPath.c_str());
+
+	out->track = n;
+	out->startPos = startPos;
+	out->endPos = endPos;
+	out->started = false;
+	out->countdown = 0;
+	out->bufferFill = 0;
+
+	return pcm_encoder_init(out->encoder,out->metadata,trackOutPath,dec->getNumChannels(),out->spec.bits,dec->getOutputSampleRate(),endPos - startPos,id3tag);
+}
+
+/**
+ * void pcm_output_flush()
+ *
+ * passes the samples held in the buffer of an output to its encoder.
+ */
+void pcm_output_flush(PcmOutput* out)
+{
+	if (out->bufferFill == 0)
+		return;
+	if(!(out->ok = out->encoder->process_interleaved(out->buffer, out->bufferFill)))
+		fprintf(stderr, "   state: %s\n", out->encoder->get_state().resolved_as_cstring(*out->encoder));
+	out->bufferFill = 0;
+}
+
+/**
+ * bool pcm_output_close_track()
+ *
+ * flushes and closes the flac file of the current track of an output.
+ */
+bool pcm_output_close_track(PcmOutput* out)
+{
+	if (!out->encoder)
+		return true;
+	pcm_output_flush(out);
+	return pcm_encoder_finish(out->encoder,out->metadata,out->ok,out->dec->getPositionAsPercent());
+}
+
+/**
+ * int track_helper()
+ * 
+ * converts the tracks to PCM FLAC, feeding every output from a single pass over the reader.
+ * ReaderType is the concrete reader class where it is known, so the per byte step() can be inlined.
+ * 
+ */
+template <class ReaderType> bool pcm_track_helper(
+	std::vector<PcmOutput*> &outputs,
+	ReaderType* dsr,
+	boost::filesystem::path outpath,
+	bool onefile,
+	dsf2flac_int32 onlyTrack)
+{
+	bool ok = true;
+	dsf2flac_uint32 firstTrack = onlyTrack >= 0 ? onlyTrack : 0;
+	dsf2flac_uint32 numTracks = onefile ? 1 : onlyTrack >= 0 ? onlyTrack+1 : dsr->getNumTracks();
+	dsf2flac_uint32 nFinished = 0;
+	dsf2flac_uint32 nSteps = 0;
+
+	// samples are taken at the same reader positions whichever track is converted first:
+	// those a conversion of every track would use, counting from the start of the first track.
+	for (dsf2flac_uint32 j = 0; j < outputs.size(); j++) {
+		DsdDecimator* dec = outputs[j]->dec;
+		dsf2flac_float64 startPos, endPos;
+		pcm_track_bounds(dec,dsr,0,onefile,startPos,endPos);
+		outputs[j]->gridOrigin = (dsf2flac_int64)ceil((startPos*dec->getDecimationRatio() + dec->getFilterDelay())/8);
+	}
+
+	// start the first track of each output
+	for (dsf2flac_uint32 j = 0; j < outputs.size(); j++) {
+		if (!pcm_output_open_track(outputs[j],dsr,firstTrack,outpath,onefile,outputs.size() > 1)) {
+			// return if there is a problem with any of the flac stuff.
+			for (dsf2flac_uint32 k = 0; k <= j; k++)
+				pcm_output_close_track(outputs[k]);
+			return false;
+		}
+	}
+
+	// jump to just before the earliest start point rather than stepping through everything before it.
+	// (the reader is at the start point of an output when its decimator position reaches startPos)
+	dsf2flac_float64 seekPos = -1;
+	for (dsf2flac_uint32 j = 0; j < outputs.size(); j++) {
+		DsdDecimator* dec = outputs[j]->dec;
+		dsf2flac_float64 p = outputs[j]->startPos * dec->getDecimationRatio() + dec->getFilterDelay() - 8;
+		if (j == 0 || p < seekPos)
+			seekPos = p;
+	}
+	if (seekPos > dsr->getPosition())
+		dsr->seek((dsf2flac_int64)seekPos);
+
+	// MAIN CONVERSION LOOP //
+	// the reader is stepped one byte at a time and each output takes a sample whenever one is due.
+	// An output moves straight on to its next track from the position where its last one ended.
+	while (nFinished < outputs.size()) {
+		for (dsf2flac_uint32 j = 0; j < outputs.size(); j++) {
+			PcmOutput* out = outputs[j];
+			while (!out->finished) {
+				// creep up to the start point.
+				if (!out->started) {
+					if (out->dec->getPosition() < out->startPos)
+						break;
+					if ((dsr->getPosition()/8 - out->gridOrigin) % (out->dec->getDecimationRatio()/8) != 0)
+						break;
+					out->started = true;
+				}
+				// wait until the next sample of this output is due.
+				if (out->countdown > 0 && --out->countdown > 0)
+					break;
+				if (out->dec->getPosition() <= out->endPos) {
+					out->dec->getCurrentSamples(&out->buffer[out->bufferFill*out->dec->getNumChannels()],out->scale,out->tpdfDitherPeakAmplitude,out->clipAmplitude);
+					if (++out->bufferFill == flacBlockLen)
+						pcm_output_flush(out);
+					out->countdown = out->dec->getDecimationRatio()/8;
+					break;
+				}
+				// passed the end of this track
+				ok &= pcm_output_close_track(out);
+				if (out->track+1 < numTracks) {
+					if (pcm_output_open_track(out,dsr,out->track+1,outpath,onefile,outputs.size() > 1))
+						continue;
+					// the flac stuff for the next track failed, so free it (reporting the error) and give up on the rest of this output.
+					out->ok = false;
+					ok &= pcm_output_close_track(out);
+					ok = false;
+				}
+				out->finished = true;
+				nFinished++;
+			}
+		}
+		if (nFinished < outputs.size()) {
+			dsr->step();
+			if (++nSteps % (flacBlockLen*4) == 0)
+				checkTimer(dsr->getPositionInSeconds(),dsr->getPositionAsPercent());
+		}
+	}
 
 	return ok;
 }
@@ -212,79 +521,353 @@ bool pcm_track_helper(
 /*
  * do_pcm_conversion
  *
- * this function uses a dsdDecimator to do the conversion into PCM.
+ * this function uses one dsdDecimator per output spec to do the conversion into PCM.
+ * engine selects the DsdCicDecimator or the much faster (but much worse) DsdPopcountDecimator instead.
+ * All of the outputs are fed from a single pass over the reader, so the input is only read (and DST decoded) once.
+ * onlyTrack is the index of the one track to convert, or -1 for all of them.
  */
-bool do_pcm_conversion(
-		DsdSampleReader* dsr,
-		int fs,
-		int bits,
-		bool dither,
+template <class ReaderType> bool do_pcm_conversion(
+		ReaderType* dsr,
+		std::vector<PcmOutputSpec> specs,
 		dsf2flac_float64 userScale,
 		boost::filesystem::path inpath,
 		boost::filesystem::path outpath,
-		bool onefile
+		bool onefile,
+		DecimatorEngine engine,
+		dsf2flac_int32 onlyTrack
 		)
 {
 
 	bool ok = true;
 
-	// create decimator
-	DsdDecimator dec(dsr,fs);
-	if (!dec.isValid()) {
-		fprintf(stderr,"%s\n",dec.getErrorMsg().c_str());
+	// create a decimator for each output
+	std::vector<PcmOutput*> outputs;
+	for (dsf2flac_uint32 i = 0; i < specs.size(); i++) {
+		PcmOutput* out = new PcmOutput;
+		out->spec = specs[i];
+		if (engine == popcountEngine)
+			out->dec = new DsdPopcountDecimator(dsr,specs[i].fs);
+		else if (engine == cicEngine)
+			out->dec = new DsdCicDecimator(dsr,specs[i].fs);
+		else
+			out->dec = new DsdDecimator(dsr,specs[i].fs);
+		out->encoder = NULL;
+		out->buffer = NULL;
+		out->finished = false;
+		out->ok = true;
+		outputs.push_back(out);
+		if (!out->dec->isValid()) {
+			fprintf(stderr,"%s\n",out->dec->getErrorMsg().c_str());
+			ok = false;
+			continue;
+		}
+		// calc real scale and dither amplitude
+		int bits = specs[i].bits;
+		out->scale = userScale * pow(2.0,bits-1); // increase scale by factor of 2^23 (24bit).
+		if (specs[i].dither)
+			out->tpdfDitherPeakAmplitude = 1.0;
+		else
+			out->tpdfDitherPeakAmplitude = 0.0;
+		out->clipAmplitude = pow(2.0,bits-1)-1; // clip at max range.
+		// create a FLAC__int32 buffer to hold the samples as they are converted
+		out->buffer = new FLAC__int32[out->dec->getNumChannels()*flacBlockLen];
+	}
+
+	setupTimer(dsr->getPositionInSeconds());
+
+	// use the pcm_track_helper
+	if (ok)
+		ok &= pcm_track_helper(outputs,dsr,outpath,onefile,onlyTrack);
+
+	for (dsf2flac_uint32 i = 0; i < outputs.size(); i++) {
+		delete[] outputs[i]->buffer;
+		delete outputs[i]->dec;
+		delete outputs[i];
+	}
+
+	return ok;
+}
+
+/**
+ * DsdSampleReader* create_reader()
+ *
+ * creates either a reader for dsf or dsd, depending on the file extension. Returns NULL for other files.
+ * A headersOnly reader can describe the file but not read samples.
+ */
+DsdSampleReader* create_reader(boost::filesystem::path inpath, bool headersOnly = false)
+{
+	// stdin has no extension, so look at the magic at the start of the stream instead.
+	if (inpath == "-") {
+		char magic[4];
+		PipeBuffer* in = PipeBuffer::getStdin();
+		std::streamsize n = in->sgetn(magic,4);
+		in->pubseekpos(0);
+		if (n == 4 && !strncmp(magic,"DSD ",4))
+			return new DsfFileReader((char*)"-",headersOnly);
+		else if (n == 4 && !strncmp(magic,"FRM8",4))
+			return new DsdiffFileReader((char*)"-",headersOnly);
+		return NULL;
+	}
+	if (inpath.extension() == ".dsf" || inpath.extension() == ".DSF")
+		return new DsfFileReader((char*)inpath.c_str(),headersOnly);
+	else if (inpath.extension() == ".dff" || inpath.extension() == ".DFF")
+		return new DsdiffFileReader((char*)inpath.c_str(),headersOnly);
+	return NULL;
+}
+
+/**
+ * DsdSampleReader* create_memory_reader()
+ *
+ * creates a reader for a dsf or dsdiff file which is already in memory, depending on the magic at the start.
+ * Returns NULL for other data. The data must remain valid for the life of the reader.
+ */
+DsdSampleReader* create_memory_reader(const char* data, dsf2flac_uint64 length)
+{
+	if (length >= 4 && !strncmp(data,"DSD ",4))
+		return new DsfFileReader(data,length);
+	else if (length >= 4 && !strncmp(data,"FRM8",4))
+		return new DsdiffFileReader(data,length);
+	return NULL;
+}
+
+/**
+ * bool load_file()
+ *
+ * reads the whole of a file into data, returns false on failure.
+ */
+bool load_file(boost::filesystem::path inpath, std::vector<char>& data)
+{
+	std::ifstream in(inpath.c_str(), std::ios::in | std::ios::binary);
+	if (!in.is_open())
 		return false;
+	in.seekg(0,std::ios::end);
+	data.resize(in.tellg());
+	in.seekg(0,std::ios::beg);
+	return data.empty() || in.read(&data[0],data.size());
+}
+
+/**
+ * bool check_dst_frames()
+ *
+ * when the DST frames are being checked (--verify), reports how many frames of the file were checked
+ * against their CRC and how many were bad. Returns false if any frame didn't match or couldn't be decoded.
+ */
+bool check_dst_frames(DsdSampleReader* dsr, boost::filesystem::path inpath)
+{
+	DsdiffFileReader* dff = dynamic_cast<DsdiffFileReader*>(dsr);
+	if (!DsdiffFileReader::getVerifyDstCrc() || !dff || !dff->isDst())
+		return true;
+	dsf2flac_uint64 crcErrors = dff->getDstCrcErrors();
+	dsf2flac_uint64 decodeErrors = dff->getDstDecodeErrors();
+	fprintf(stderr,"DST check\n\t%s\n\tFrames checked: %llu%s\n\tCRC errors: %llu\n\tDecode errors: %llu\n",
+		inpath.c_str(),
+		(unsigned long long)dff->getDstFramesChecked(),
+		dff->getDstFramesChecked() ? "" : " (there are no DSTC chunks)",
+		(unsigned long long)crcErrors,
+		(unsigned long long)decodeErrors);
+	if (crcErrors + decodeErrors == 0)
+		return true;
+	fprintf(stderr,"\tFirst bad frame: %lld\n",(long long)dff->getFirstBadDstFrame());
+	return false;
+}
+
+/**
+ * BatchJob
+ *
+ * the state of one file while it is converted as part of a batch.
+ */
+struct BatchJob {
+	boost::filesystem::path inpath;
+	DsdSampleReader* dsr;
+	DsdBatchDecimator* batch;
+	FLAC::Encoder::File* encoder;
+	FLAC__StreamMetadata* metadata[2];
+	FLAC__int32* buffer;
+	unsigned int bufferFill;
+	dsf2flac_float64 startPos;
+	dsf2flac_float64 endPos;
+	bool ok;
+};
+
+/**
+ * BatchJob* batch_job_open()
+ *
+ * opens a file for batch conversion, finding (or creating) a batch with a matching DSD sample rate.
+ * Returns NULL if the file can't be converted.
+ */
+BatchJob* batch_job_open(
+	boost::filesystem::path inpath,
+	boost::filesystem::path outdir,
+	std::vector<DsdBatchDecimator*> &batches,
+	PcmOutputSpec spec)
+{
+	DsdSampleReader* dsr = create_reader(inpath);
+	if (!dsr->isValid()) {
+		fprintf(stderr,"Error opening %s\n",inpath.c_str());
+		fprintf(stderr,"%s\n",dsr->getErrorMsg().c_str());
+		delete dsr;
+		return NULL;
 	}
 
+	DsdBatchDecimator* batch = NULL;
+	for (dsf2flac_uint32 i = 0; i < batches.size() && !batch; i++)
+		if (batches[i]->addReader(dsr))
+			batch = batches[i];
+	if (!batch) {
+		batch = new DsdBatchDecimator(dsr,spec.fs);
+		if (!batch->addReader(dsr)) {
+			fprintf(stderr,"Error converting %s\n",inpath.c_str());
+			fprintf(stderr,"%s\n",batch->getErrorMsg().c_str());
+			delete batch;
+			delete dsr;
+			return NULL;
+		}
+		batches.push_back(batch);
+	}
+
+	BatchJob* job = new BatchJob;
+	job->inpath = inpath;
+	job->dsr = dsr;
+	job->batch = batch;
+	job->bufferFill = 0;
+	job->buffer = new FLAC__int32[dsr->getNumChannels()*flacBlockLen];
+
+	// convert whole file
+	job->startPos = batch->getFirstValidSample();
+	job->endPos = batch->getLastValidSample(dsr);
+	if ( job->startPos > batch->getLength(dsr)-1 )
+		job->startPos = batch->getLength(dsr)-1;
+	if ( job->endPos > batch->getLength(dsr) )
+		job->endPos = batch->getLength(dsr);
+
+	boost::filesystem::path outpath = outdir / inpath.filename();
+	outpath.replace_extension(".flac");
+	printf("Output file\n\t%s\n",outpath.c_str());
+	job->ok = pcm_encoder_init(job->encoder,job->metadata,outpath,dsr->getNumChannels(),spec.bits,spec.fs,job->endPos - job->startPos,dsr->getID3Tag(0));
+	return job;
+}
+
+/**
+ * bool batch_job_close()
+ *
+ * flushes and closes the flac file of a batch job, then frees the job.
+ */
+bool batch_job_close(BatchJob* job)
+{
+	if (job->ok && job->bufferFill > 0)
+		job->ok = job->encoder->process_interleaved(job->buffer, job->bufferFill);
+	bool ok = pcm_encoder_finish(job->encoder,job->metadata,job->ok,job->batch->getPosition(job->dsr)/job->batch->getLength(job->dsr)*100);
+	ok &= check_dst_frames(job->dsr,job->inpath);
+	delete[] job->buffer;
+	delete job->dsr;
+	delete job;
+	return ok;
+}
+
+/*
+ * do_batch_conversion
+ *
+ * converts a list of files (whole files, not split into tracks), with up to nLanes files in flight.
+ * Files with the same DSD sample rate are filtered together by a DsdBatchDecimator.
+ */
+bool do_batch_conversion(
+		std::vector<boost::filesystem::path> inpaths,
+		boost::filesystem::path outdir,
+		PcmOutputSpec spec,
+		dsf2flac_float64 userScale,
+		dsf2flac_uint32 nLanes)
+{
+	bool ok = true;
+
 	// calc real scale and dither amplitude
-	dsf2flac_float64 scale = userScale * pow(2.0,bits-1); // increase scale by factor of 2^23 (24bit).
+	dsf2flac_float64 scale = userScale * pow(2.0,spec.bits-1); // increase scale by factor of 2^23 (24bit).
 	dsf2flac_float64 tpdfDitherPeakAmplitude;
-	if (dither)
+	if (spec.dither)
 		tpdfDitherPeakAmplitude = 1.0;
 	else
 		tpdfDitherPeakAmplitude = 0.0;
-	dsf2flac_float64 clipAmplitude = pow(2.0,bits-1)-1; // clip at max range.
+	dsf2flac_float64 clipAmplitude = pow(2.0,spec.bits-1)-1; // clip at max range.
 
-	setupTimer(dsr->getPositionInSeconds());
+	std::vector<DsdBatchDecimator*> batches;
+	std::vector<BatchJob*> jobs;
+	std::vector<DsdSampleReader*> due;
+	std::vector<BatchJob*> dueJobs;
+	std::vector<FLAC__int32> samples;
+	dsf2flac_uint32 next = 0;
+	dsf2flac_uint32 nDone = 0;
+	dsf2flac_float64 secondsDone = 0;
 
-	if(onefile) {
-		// convert whole file
-		dsf2flac_float64 trackStart = dec.getFirstValidSample();
-		dsf2flac_float64 trackEnd = dec.getLastValidSample();
+	setupTimer(0);
 
-		printf("Output file\n\t%s\n",outpath.c_str());
-		// use the pcm_track_helper
-		ok &= pcm_track_helper(outpath,&dec,bits,scale,tpdfDitherPeakAmplitude,clipAmplitude,trackStart,trackEnd,NULL);
-	} else {
-		// convert each track in the file in turn
-		for (dsf2flac_uint32 n = 0; n < dsr->getNumTracks();n++) {
-
-			// get and check the start and end samples
-			dsf2flac_float64 trackStart = (dsf2flac_float64)dsr->getTrackStart(n) / dec.getDecimationRatio();
-			dsf2flac_float64 trackEnd = (dsf2flac_float64)dsr->getTrackEnd(n) / dec.getDecimationRatio();
-			if (trackStart < dec.getFirstValidSample())
-				trackStart = dec.getFirstValidSample();
-			if (trackStart >= dec.getLastValidSample() )
-				trackStart = dec.getLastValidSample() - 1;
-			if (trackEnd <= dec.getFirstValidSample())
-				trackEnd = dec.getFirstValidSample() + 1;
-			if (trackEnd > dec.getLastValidSample())
-				trackEnd = dec.getLastValidSample();
-
-			// construct an appropriate filename for multi track files.
-			boost::filesystem::path trackOutPath;
-			if (dsr->getNumTracks() > 1) {
-				trackOutPath = muti_track_name_helper(outpath,n);
-			} else {
-				trackOutPath = outpath;
+	while (next < inpaths.size() || !jobs.empty()) {
+		// keep the lanes full
+		while (jobs.size() < nLanes && next < inpaths.size()) {
+			BatchJob* job = batch_job_open(inpaths[next++],outdir,batches,spec);
+			if (job)
+				jobs.push_back(job);
+			else {
+				ok = false;
+				nDone++;
 			}
+		}
 
-			printf("Output file\n\t%s\n",trackOutPath.c_str());
-			// use the pcm_track_helper
-			ok &= pcm_track_helper(trackOutPath,&dec,bits,scale,tpdfDitherPeakAmplitude,clipAmplitude,trackStart,trackEnd,dsr->getID3Tag(n));
+		// creep up to the start point, finish jobs which have passed their end.
+		for (dsf2flac_uint32 j = 0; j < jobs.size(); ) {
+			BatchJob* job = jobs[j];
+			dsf2flac_float64 pos = job->batch->getPosition(job->dsr);
+			if (pos < job->startPos) {
+				job->dsr->step();
+				j++;
+			} else if (pos > job->endPos || !job->ok) {
+				ok &= batch_job_close(job);
+				jobs.erase(jobs.begin()+j);
+				nDone++;
+			} else
+				j++;
+		}
 
+		// filter the jobs of each batch which are due a sample together.
+		for (dsf2flac_uint32 b = 0; b < batches.size(); b++) {
+			DsdBatchDecimator* batch = batches[b];
+			due.clear();
+			dueJobs.clear();
+			dsf2flac_uint32 nSamples = 0;
+			for (dsf2flac_uint32 j = 0; j < jobs.size(); j++) {
+				BatchJob* job = jobs[j];
+				dsf2flac_float64 pos = batch->getPosition(job->dsr);
+				if (job->batch == batch && pos >= job->startPos && pos <= job->endPos) {
+					due.push_back(job->dsr);
+					dueJobs.push_back(job);
+					nSamples += job->dsr->getNumChannels();
+				}
+			}
+			if (due.empty())
+				continue;
+			samples.resize(nSamples);
+			batch->getSamples(&due[0],due.size(),&samples[0],scale,tpdfDitherPeakAmplitude,clipAmplitude);
+			// hand the samples back to each job and step its reader on.
+			dsf2flac_uint32 k = 0;
+			for (dsf2flac_uint32 j = 0; j < dueJobs.size(); j++) {
+				BatchJob* job = dueJobs[j];
+				dsf2flac_uint32 nChans = job->dsr->getNumChannels();
+				for (dsf2flac_uint32 c = 0; c < nChans; c++)
+					job->buffer[job->bufferFill*nChans+c] = samples[k++];
+				if (++job->bufferFill == flacBlockLen) {
+					if(!(job->ok = job->encoder->process_interleaved(job->buffer, flacBlockLen)))
+						fprintf(stderr, "   state: %s\n", job->encoder->get_state().resolved_as_cstring(*job->encoder));
+					job->bufferFill = 0;
+					secondsDone += (dsf2flac_float64)flacBlockLen/spec.fs;
+					checkTimer(secondsDone,(dsf2flac_float64)nDone/inpaths.size()*100);
+				}
+				for (dsf2flac_uint32 m = 0; m < batch->getDecimationRatio()/8; m++)
+					job->dsr->step();
+			}
 		}
 	}
 
+	for (dsf2flac_uint32 b = 0; b < batches.size(); b++)
+		delete batches[b];
+
 	return ok;
 }
 
@@ -450,6 +1033,356 @@ bool do_dop_conversion(
 	return ok;
 }
 
+/**
+ * dsf2flac_uint8 reverse_bits(dsf2flac_uint8 b)
+ *
+ * returns b with the order of its bits reversed.
+ */
+dsf2flac_uint8 reverse_bits(dsf2flac_uint8 b)
+{
+	b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+	b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+	b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+	return b;
+}
+
+/**
+ * bool dsd_copy_range()
+ *
+ * finds the part of the bytes (per channel) startByte to endByte which is laid out in the input file just
+ * as the writer writes it, so that it can be copied straight across: all of it from a plain dff into a plain
+ * dff, or the whole blocks from an lsb first dsf into a dsf when the start is on a block boundary.
+ * Returns false if there isn't any.
+ */
+bool dsd_copy_range(
+	DsdSampleReader* dsr,
+	DsdSampleWriter* writer,
+	dsf2flac_int64 startByte,
+	dsf2flac_int64 endByte,
+	dsf2flac_uint64 &offset,
+	dsf2flac_uint64 &len)
+{
+	dsf2flac_uint64 nch = dsr->getNumChannels();
+	DsdiffFileReader* dffIn = dynamic_cast<DsdiffFileReader*>(dsr);
+	DsdiffFileWriter* dffOut = dynamic_cast<DsdiffFileWriter*>(writer);
+	if (dffIn && dffOut && !dffIn->isDst() && !dffOut->isDst()) {
+		offset = dffIn->getSampleDataPointer() + startByte*nch;
+		len = (endByte - startByte)*nch;
+		return len > 0;
+	}
+	DsfFileReader* dsfIn = dynamic_cast<DsfFileReader*>(dsr);
+	const dsf2flac_uint32 blockSz = DsfFileWriter::blockSzPerChan;
+	if (dsfIn && dynamic_cast<DsfFileWriter*>(writer) && dsfIn->getBitsPerSample() == 1
+			&& dsfIn->getBlockSzPerChan() == blockSz && startByte % blockSz == 0) {
+		offset = dsfIn->getSampleDataPointer() + startByte*nch;
+		len = (endByte - startByte) / blockSz * blockSz * nch;
+		return len > 0;
+	}
+	return false;
+}
+
+/**
+ * bool dsd_track_helper()
+ *
+ * copies the DSD samples from startPos to endPos into the writer as they are and closes it.
+ * Whatever dsd_copy_range() finds is copied straight from the input file fd (if it isn't -1),
+ * the rest is stepped through and re-laid out (only the bit order is changed where the writer needs the other one).
+ */
+bool dsd_track_helper(
+	DsdSampleReader* dsr,
+	DsdSampleWriter* writer,
+	dsf2flac_int64 startPos,
+	dsf2flac_int64 endPos,
+	int fd)
+{
+	// the whole bytes holding the samples, double checking the start and end positions!
+	dsf2flac_int64 startByte = startPos / 8;
+	dsf2flac_int64 endByte = (endPos + 7) / 8;
+	if ( endByte > (dsr->getLength() + 7) / 8 )
+		endByte = (dsr->getLength() + 7) / 8;
+	if ( startByte > endByte )
+		startByte = endByte;
+
+	dsf2flac_uint32 nch = dsr->getNumChannels();
+	bool ok = true;
+	dsf2flac_uint64 offset, len;
+	if (fd >= 0 && dsd_copy_range(dsr,writer,startByte,endByte,offset,len)) {
+		ok = writer->copy(fd,offset,len);
+		startByte += len / nch;
+	}
+
+	// go to the byte before the rest, so that the next step() reads the first one
+	if (ok)
+		dsr->seek(startByte*8 - 8);
+	bool reverse = dsr->msbIsPlayedFirst() != writer->msbIsPlayedFirst();
+	DsdHistoryBuffer* buff = dsr->getBuffer();
+	std::vector<dsf2flac_uint8> block(nch*dsdBlockLen);
+	dsf2flac_int64 bytesLeft = endByte - startByte; // steps (bytes per channel) to the end
+	while (ok && bytesLeft > 0) {
+		dsf2flac_uint32 n = 0;
+		for (; n < block.size() && bytesLeft > 0; bytesLeft--) {
+			dsr->step();
+			for (dsf2flac_uint32 c=0; c<nch; c++)
+				block[n++] = reverse ? reverse_bits(buff[c][0]) : buff[c][0];
+		}
+		ok = writer->write(block.data(),n);
+		checkTimer(dsr->getPositionInSeconds(),dsr->getPositionAsPercent());
+	}
+	ok = writer->close() && ok;
+	return ok;
+}
+
+/**
+ * DsdSampleWriter* create_writer()
+ *
+ * returns a writer for the format ("dsf", "dff" or "dst", a DST coded dff) matching the reader.
+ */
+DsdSampleWriter* create_writer(boost::filesystem::path outpath, std::string format, DsdSampleReader* dsr, dsf2flac_uint32 nThreads)
+{
+	if (format == "dsf")
+		return new DsfFileWriter(outpath.c_str(),dsr->getSamplingFreq(),dsr->getNumChannels());
+	return new DsdiffFileWriter(outpath.c_str(),dsr->getSamplingFreq(),dsr->getNumChannels(),format == "dst",nThreads);
+}
+
+/**
+ * bool do_dsd_output()
+ *
+ * writes the DSD data of each track (or of the whole file, or only of onlyTrack) into a dsf or dff file
+ * with the tag of the track, without converting it. A DST coded dff is encoded nThreads frames at a time.
+ */
+bool do_dsd_output(
+	DsdSampleReader* dsr,
+	boost::filesystem::path inpath,
+	boost::filesystem::path outpath,
+	std::string format,
+	bool onefile,
+	dsf2flac_int32 onlyTrack,
+	dsf2flac_uint32 nThreads)
+{
+	bool ok = true;
+	// the input file is opened again to copy sound data straight from it
+	int fd = inpath != "-" ? open(inpath.c_str(),O_RDONLY) : -1;
+
+	setupTimer(dsr->getPositionInSeconds());
+
+	dsf2flac_uint32 firstTrack = onlyTrack >= 0 ? onlyTrack : 0;
+	dsf2flac_uint32 numTracks = onefile ? 1 : onlyTrack >= 0 ? onlyTrack+1 : dsr->getNumTracks();
+	for (dsf2flac_uint32 n = firstTrack; n < numTracks; n++) {
+
+		// get the start and end samples
+		dsf2flac_int64 trackStart = onefile ? 0 : dsr->getTrackStart(n);
+		dsf2flac_int64 trackEnd = onefile ? dsr->getLength() : dsr->getTrackEnd(n);
+
+		// construct an appropriate filename for multi track files.
+		boost::filesystem::path trackOutPath = outpath;
+		if (!onefile && dsr->getNumTracks() > 1)
+			trackOutPath = muti_track_name_helper(outpath,n);
+
+		DsdSampleWriter* writer = create_writer(trackOutPath,format,dsr,nThreads);
+		if (!writer->isValid()) {
+			fprintf(stderr,"Error creating %s\n%s\n",trackOutPath.c_str(),writer->getErrorMsg().c_str());
+			delete writer;
+			ok = false;
+			break;
+		}
+		fprintf(stderr,"Output file\n\t%s\n",trackOutPath.c_str());
+		writer->setID3Tag(dsr->getID3Tag(n));
+		// the markers only fit an output holding all of the input
+		DsdiffFileReader* dffIn = dynamic_cast<DsdiffFileReader*>(dsr);
+		DsdiffFileWriter* dffOut = dynamic_cast<DsdiffFileWriter*>(writer);
+		if (dffIn && dffOut && (onefile || dsr->getNumTracks() == 1))
+			dffOut->setDiinChunk(dffIn->getDiinChunk());
+
+		bool trackOk = dsd_track_helper(dsr,writer,trackStart,trackEnd,fd);
+
+		// report back to the user
+		fprintf(stderr,"\33[2K\r");
+		fprintf(stderr,"%3.1f%%\t",dsr->getPositionAsPercent());
+		if (trackOk)
+			fprintf(stderr,"Conversion completed sucessfully.\n");
+		else
+			fprintf(stderr,"\nError during conversion.\n%s\n",writer->getErrorMsg().c_str());
+		if (writer->getCopiedBytes() > 0)
+			fprintf(stderr,"\tCopied without re-layout: %1.1fMiB\n",writer->getCopiedBytes()/1048576.0);
+		if (dffOut && dffOut->isDst())
+			fprintf(stderr,"DST coding\n\tFrames: %llu\n\tDST coded: %llu\n\tPlain: %llu\n\tSize: %1.1f%% of the DSD data\n\tVerify errors: %llu\n",
+				(unsigned long long)dffOut->getFrames(),
+				(unsigned long long)dffOut->getCodedFrames(),
+				(unsigned long long)dffOut->getPlainFrames(),
+				dffOut->getDsdBytes() ? 100.0*dffOut->getDstBytes()/dffOut->getDsdBytes() : 0.0,
+				(unsigned long long)dffOut->getVerifyErrors());
+		delete writer;
+		ok &= trackOk;
+	}
+
+	if (fd >= 0)
+		close(fd);
+	return ok;
+}
+
+/**
+ * std::vector<boost::filesystem::path> list_dsd_files()
+ *
+ * returns the dsf and dff files in a directory, sorted by name.
+ */
+std::vector<boost::filesystem::path> list_dsd_files(boost::filesystem::path dir)
+{
+	std::vector<boost::filesystem::path> paths;
+	boost::filesystem::directory_iterator end;
+	for (boost::filesystem::directory_iterator it(dir); it != end; ++it) {
+		boost::filesystem::path p = it->path();
+		if (boost::filesystem::is_regular_file(p) && (p.extension() == ".dsf" || p.extension() == ".DSF" || p.extension() == ".dff" || p.extension() == ".DFF"))
+			paths.push_back(p);
+	}
+	std::sort(paths.begin(),paths.end());
+	return paths;
+}
+
+/**
+ * std::string json_string()
+ *
+ * returns s as a quoted and escaped JSON string, or null.
+ */
+std::string json_string(const char* s)
+{
+	if (s == NULL)
+		return "null";
+	std::string json = "\"";
+	for (; *s; s++) {
+		unsigned char c = *s;
+		if (c == '"' || c == '\\') {
+			json += '\\';
+			json += c;
+		} else if (c < 0x20) {
+			char esc[8];
+			snprintf(esc,sizeof(esc),"\\u%04x",c);
+			json += esc;
+		} else
+			json += c;
+	}
+	return json + "\"";
+}
+
+/**
+ * std::string probe_tag_json()
+ *
+ * returns the fields of an ID3 tag which are copied into the flac files (see id3v2_to_flac) as a JSON object.
+ */
+std::string probe_tag_json(ID3_Tag tag)
+{
+	static const char* names[] = {"artist","album","title","track","year"};
+	static char* (*getters[])(const ID3_Tag*) = {ID3_GetArtist,ID3_GetAlbum,ID3_GetTitle,ID3_GetTrack,ID3_GetYear};
+	std::string json = "{";
+	for (int i = 0; i < 5; i++) {
+		char* latin1 = getters[i](&tag);
+		if (latin1 == NULL)
+			continue;
+		char* utf8 = latin1_to_utf8(latin1);
+		if (json.size() > 1)
+			json += ",";
+		json += json_string(names[i]) + ":" + json_string(utf8);
+		delete[] utf8;
+		delete[] latin1;
+	}
+	return json + "}";
+}
+
+/**
+ * std::string probe_file()
+ *
+ * describes a file as a JSON object: the format, length, tracks and tags. Only the headers are read.
+ */
+std::string probe_file(boost::filesystem::path inpath, bool& ok)
+{
+	std::ostringstream json;
+	json << "{\"file\":" << json_string(inpath.c_str());
+	DsdSampleReader* dsr = create_reader(inpath,true);
+	ok = dsr && dsr->isValid();
+	if (!dsr)
+		json << ",\"valid\":false,\"error\":\"not a dsf or dff file\"}";
+	else if (!dsr->isValid())
+		json << ",\"valid\":false,\"error\":" << json_string(dsr->getErrorMsg().c_str()) << "}";
+	else {
+		DsdiffFileReader* dff = dynamic_cast<DsdiffFileReader*>(dsr);
+		json << ",\"valid\":true";
+		json << ",\"format\":\"" << (dff ? "DSDIFF" : "DSF") << "\"";
+		json << ",\"compression\":\"" << (dff && dff->isDst() ? "DST" : "DSD") << "\"";
+		json << ",\"channels\":" << dsr->getNumChannels();
+		json << ",\"samplingFreq\":" << dsr->getSamplingFreq();
+		json << ",\"samples\":" << dsr->getLength();
+		json << std::fixed << std::setprecision(6);
+		json << ",\"seconds\":" << dsr->getLengthInSeconds();
+		json << ",\"tracks\":[";
+		for (dsf2flac_uint32 n = 0; n < dsr->getNumTracks(); n++) {
+			if (n > 0)
+				json << ",";
+			json << "{\"start\":" << dsr->getTrackStart(n);
+			json << ",\"end\":" << dsr->getTrackEnd(n);
+			json << ",\"seconds\":" << (dsr->getTrackEnd(n) - dsr->getTrackStart(n)) / (dsf2flac_float64) dsr->getSamplingFreq();
+			json << ",\"tags\":" << probe_tag_json(dsr->getID3Tag(n)) << "}";
+		}
+		json << "]}";
+	}
+	delete dsr;
+	return json.str();
+}
+
+/**
+ * bool do_probe()
+ *
+ * describes each of the files as JSON on stdout, nThreads files are read at once.
+ * A single file is written as an object, several as an array (in the same order as inpaths).
+ */
+bool do_probe(std::vector<boost::filesystem::path> inpaths, bool asArray, dsf2flac_uint32 nThreads)
+{
+	std::vector<std::string> results(inpaths.size());
+	std::vector<char> fileOk(inpaths.size());
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> pool;
+	for (dsf2flac_uint32 t = 0; t < nThreads && t < inpaths.size(); t++)
+		pool.push_back(std::thread([&]() {
+			bool ok;
+			for (size_t i = next++; i < inpaths.size(); i = next++) {
+				results[i] = probe_file(inpaths[i],ok);
+				fileOk[i] = ok;
+			}
+		}));
+	for (dsf2flac_uint32 t = 0; t < pool.size(); t++)
+		pool[t].join();
+
+	bool ok = true;
+	if (asArray)
+		printf("[\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		printf("%s%s\n",results[i].c_str(),(asArray && i+1 < results.size()) ? "," : "");
+		ok &= fileOk[i] != 0;
+	}
+	if (asArray)
+		printf("]\n");
+	return ok;
+}
+
+/**
+ * void print_io_stats()
+ *
+ * reports how often the conversion had to wait for the read ahead thread,
+ * and how often the DST decoder could reuse the filter tables from the frame before.
+ */
+void print_io_stats()
+{
+	fprintf(stderr,"Read ahead\n\tBlocks: %llu\n\tWaits: %llu\n\tTime waiting: %1.3fs\n",
+		(unsigned long long)ReadAheadBuffer::getBlockCount(),
+		(unsigned long long)ReadAheadBuffer::getWaitCount(),
+		ReadAheadBuffer::getWaitSeconds());
+	dsf2flac_uint64 made = DsdiffFileReader::getDstTablesMade();
+	dsf2flac_uint64 reused = DsdiffFileReader::getDstTablesReused();
+	if (made + reused > 0)
+		fprintf(stderr,"DST filter tables\n\tMade: %llu\n\tReused: %llu (%1.1f%%)\n",
+			(unsigned long long)made,
+			(unsigned long long)reused,
+			100.0*reused/(made + reused));
+}
+
 /**
  * int main(int argc, char **argv)
  *
@@ -472,13 +1405,85 @@ int main(int argc, char **argv)
 	bool dither = !args_info.nodither_flag;
 	bool onefile = args_info.onefile_flag;
 	bool dop = args_info.dop_flag;
+	// the format the DSD data is written out in as it is ("dsf", "dff" or "dst"), empty when it is converted
+	std::string dsdFormat;
+	if (args_info.dst_flag)
+		dsdFormat = "dst";
+	else if (args_info.dsd_given)
+		dsdFormat = args_info.dsd_arg;
+	if (args_info.dst_flag && args_info.dsd_given && strcmp(args_info.dsd_arg,"dff")) {
+		fprintf(stderr,"Sorry, DST coded output can only be a DFF file\n");
+		return 1;
+	}
+	if (args_info.approximate_flag && args_info.cic_flag) {
+		fprintf(stderr,"Sorry, -a and -c choose different filters, give only one of them\n");
+		return 1;
+	}
+	DecimatorEngine engine = tableEngine;
+	if (args_info.approximate_flag)
+		engine = popcountEngine;
+	else if (args_info.cic_flag)
+		engine = cicEngine;
+	std::vector<PcmOutputSpec> specs;
+	if (args_info.outputs_given) {
+		if (!parse_output_specs(args_info.outputs_arg,bits,dither,specs)) {
+			fprintf(stderr,"Sorry, could not understand the output specs: %s\n",args_info.outputs_arg);
+			return 1;
+		}
+	} else {
+		PcmOutputSpec spec;
+		spec.fs = fs;
+		spec.bits = bits;
+		spec.dither = dither;
+		specs.push_back(spec);
+	}
+	// the lookup table filters only decimate by 8, 16 or 32, which the low rates are too far below any DSD rate for.
+	if (engine == tableEngine && !dop && dsdFormat.empty() && !args_info.probe_flag) {
+		for (dsf2flac_uint32 i = 0; i < specs.size(); i++) {
+			if (specs[i].fs < 88200) {
+				fprintf(stderr,"Sorry, the %d Hz sample rate needs -a (approximate) or -c (CIC)\n",specs[i].fs);
+				return 1;
+			}
+		}
+	}
+	// describe the input file(s) without converting anything. Only a few KiB of each file are read so there is no read ahead.
+	if (args_info.probe_flag) {
+		boost::filesystem::path inpath(args_info.infile_arg);
+		dsf2flac_uint32 nThreads = args_info.lanes_given ? args_info.lanes_arg : std::thread::hardware_concurrency();
+		if (nThreads < 1)
+			nThreads = 1;
+		if (inpath != "-" && boost::filesystem::is_directory(inpath))
+			return do_probe(list_dsd_files(inpath),true,nThreads) ? 0 : 1;
+		return do_probe(std::vector<boost::filesystem::path>(1,inpath),false,1) ? 0 : 1;
+	}
+	// map the input files into memory, or read them ahead in a background thread in blocks of 256KiB
+	if (args_info.mmap_flag)
+		BinaryReader::setUseMmap(true);
+	else if (args_info.readahead_arg > 0)
+		fstreamPlus::setReadAhead(ReadAheadBuffer::defaultBlockSize,args_info.readahead_arg*(1024*1024/ReadAheadBuffer::defaultBlockSize));
+	// DST files without a DSTI chunk keep the frame index they make for seeking
+	if (args_info.index_cache_flag)
+		DsdiffFileReader::setUseIndexCache(true);
+	// check the DST frames against the CRCs in the DSTC chunks
+	if (args_info.verify_flag)
+		DsdiffFileReader::setVerifyDstCrc(true);
 	dsf2flac_float64 userScaleDB = (dsf2flac_float64) args_info.scale_arg;
 	dsf2flac_float64 userScale = pow(10.0,userScaleDB/20);
 	boost::filesystem::path inpath(args_info.infile_arg);
 	boost::filesystem::path outpath;
 	if (args_info.outfile_given)
 		outpath = args_info.outfile_arg;
-	else {
+	else if (inpath == "-") {
+		fprintf(stderr,"Sorry, an output file (-o) is required when reading from stdin\n");
+		return 1;
+	} else if (!dsdFormat.empty()) {
+		// an input of the same type gets a new name rather than being overwritten
+		std::string ext = dsdFormat == "dsf" ? ".dsf" : ".dff";
+		outpath = inpath;
+		outpath.replace_extension(ext);
+		if (outpath == inpath)
+			outpath.replace_extension((dsdFormat == "dst" ? ".dst" : ".dsd") + ext);
+	} else {
 		outpath = inpath;
 		outpath.replace_extension(".flac");
 	}
@@ -486,15 +1491,38 @@ int main(int argc, char **argv)
 	fprintf(stderr,"%s ",CMDLINE_PARSER_PACKAGE_NAME);
 	fprintf(stderr,"%s\n\n",CMDLINE_PARSER_VERSION);
 
+	// a directory is converted as a batch of whole files.
+	if (boost::filesystem::is_directory(inpath)) {
+		if (dop || !dsdFormat.empty() || args_info.outputs_given || engine != tableEngine) {
+			fprintf(stderr,"Sorry, DoP, DSD output, multiple outputs and the alternative filters are not supported when converting a directory\n");
+			return 1;
+		}
+		std::vector<boost::filesystem::path> inpaths = list_dsd_files(inpath);
+		boost::filesystem::path outdir = args_info.outfile_given ? outpath : inpath;
+		if (!boost::filesystem::exists(outdir))
+			boost::filesystem::create_directories(outdir);
+		dsf2flac_uint32 nLanes = args_info.lanes_arg > 0 ? args_info.lanes_arg : 1;
+		fprintf(stderr,"Input directory\n\t%s (%d files)\n",inpath.c_str(),(int)inpaths.size());
+		fprintf(stderr,"Output format\n\tSampleRate: %dHz\n\tDepth: %dbit\n\tDither: %s\n\tScale: %1.1fdB\n",specs[0].fs, specs[0].bits, (specs[0].dither)?"true":"false",userScaleDB);
+		bool ok = do_batch_conversion(inpaths,outdir,specs[0],userScale,nLanes);
+		if (args_info.io_stats_flag)
+			print_io_stats();
+		return ok? 0 : 1;
+	}
+
 	// pointer to the dsdSampleReader (could be any valid type).
 	DsdSampleReader* dsr;
-
-	// create either a reader for dsf or dsd
-	if (inpath.extension() == ".dsf" || inpath.extension() == ".DSF")
-		dsr = new DsfFileReader((char*)inpath.c_str());
-	else if (inpath.extension() == ".dff" || inpath.extension() == ".DFF")
-		dsr = new DsdiffFileReader((char*)inpath.c_str());
-	else {
+	// when asked, the whole file is read up front so the conversion itself does no file I/O.
+	std::vector<char> inputData;
+	if (args_info.memory_flag && inpath != "-") {
+		if (!load_file(inpath,inputData)) {
+			fprintf(stderr,"Error reading %s\n",inpath.c_str());
+			return 1;
+		}
+		dsr = create_memory_reader(inputData.data(),inputData.size());
+	} else
+		dsr = create_reader(inpath);
+	if (!dsr) {
 		fprintf(stderr,"Sorry, only .dsf or .dff input files are supported\n");
 		return 0;
 	}
@@ -505,16 +1533,56 @@ int main(int argc, char **argv)
 		fprintf(stderr,"%s\n",dsr->getErrorMsg().c_str());
 		return 0;
 	}
+
+	// a single track is converted by seeking straight to it.
+	dsf2flac_int32 onlyTrack = -1;
+	if (args_info.track_given) {
+		if (onefile || dop || args_info.track_arg < 1 || (dsf2flac_uint32)args_info.track_arg > dsr->getNumTracks()) {
+			fprintf(stderr,"Sorry, track %d can't be converted (the file has %d tracks, and -t doesn't work with -1 or DoP)\n",args_info.track_arg,(int)dsr->getNumTracks());
+			return 1;
+		}
+		onlyTrack = args_info.track_arg - 1;
+	}
 	
-	// do the conversion into PCM or DoP
+	// do the conversion into PCM or DoP, or write the DSD data out as it is
 	bool ok = false;
-	if (!dop) {
+	if (!dsdFormat.empty()) {
+		// feedback some info to the user
+		dsf2flac_uint32 nThreads = args_info.lanes_given ? args_info.lanes_arg : std::thread::hardware_concurrency();
+		if (nThreads < 1)
+			nThreads = 1;
+		fprintf(stderr,"Input file\n\t%s\n",inpath.c_str());
+		if (dsdFormat == "dst")
+			fprintf(stderr,"Output format\n\tDST coded DFF (%d threads)\n",(int)nThreads);
+		else
+			fprintf(stderr,"Output format\n\tDSD samples as they are (%s)\n",dsdFormat == "dsf" ? "DSF" : "DFF");
+
+		// DST frames can't stop part way through, so a file per track would each end in padding and
+		// wouldn't play back gaplessly. DST output holds all of the tracks (with their markers) unless -t picks one.
+		if (dsdFormat == "dst" && onlyTrack < 0)
+			onefile = true;
+		else if (dsdFormat == "dst")
+			fprintf(stderr,"WARNING: the track is padded with silence up to a whole DST frame\n");
+
+		ok = do_dsd_output(dsr,inpath,outpath,dsdFormat,onefile,onlyTrack,nThreads);
+	} else if (!dop) {
 		// feedback some info to the user
 		fprintf(stderr,"Input file\n\t%s\n",inpath.c_str());
-		fprintf(stderr,"Output format\n\tSampleRate: %dHz\n\tDepth: %dbit\n\tDither: %s\n\tScale: %1.1fdB\n",fs, bits, (dither)?"true":"false",userScaleDB);
+		for (dsf2flac_uint32 i = 0; i < specs.size(); i++)
+			fprintf(stderr,"Output format\n\tSampleRate: %dHz\n\tDepth: %dbit\n\tDither: %s\n\tScale: %1.1fdB\n",specs[i].fs, specs[i].bits, (specs[i].dither)?"true":"false",userScaleDB);
+		if (engine == popcountEngine)
+			fprintf(stderr,"\tFilter: approximate (bit counting)\n");
+		else if (engine == cicEngine)
+			fprintf(stderr,"\tFilter: CIC + compensating FIR\n");
 		//printf("\tIdleSample: 0x%02x\n",dsr->getIdleSample());
     
-		ok = do_pcm_conversion(dsr,fs,bits,dither,userScale,inpath,outpath,onefile);
+		// pick the conversion for the concrete reader type, the DsdSampleReader one is the generic fallback.
+		if (DsfFileReader* dsf = dynamic_cast<DsfFileReader*>(dsr))
+			ok = do_pcm_conversion(dsf,specs,userScale,inpath,outpath,onefile,engine,onlyTrack);
+		else if (DsdiffFileReader* dff = dynamic_cast<DsdiffFileReader*>(dsr))
+			ok = do_pcm_conversion(dff,specs,userScale,inpath,outpath,onefile,engine,onlyTrack);
+		else
+			ok = do_pcm_conversion(dsr,specs,userScale,inpath,outpath,onefile,engine,onlyTrack);
 	} else {
 		// feedback some info to the user
 		fprintf(stderr,"Input file\n\t%s\n",inpath.c_str());
@@ -523,5 +1591,10 @@ int main(int argc, char **argv)
 		// ok = do_dop_conversion(dsr,inpath,outpath);
 		ok = do_dop_conversion(dsr,inpath,outpath,onefile);
 	}
+	ok &= check_dst_frames(dsr,inpath);
+	// closing the reader adds its DST decoder counts to the totals
+	delete dsr;
+	if (args_info.io_stats_flag)
+		print_io_stats();
 	return ok? 0 : 1;
 }
@@ -0,0 +1,108 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "pipe_buffer.h"
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+PipeBuffer::PipeBuffer(int f)
+{
+	fd = f;
+	buffer = new char[putbackLength + blockLength];
+	endPos = 0;
+	setg(buffer,buffer,buffer);
+}
+
+PipeBuffer::~PipeBuffer()
+{
+	delete[] buffer;
+}
+
+PipeBuffer* PipeBuffer::getStdin()
+{
+	static PipeBuffer stdinBuffer(STDIN_FILENO);
+	return &stdinBuffer;
+}
+
+PipeBuffer::int_type PipeBuffer::underflow()
+{
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+	// keep the tail of what we have for short backward seeks
+	dsf2flac_uint32 keep = egptr() - eback();
+	if (keep > putbackLength)
+		keep = putbackLength;
+	memmove(buffer,egptr()-keep,keep);
+	// read the next block
+	ssize_t n;
+	do {
+		n = read(fd,buffer+keep,blockLength);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0)
+		n = 0;
+	endPos += n;
+	setg(buffer,buffer+keep,buffer+keep+n);
+	if (n == 0)
+		return traits_type::eof();
+	return traits_type::to_int_type(*gptr());
+}
+
+PipeBuffer::pos_type PipeBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+	dsf2flac_int64 target = pos;
+	if (!(which & std::ios_base::in) || target < bufferStart())
+		return pos_type(off_type(-1));
+	// read and throw away data until the target is in the buffer
+	while (target > endPos) {
+		setg(eback(),egptr(),egptr());
+		if (traits_type::eq_int_type(underflow(),traits_type::eof()))
+			return pos_type(off_type(-1));
+	}
+	setg(eback(),egptr()-(endPos-target),egptr());
+	return pos;
+}
+
+PipeBuffer::pos_type PipeBuffer::seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which)
+{
+	if (way == std::ios_base::cur)
+		return seekpos(pos_type(endPos - (egptr() - gptr()) + off),which);
+	if (way == std::ios_base::beg)
+		return seekpos(pos_type(off),which);
+	// the end of a pipe is unknown
+	return pos_type(off_type(-1));
+}
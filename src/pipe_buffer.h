@@ -0,0 +1,86 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * pipe_buffer.h
+  *
+  * Header file for the class PipeBuffer.
+  *
+  * A streambuf reading from a file descriptor which may not be seekable (stdin, a pipe or a socket).
+  *
+  */
+
+#ifndef PIPEBUFFER_H
+#define PIPEBUFFER_H
+
+#include <streambuf>
+#include "dsf2flac_types.h"
+
+/**
+ * The PipeBuffer reads a file descriptor in large blocks and only ever moves forward through it.
+ *
+ * To let the file readers parse headers without special cases, seeks are supported as far as possible
+ * without going back to the source: seeking forward reads and discards up to the target, and seeking
+ * backward works as long as the target is still in the buffer (the last putbackLength bytes of the
+ * previous block are always kept). Anything else fails.
+ */
+class PipeBuffer : public std::streambuf
+{
+public:
+	/// Constructor, fd must be open for reading. The descriptor is not closed by the PipeBuffer.
+	PipeBuffer(int fd);
+	virtual ~PipeBuffer();
+
+	/// Returns the PipeBuffer reading stdin, shared by everyone who reads "-".
+	static PipeBuffer* getStdin();
+protected:
+	// methods overriding streambuf
+	int_type underflow();
+	pos_type seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which = std::ios_base::in);
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+private:
+	/// Returns the stream position of the start of the buffer.
+	dsf2flac_int64 bufferStart() { return endPos - (egptr() - eback()); };
+private:
+	static const dsf2flac_uint32 blockLength = 64*1024;
+	static const dsf2flac_uint32 putbackLength = 4096;
+	int fd;
+	char* buffer; // putbackLength + blockLength bytes
+	dsf2flac_int64 endPos; // stream position of egptr()
+};
+
+#endif // PIPEBUFFER_H
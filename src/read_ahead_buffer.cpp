@@ -0,0 +1,235 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+#include "read_ahead_buffer.h"
+#include <chrono>
+
+std::atomic<dsf2flac_uint64> ReadAheadBuffer::blockCount(0);
+std::atomic<dsf2flac_uint64> ReadAheadBuffer::waitCount(0);
+std::atomic<dsf2flac_uint64> ReadAheadBuffer::waitNanoseconds(0);
+
+ReadAheadBuffer::ReadAheadBuffer(std::streambuf* src, dsf2flac_uint32 bs, dsf2flac_uint32 nb)
+{
+	source = src;
+	blockSize = bs > 0 ? bs : 1;
+	nBlocks = nb > 1 ? nb : 2; // one for the consumer, at least one for the I/O thread
+	data = new char[(size_t)nBlocks*blockSize];
+	blockLength = new dsf2flac_uint32[nBlocks];
+	blockStart = new dsf2flac_int64[nBlocks];
+	head = 0;
+	count = 0;
+	holding = false;
+	endOfSource = false;
+	stopping = false;
+	sourcePos = source->pubseekoff(0,std::ios_base::cur,std::ios_base::in);
+	if (sourcePos < 0)
+		sourcePos = 0;
+	startPos = sourcePos;
+	setg(0,0,0);
+	start();
+}
+
+ReadAheadBuffer::~ReadAheadBuffer()
+{
+	stop();
+	delete[] data;
+	delete[] blockLength;
+	delete[] blockStart;
+}
+
+void ReadAheadBuffer::start()
+{
+	thread = std::thread(&ReadAheadBuffer::readLoop,this);
+}
+
+void ReadAheadBuffer::stop()
+{
+	startPos = position();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	blockFreed.notify_all();
+	if (thread.joinable())
+		thread.join();
+	head = 0;
+	count = 0;
+	holding = false;
+	endOfSource = false;
+	stopping = false;
+	setg(0,0,0);
+}
+
+void ReadAheadBuffer::readLoop()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		// wait for a free block
+		while (!stopping && count >= nBlocks)
+			blockFreed.wait(lock);
+		if (stopping)
+			break;
+		// the consumer only moves head and count together, so this block stays ours.
+		dsf2flac_uint32 idx = (head + count) % nBlocks;
+		dsf2flac_int64 pos = sourcePos;
+		lock.unlock();
+		std::streamsize n = source->sgetn(&data[(size_t)idx*blockSize],blockSize);
+		lock.lock();
+		if (stopping)
+			break;
+		if (n < 0)
+			n = 0;
+		blockStart[idx] = pos;
+		blockLength[idx] = n;
+		sourcePos += n;
+		if (n > 0)
+			count++;
+		if (n < blockSize)
+			endOfSource = true;
+		blockFilled.notify_one();
+		if (endOfSource)
+			break;
+	}
+}
+
+dsf2flac_int64 ReadAheadBuffer::position()
+{
+	if (holding)
+		return blockStart[head] + (gptr() - eback());
+	return startPos;
+}
+
+ReadAheadBuffer::int_type ReadAheadBuffer::underflow()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	// hand the finished block back to the I/O thread
+	if (holding) {
+		startPos = blockStart[head] + blockLength[head];
+		head = (head + 1) % nBlocks;
+		count--;
+		holding = false;
+		blockFreed.notify_one();
+	}
+	if (count == 0 && !endOfSource) {
+		waitCount++;
+		std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+		while (count == 0 && !endOfSource)
+			blockFilled.wait(lock);
+		waitNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+	}
+	if (count == 0) {
+		setg(0,0,0);
+		return traits_type::eof();
+	}
+	holding = true;
+	blockCount++;
+	char* b = &data[(size_t)head*blockSize];
+	setg(b,b,b+blockLength[head]);
+	return traits_type::to_int_type(*b);
+}
+
+ReadAheadBuffer::pos_type ReadAheadBuffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+	dsf2flac_int64 target = pos;
+	if (!(which & std::ios_base::in) || target < 0)
+		return pos_type(off_type(-1));
+	{
+		// if the target has already been read ahead just skip forward to it.
+		std::unique_lock<std::mutex> lock(mutex);
+		while (count > 0) {
+			dsf2flac_int64 s = blockStart[head];
+			dsf2flac_int64 e = s + blockLength[head];
+			if (target >= s && target < e) {
+				holding = true;
+				char* b = &data[(size_t)head*blockSize];
+				setg(b,b+(target-s),b+blockLength[head]);
+				return pos;
+			}
+			if (target < s)
+				break;
+			// the target is past this block, drop it
+			startPos = e;
+			head = (head + 1) % nBlocks;
+			count--;
+			holding = false;
+			setg(0,0,0);
+			blockFreed.notify_one();
+		}
+		if (count == 0 && target == sourcePos) {
+			// the I/O thread is reading (or has reached the end) exactly here
+			startPos = target;
+			holding = false;
+			setg(0,0,0);
+			return pos;
+		}
+	}
+	// otherwise start again from the new position
+	stop();
+	if (source->pubseekpos(pos,std::ios_base::in) == pos_type(off_type(-1))) {
+		source->pubseekpos(startPos,std::ios_base::in);
+		sourcePos = startPos;
+		start();
+		return pos_type(off_type(-1));
+	}
+	startPos = sourcePos = target;
+	start();
+	return pos;
+}
+
+ReadAheadBuffer::pos_type ReadAheadBuffer::seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which)
+{
+	if (!(which & std::ios_base::in))
+		return pos_type(off_type(-1));
+	if (way == std::ios_base::beg)
+		return seekpos(pos_type(off),which);
+	if (way == std::ios_base::cur) {
+		// tellg
+		if (off == 0)
+			return pos_type(position());
+		return seekpos(pos_type(position() + off),which);
+	}
+	// relative to the end, only the source knows where that is.
+	stop();
+	pos_type r = source->pubseekoff(off,way,std::ios_base::in);
+	if (r == pos_type(off_type(-1)))
+		source->pubseekpos(startPos,std::ios_base::in);
+	else
+		startPos = r;
+	sourcePos = startPos;
+	start();
+	return r;
+}
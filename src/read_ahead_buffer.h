@@ -0,0 +1,123 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * read_ahead_buffer.h
+  *
+  * Header file for the class ReadAheadBuffer.
+  *
+  * A streambuf which reads a file ahead of the consumer in a background thread, so the
+  * conversion thread does not stall on every block read from slow (e.g. network) storage.
+  *
+  */
+
+#ifndef READAHEADBUFFER_H
+#define READAHEADBUFFER_H
+
+#include <streambuf>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "dsf2flac_types.h"
+
+/**
+ * The ReadAheadBuffer sits in front of another streambuf (normally the filebuf of an fstream).
+ * An I/O thread fills a ring of fixed size blocks from the source while the consumer reads from the
+ * oldest full block. Seeking within the blocks already read is cheap; any other seek stops the thread,
+ * repositions the source and starts reading ahead again from there.
+ *
+ * The source must not be used by anyone else while the ReadAheadBuffer exists.
+ *
+ * Process wide counters record how many blocks were handed to consumers and how often (and how long)
+ * a consumer had to wait for the I/O thread.
+ */
+class ReadAheadBuffer : public std::streambuf
+{
+public:
+	static const dsf2flac_uint32 defaultBlockSize = 256*1024; //!< The block size used unless fstreamPlus::setReadAhead is told otherwise.
+	/// Constructor, reads ahead nBlocks blocks of blockSize bytes from the current position of source.
+	ReadAheadBuffer(std::streambuf* source, dsf2flac_uint32 blockSize, dsf2flac_uint32 nBlocks);
+	/// Destructor, stops the I/O thread. The source is left open.
+	virtual ~ReadAheadBuffer();
+
+	/// Returns the number of blocks handed to consumers by all ReadAheadBuffers.
+	static dsf2flac_uint64 getBlockCount() { return blockCount; };
+	/// Returns the number of times a consumer had to wait for the I/O thread.
+	static dsf2flac_uint64 getWaitCount() { return waitCount; };
+	/// Returns the total time consumers spent waiting for the I/O thread (seconds).
+	static dsf2flac_float64 getWaitSeconds() { return waitNanoseconds * 1e-9; };
+protected:
+	// methods overriding streambuf
+	int_type underflow();
+	pos_type seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which = std::ios_base::in);
+	pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in);
+private:
+	/// Starts the I/O thread reading from the current position of the source.
+	void start();
+	/// Stops the I/O thread and throws away everything read ahead.
+	void stop();
+	/// The I/O thread.
+	void readLoop();
+	/// Returns the file position of the next byte the consumer will read.
+	dsf2flac_int64 position();
+private:
+	std::streambuf* source;
+	dsf2flac_uint32 blockSize;
+	dsf2flac_uint32 nBlocks;
+	// the ring of blocks
+	char* data; // nBlocks*blockSize bytes
+	dsf2flac_uint32* blockLength; // bytes in each block
+	dsf2flac_int64* blockStart; // file position of each block
+	dsf2flac_uint32 head; // oldest full block, the one in the get area when holding
+	dsf2flac_uint32 count; // full blocks, including the one being read
+	bool holding; // true if the head block is in the get area
+	bool endOfSource;
+	bool stopping;
+	dsf2flac_int64 sourcePos; // file position the I/O thread reads from next
+	dsf2flac_int64 startPos; // position of the next byte when nothing is held
+	std::mutex mutex;
+	std::condition_variable blockFilled;
+	std::condition_variable blockFreed;
+	std::thread thread;
+	// stats
+	static std::atomic<dsf2flac_uint64> blockCount;
+	static std::atomic<dsf2flac_uint64> waitCount;
+	static std::atomic<dsf2flac_uint64> waitNanoseconds;
+};
+
+#endif // READAHEADBUFFER_H
@@ -0,0 +1,227 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dsd_split_test.cpp
+  *
+  * Runs dsf2flac (given by the DSF2FLAC environment variable) to copy the tracks of a marked up
+  * DSDIFF file into DSF and DFF files, checking that each holds exactly the samples between its
+  * markers, so that played one after the other they give back the input without gaps. Also checks
+  * that DST output isn't split (each DST file is padded to a whole frame) and keeps the markers.
+  *
+  */
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "dsdiff_file_reader.h"
+#include "dsdiff_file_writer.h"
+#include "dsf_file_reader.h"
+#include "test_signal.h"
+
+static char testFile[] = "dsd_split_test.dff";
+static const dsf2flac_uint32 samplingFreq = 2822400;
+static const dsf2flac_uint32 numChannels = 2;
+static const dsf2flac_uint32 frameLen = samplingFreq/8/75; // bytes per channel in a DST frame
+/// Where the tracks start (and the last one ends) in bytes per channel, away from any block or frame boundary.
+static const dsf2flac_uint64 trackBytes[] = {0, 10003, 25001, 40000};
+static const dsf2flac_uint32 numTracks = 3;
+
+/// Appends a big endian number to a chunk being built up.
+template<typename T> static void appendBigEndian(std::vector<dsf2flac_uint8>& chunk, T x)
+{
+	for (int i = sizeof(T) - 1; i >= 0; i--)
+		chunk.push_back((dsf2flac_uint8)(x >> 8*i));
+}
+
+/// Appends a chunk header and the data (padded to an even length).
+static void appendChunk(std::vector<dsf2flac_uint8>& chunk, const char* ident, const std::vector<dsf2flac_uint8>& data)
+{
+	chunk.insert(chunk.end(),ident,ident + 4);
+	appendBigEndian<dsf2flac_uint64>(chunk,data.size());
+	chunk.insert(chunk.end(),data.begin(),data.end());
+	if (data.size() % 2)
+		chunk.push_back(0);
+}
+
+/// A DIIN chunk with a track start marker at each track and a track stop marker at the end.
+static std::vector<dsf2flac_uint8> makeDiinChunk()
+{
+	std::vector<dsf2flac_uint8> diin;
+	for (dsf2flac_uint32 n = 0; n <= numTracks; n++) {
+		std::vector<dsf2flac_uint8> data;
+		appendBigEndian<dsf2flac_uint16>(data,0); // hours
+		appendBigEndian<dsf2flac_uint8>(data,0); // minutes
+		appendBigEndian<dsf2flac_uint8>(data,0); // seconds
+		appendBigEndian<dsf2flac_uint32>(data,trackBytes[n]*8); // samples
+		appendBigEndian<dsf2flac_int32>(data,0); // offset
+		appendBigEndian<dsf2flac_uint16>(data,n < numTracks ? 0 : 1); // TrackStart or TrackStop
+		appendBigEndian<dsf2flac_uint16>(data,0); // all channels
+		appendBigEndian<dsf2flac_uint16>(data,0); // track flags
+		appendBigEndian<dsf2flac_uint32>(data,0); // no text
+		appendChunk(diin,"MARK",data);
+	}
+	std::vector<dsf2flac_uint8> chunk;
+	appendChunk(chunk,"DIIN",diin);
+	return chunk;
+}
+
+static dsf2flac_uint8 reverseBits(dsf2flac_uint8 b)
+{
+	dsf2flac_uint8 r = 0;
+	for (int k = 0; k < 8; k++)
+		r |= ((b >> k) & 1) << (7-k);
+	return r;
+}
+
+/// Runs dsf2flac with the arguments, returning true if it succeeds.
+static bool runDsf2flac(const std::string& args)
+{
+	const char* exe = getenv("DSF2FLAC");
+	std::string cmd = std::string(exe ? exe : "../src/dsf2flac") + " " + args + " > /dev/null";
+	return system(cmd.c_str()) == 0;
+}
+
+/**
+ * Checks that the file holds len samples, the first of which are the input bytes from start.
+ * The bytes from the end of the input to len (the DST padding) must be idle samples.
+ */
+static bool checkFile(DsdSampleReader* r, const char* path, const std::vector<dsf2flac_uint8>& dsd, bool msbFirst,
+	dsf2flac_uint64 start, dsf2flac_uint64 end, dsf2flac_uint64 len)
+{
+	if (!r->isValid()) {
+		fprintf(stderr,"%s: %s\n",path,r->getErrorMsg().c_str());
+		return false;
+	}
+	if (r->getLength() != (dsf2flac_int64)len*8) {
+		fprintf(stderr,"%s: length is %lld samples, expected %llu\n",path,(long long)r->getLength(),(unsigned long long)len*8);
+		return false;
+	}
+	bool reverse = r->msbIsPlayedFirst() != msbFirst;
+	for (dsf2flac_uint64 i = 0; i < len; i++) {
+		r->step();
+		for (dsf2flac_uint32 c = 0; c < numChannels; c++) {
+			dsf2flac_uint8 b = r->getBuffer()[c][0];
+			if (start + i < end ? (reverse ? reverseBits(b) : b) != dsd[(start + i)*numChannels + c] : b != r->getIdleSample()) {
+				fprintf(stderr,"%s: byte %llu of channel %u differs from the input\n",path,(unsigned long long)i,c);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+int main()
+{
+	dsf2flac_uint64 len = trackBytes[numTracks];
+	DsdiffFileWriter w(testFile,samplingFreq,numChannels,false);
+	if (!w.isValid()) {
+		fprintf(stderr,"%s\n",w.getErrorMsg().c_str());
+		return 1;
+	}
+	bool msbFirst = w.msbIsPlayedFirst();
+	std::vector<dsf2flac_uint8> dsd = makeTestDsd(samplingFreq,numChannels,len,msbFirst);
+	w.setDiinChunk(makeDiinChunk());
+	if (!w.write(dsd.data(),dsd.size()) || !w.close()) {
+		fprintf(stderr,"%s\n",w.getErrorMsg().c_str());
+		return 1;
+	}
+
+	// the reader's track boundaries must be the markers
+	DsdiffFileReader in(testFile);
+	if (!in.isValid() || in.getNumTracks() != numTracks) {
+		fprintf(stderr,"%s: expected %u tracks\n",testFile,numTracks);
+		return 1;
+	}
+	for (dsf2flac_uint32 n = 0; n < numTracks; n++) {
+		if (in.getTrackStart(n) != trackBytes[n]*8 || in.getTrackEnd(n) != trackBytes[n+1]*8 - 1) {
+			fprintf(stderr,"track %u is %llu to %llu\n",n+1,(unsigned long long)in.getTrackStart(n),(unsigned long long)in.getTrackEnd(n));
+			return 1;
+		}
+	}
+
+	// each track file holds exactly its own samples
+	int errors = 0;
+	const char* formats[] = {"dsf","dff"};
+	for (const char* format : formats) {
+		std::string outFile = std::string("dsd_split_test_out.") + format;
+		if (!runDsf2flac(std::string("-i ") + testFile + " -O " + format + " -o " + outFile)) {
+			fprintf(stderr,"dsf2flac failed to write the %s tracks\n",format);
+			errors++;
+			continue;
+		}
+		for (dsf2flac_uint32 n = 0; n < numTracks; n++) {
+			std::string trackFile = "track " + std::to_string(n+1) + " - " + outFile;
+			std::vector<char> path(trackFile.begin(),trackFile.end());
+			path.push_back('\0');
+			DsdSampleReader* r;
+			if (format == formats[0])
+				r = new DsfFileReader(path.data());
+			else
+				r = new DsdiffFileReader(path.data());
+			if (!checkFile(r,trackFile.c_str(),dsd,msbFirst,trackBytes[n],trackBytes[n+1],trackBytes[n+1] - trackBytes[n]))
+				errors++;
+			delete r;
+			remove(trackFile.c_str());
+		}
+	}
+
+	// DST output is one file, padded to a whole frame, and keeps the tracks
+	char dstFile[] = "dsd_split_test_out.dst.dff";
+	if (!runDsf2flac(std::string("-i ") + testFile + " -D -L 1 -o " + dstFile)) {
+		fprintf(stderr,"dsf2flac failed to write the DST file\n");
+		errors++;
+	} else {
+		FILE* split = fopen((std::string("track 1 - ") + dstFile).c_str(),"rb");
+		if (split) {
+			fprintf(stderr,"DST output was split into tracks\n");
+			fclose(split);
+			errors++;
+		}
+		DsdiffFileReader dst(dstFile);
+		if (!checkFile(&dst,dstFile,dsd,msbFirst,0,len,(len + frameLen - 1)/frameLen*frameLen))
+			errors++;
+		else if (dst.getNumTracks() != numTracks || dst.getTrackEnd(numTracks-1) != len*8 - 1) {
+			fprintf(stderr,"%s: the markers weren't kept\n",dstFile);
+			errors++;
+		}
+		remove(dstFile);
+	}
+	remove(testFile);
+	return errors ? 1 : 0;
+}
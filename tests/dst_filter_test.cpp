@@ -0,0 +1,100 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dst_filter_test.cpp
+  *
+  * Checks the status update of the DST decoder's prediction filter (LT_UPDATE_STATUS, which is SSE2
+  * on x86) against the scalar version and against the bit history it stands for, running the filter
+  * (LT_RUN_FILTER_I) on both statuses over random tables and bits.
+  *
+  */
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include "libdstdec/dst_fram_filter.h"
+
+static const int numTables = 200; // random filter tables tried
+static const int bitsPerTable = 4096; // random bits run through each
+
+int main()
+{
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<int> coef(-32768,32767);
+	int16_t table[16][256];
+	uint8_t status[16] __attribute__ ((aligned (16)));
+	uint8_t scalarStatus[16] __attribute__ ((aligned (16)));
+	uint8_t history[128]; // the last 128 bits, newest first
+	int errors = 0;
+	for (int t = 0; t < numTables && !errors; t++) {
+		for (int i = 0; i < 16; i++)
+			for (int j = 0; j < 256; j++)
+				table[i][j] = coef(rng);
+		// start from the decoder's initial status, 0xaa in every byte
+		memset(status,0xaa,16);
+		memset(scalarStatus,0xaa,16);
+		for (int k = 0; k < 128; k++)
+			history[k] = (k % 8) & 1;
+		for (int n = 0; n < bitsPerTable; n++) {
+			int16_t Predict;
+			LT_RUN_FILTER_I(table, status);
+			int16_t predict = Predict;
+			LT_RUN_FILTER_I(table, scalarStatus);
+			if (predict != Predict) {
+				fprintf(stderr,"table %d bit %d: prediction %d, scalar status gives %d\n",t,n,predict,Predict);
+				errors++;
+				break;
+			}
+			int16_t BitVal = rng() & 1;
+			LT_UPDATE_STATUS(status, BitVal);
+			LT_UPDATE_STATUS_SCALAR(scalarStatus, BitVal);
+			memmove(&history[1],&history[0],127);
+			history[0] = BitVal;
+			uint8_t expected[16];
+			memset(expected,0,16);
+			for (int k = 0; k < 128; k++)
+				expected[k/8] |= history[k] << (k % 8);
+			if (memcmp(status,expected,16) || memcmp(scalarStatus,expected,16)) {
+				fprintf(stderr,"table %d bit %d: status doesn't hold the last 128 bits\n",t,n);
+				errors++;
+				break;
+			}
+		}
+	}
+	return errors ? 1 : 0;
+}
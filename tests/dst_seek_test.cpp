@@ -0,0 +1,158 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * dst_seek_test.cpp
+  *
+  * Checks that seeking a DST coded DSDIFF file (through its DSTI index) leaves the reader just as
+  * stepping there from the start does, and that stepping gives back the DSD data which was coded.
+  *
+  */
+
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include "dsdiff_file_reader.h"
+#include "dsdiff_file_writer.h"
+#include "test_signal.h"
+
+static char testFile[] = "dst_seek_test.dff";
+static const dsf2flac_uint32 samplingFreq = 2822400;
+static const dsf2flac_uint32 numChannels = 2;
+static const dsf2flac_uint32 frameLen = samplingFreq/8/75; // bytes per channel in a DST frame
+
+/// The reader position and the contents of its buffers.
+struct ReaderState {
+	dsf2flac_int64 position;
+	std::vector<dsf2flac_uint8> buffers;
+};
+
+static ReaderState getState(DsdSampleReader* r)
+{
+	ReaderState s;
+	s.position = r->getPosition();
+	for (dsf2flac_uint32 c = 0; c < r->getNumChannels(); c++)
+		s.buffers.insert(s.buffers.end(), r->getBuffer()[c].data(), r->getBuffer()[c].data() + r->getBufferLength());
+	return s;
+}
+
+int main()
+{
+	// a little over 20 frames, so the last one is partly padding
+	dsf2flac_uint64 len = 20*frameLen + frameLen/3;
+	DsdiffFileWriter w(testFile,samplingFreq,numChannels,true);
+	if (!w.isValid()) {
+		fprintf(stderr,"%s\n",w.getErrorMsg().c_str());
+		return 1;
+	}
+	std::vector<dsf2flac_uint8> dsd = makeTestDsd(samplingFreq,numChannels,len,w.msbIsPlayedFirst());
+	if (!w.write(dsd.data(),dsd.size()) || !w.close()) {
+		fprintf(stderr,"%s\n",w.getErrorMsg().c_str());
+		return 1;
+	}
+	if (w.getCodedFrames() == 0) {
+		fprintf(stderr,"no frames were DST coded\n");
+		return 1;
+	}
+
+	DsdiffFileReader stepped(testFile);
+	if (!stepped.isValid()) {
+		fprintf(stderr,"%s\n",stepped.getErrorMsg().c_str());
+		return 1;
+	}
+	// DST frames are all the same length, so the writer pads the last one with silence
+	dsf2flac_uint64 paddedLen = (len + frameLen - 1)/frameLen*frameLen;
+	if (stepped.getLength() != (dsf2flac_int64)paddedLen*8) {
+		fprintf(stderr,"length is %lld samples, expected %llu\n",(long long)stepped.getLength(),(unsigned long long)paddedLen*8);
+		return 1;
+	}
+
+	// the positions to compare: around the frame boundaries and some in the middle of frames
+	std::vector<dsf2flac_int64> positions;
+	for (dsf2flac_uint64 f = 0; f <= paddedLen/frameLen; f++) {
+		dsf2flac_int64 p = f*frameLen*8;
+		for (dsf2flac_int64 d = -8; d <= 8; d += 8)
+			if (p + d >= 0)
+				positions.push_back(p + d);
+		positions.push_back(p + 1234*8);
+	}
+	positions.push_back(paddedLen*8 - 8);
+	std::sort(positions.begin(),positions.end());
+	positions.erase(std::unique(positions.begin(),positions.end()),positions.end());
+	while (positions.back() >= (dsf2flac_int64)paddedLen*8)
+		positions.pop_back();
+
+	// step through, checking the data and noting the state at each position
+	std::vector<ReaderState> states;
+	size_t next = 0;
+	for (dsf2flac_uint64 i = 0; i < paddedLen; i++) {
+		stepped.step();
+		for (dsf2flac_uint32 c = 0; c < numChannels; c++) {
+			if (stepped.getBuffer()[c][0] != (i < len ? dsd[i*numChannels + c] : stepped.getIdleSample())) {
+				fprintf(stderr,"byte %llu of channel %u differs from what was coded\n",(unsigned long long)i,c);
+				return 1;
+			}
+		}
+		if (next < positions.size() && stepped.getPosition() == positions[next]) {
+			states.push_back(getState(&stepped));
+			next++;
+		}
+	}
+	if (states.size() != positions.size()) {
+		fprintf(stderr,"stepping only reached %u of the positions\n",(unsigned)states.size());
+		return 1;
+	}
+
+	// seek to the positions in a mixed up order, forwards and backwards
+	std::vector<size_t> order(positions.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::shuffle(order.begin(),order.end(),std::mt19937(1));
+	DsdiffFileReader seeked(testFile);
+	int errors = 0;
+	for (size_t i : order) {
+		seeked.seek(positions[i]);
+		ReaderState s = getState(&seeked);
+		if (s.position != states[i].position || s.buffers != states[i].buffers) {
+			fprintf(stderr,"seeking to %lld doesn't match stepping there\n",(long long)positions[i]);
+			errors++;
+		}
+	}
+	remove(testFile);
+	return errors ? 1 : 0;
+}
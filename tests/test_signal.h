@@ -0,0 +1,77 @@
+/*
+ * dsf2flac - http://code.google.com/p/dsf2flac/
+ * 
+ * A file conversion tool for translating dsf dsd audio files into
+ * flac pcm audio files.
+ *
+ * Copyright (c) 2013 by respective authors.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * 
+ * Acknowledgments
+ * 
+ * Many thanks to the following authors and projects whose work has greatly
+ * helped the development of this tool.
+ * 
+ * 
+ * Sebastian Gesemann - dsd2pcm (http://code.google.com/p/dsd2pcm/)
+ * SACD Ripper (http://code.google.com/p/sacd-ripper/)
+ * Maxim V.Anisiutkin - foo_input_sacd (http://sourceforge.net/projects/sacddecoder/files/)
+ * Vladislav Goncharov - foo_input_sacd_hq (http://vladgsound.wordpress.com)
+ * Jesus R - www.sonore.us
+ * 
+ */
+
+ /**
+  * test_signal.h
+  *
+  * Helpers shared by the tests: made up DSD data which DST codes like real music would.
+  *
+  */
+
+#ifndef TEST_SIGNAL_H
+#define TEST_SIGNAL_H
+
+#include <vector>
+#include <cmath>
+#include "dsf2flac_types.h"
+
+/**
+ * Returns len bytes per channel of interleaved DSD: a first order sigma-delta modulation of a sine
+ * on each channel (a different frequency on each). msbFirst gives the order the samples are packed in.
+ */
+inline std::vector<dsf2flac_uint8> makeTestDsd(dsf2flac_uint32 samplingFreq, dsf2flac_uint32 numChannels, dsf2flac_uint64 len, bool msbFirst)
+{
+	std::vector<dsf2flac_uint8> dsd(len*numChannels);
+	for (dsf2flac_uint32 c = 0; c < numChannels; c++) {
+		dsf2flac_float64 w = 2*M_PI*(1000.0 + 250.0*c)/samplingFreq;
+		dsf2flac_float64 acc = 0;
+		dsf2flac_uint64 n = 0;
+		for (dsf2flac_uint64 i = 0; i < len; i++) {
+			dsf2flac_uint8 b = 0;
+			for (int k = 0; k < 8; k++, n++) {
+				acc += 0.5*sin(w*n);
+				int bit = acc >= 0;
+				acc -= bit ? 1 : -1;
+				b |= bit << (msbFirst ? 7-k : k);
+			}
+			dsd[i*numChannels + c] = b;
+		}
+	}
+	return dsd;
+}
+
+#endif // TEST_SIGNAL_H